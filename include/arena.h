@@ -0,0 +1,46 @@
+// Bump allocator for data that only lives until the end of a generation.
+//
+// Allocations are carved out of the current block, growing the arena appends
+// a block. arena_reset releases every allocation at once by moving the cursor
+// back to the start of the first block, O(1) as long as the generation fitted
+// in it. Otherwise the blocks are merged into one block as large as their sum:
+// the arena is presized from the footprint of the previous generations, and
+// after a few of them a reset never calls malloc or free.
+//
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include "types.h"
+
+#define ARENA_ALIGN 64 // Cache line, allocations don't share lines
+#define ARENA_MIN_BLOCK (64 * 1024)
+
+typedef struct ArenaBlock {
+  struct ArenaBlock *next;
+  u64 size; // Bytes of data
+  u64 used; // Bytes handed out
+  _Alignas(ARENA_ALIGN) u8 data[];
+} ArenaBlock;
+
+typedef struct Arena {
+  ArenaBlock *blocks; // Current block first, NULL until the first allocation
+  u64 capacity;       // Bytes of every block
+  u64 used;           // Bytes handed out since the last reset
+  u64 alloc_nb;       // Allocations since the last reset
+  f64 time;           // Time spent in malloc & free since the last reset (s)
+
+  u64 last_used;     // used, alloc_nb & time of the last generation, saved by
+  u64 last_alloc_nb; // arena_reset
+  f64 last_time;
+} Arena;
+
+// A zeroed Arena is a valid empty arena
+void arena_free(Arena *self);
+// size bytes aligned on ARENA_ALIGN, valid until the next arena_reset. Never
+// returns NULL
+void *arena_alloc(Arena *self, u64 size);
+// Releases every allocation
+void arena_reset(Arena *self);
+
+#endif // !_ARENA_H_
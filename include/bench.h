@@ -0,0 +1,38 @@
+// Headless benchmark, run with
+// `gol --bench [size] [generations] [threads] [rule] [engine] [workload]`.
+//
+// Steps a random size x size soup with the tiled engine on 1, 2, 4... up to
+// threads workers (all hardware threads by default) and reports the speedup
+// over a single thread. Every run must end on the same universe, the checksum
+// of the final alive cells is compared to the single threaded one. The rule
+// (see rule_parse) is Conway's Life by default. engine is tiled, states,
+// bounded (a torus, see bitgrid.h), sparse (its shards, see sparse.h, count
+// the candidates they evaluate as cells) or list (single threaded, counts its
+// alive cells), multi-state rules always run on the states engine.
+//
+// workload is soup, or gliders: BENCH_GLIDER_NB gliders facing random ways
+// scattered over the size x size square, a sparse pattern far larger than
+// its population.
+//
+// After each generation, the cells of a BENCH_VIEW_WIDTH x BENCH_VIEW_HEIGHT
+// view in the middle of the soup are extracted like the render buffers are,
+// timed apart from the generations.
+//
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "types.h"
+
+#define BENCH_DEFAULT_SIZE 2048
+#define BENCH_DEFAULT_GENERATIONS 100
+#define BENCH_VIEW_WIDTH 256
+#define BENCH_VIEW_HEIGHT 144
+#define BENCH_GLIDER_NB 20000
+
+typedef enum BenchWorkload { bench_soup, bench_gliders } BenchWorkload;
+
+// argv doesn't include --bench. Returns EXIT_SUCCESS or EXIT_FAILURE
+i32 bench_run(i32 argc, char *argv[]);
+
+#endif // !_BENCH_H_
@@ -0,0 +1,78 @@
+// Bounded universe in a flat bit array.
+//
+// The universe is the width x height cells (x, y) with 0 <= x < width and
+// 0 <= y < height, width being a multiple of TILE_SIZE. A row is width /
+// TILE_SIZE u64 words (bit x of word j is the cell TILE_SIZE * j + x), rows
+// follow each other in one cache line aligned array per generation.
+//
+// A generation is a sweep of bands of TILE_SIZE rows, one pool task per band,
+// each TILE_SIZE columns of a band going through the tile kernel (see
+// kernel.h) like a tile. Edges only change where the halo rows & words are
+// read from, so nothing is wrapped cell by cell:
+// - plane: cells past the edges are dead,
+// - torus: the opposite edge is read instead,
+// - Klein bottle: the opposite edge too, mirrored (x -> width - 1 - x) past
+//   the top & bottom edges.
+//
+
+#ifndef _BITGRID_H_
+#define _BITGRID_H_
+
+#include "cellset.h"
+#include "pool.h"
+#include "rule.h"
+#include "tile.h"
+#include "types.h"
+#include <stdbool.h>
+
+#define BITGRID_MAX_SIZE (1u << 16) // Largest width or height in cells
+
+typedef enum BitGridTopology {
+  bitgrid_plane,
+  bitgrid_torus,
+  bitgrid_klein,
+  bitgrid_topology_count
+} BitGridTopology;
+
+typedef struct BitGrid {
+  BitGridTopology topology;
+  u32 width, height; // In cells, width is a multiple of TILE_SIZE
+  u32 words;         // Words per row
+  u32 band_nb;       // Bands of TILE_SIZE rows, the last one may be shorter
+  u64 *bits[2];      // Current & next generations, see BitGrid.phase
+  u32 phase;         // bits[phase] holds the current generation
+  u64 population;    // Number of alive cells
+  u64 hash;          // Zobrist hash of the words of bits[phase]
+  Rule rule;         // Zeroed: Conway's Life
+  u64 *band_population; // Alive cells of each band
+  u64 *band_hash;       // Zobrist hash of the words of each band
+
+  u64 cells_computed; // Cells swept last step, the whole universe
+  f64 compute_time;   // Time spent computing bands last step (s)
+} BitGrid;
+
+typedef void (*BitGridCellFn)(void *ctx, i32 x, i32 y);
+
+// Starts empty. width has to be a multiple of TILE_SIZE, width & height up to
+// BITGRID_MAX_SIZE
+void bitgrid_create(BitGrid *self, BitGridTopology topology, u32 width,
+                    u32 height);
+// A zeroed BitGrid can be freed
+void bitgrid_free(BitGrid *self);
+
+bool bitgrid_contains(const BitGrid *self, i32 x, i32 y);
+// Cells out of the universe are dead
+bool bitgrid_get_cell(const BitGrid *self, i32 x, i32 y);
+// Cells out of the universe are ignored
+void bitgrid_set_cell(BitGrid *self, i32 x, i32 y, bool alive);
+// Bands are computed in parallel on pool (NULL: on the calling thread)
+void bitgrid_step(BitGrid *self, ThreadPool *pool);
+// Only calls fn for cells within rect
+void bitgrid_foreach_cell(const BitGrid *self, CellRect rect,
+                          BitGridCellFn fn, void *ctx);
+
+const char *bitgrid_topology_name(BitGridTopology topology);
+// Returns false if name doesn't match any topology
+bool bitgrid_topology_from_name(const char *name, BitGridTopology *topology);
+
+#endif // !_BITGRID_H_
@@ -0,0 +1,55 @@
+// Sorted list universe.
+//
+// Alive cells are an array of coordinates sorted row by row, then by x: no
+// hashing, a generation is one linear pass over the list. Each output row
+// merges the rows above, at and below it, sweeping x over the cells of the
+// three rows and their neighbours. The next generation comes out sorted, so
+// cost only depends on the number of alive cells, never on how far apart
+// they are.
+//
+// Edits go to a small CellSet overlay, radix sorted & merged into the list
+// at the next step. A migration from another engine hands out cells in any
+// order, and is sorted in O(n) that way.
+//
+
+#ifndef _CELLLIST_H_
+#define _CELLLIST_H_
+
+#include "arena.h"
+#include "cellset.h"
+#include "rule.h"
+#include "types.h"
+#include <stdbool.h>
+
+// Biased (y, x): unsigned order is row-major order
+typedef u64 ListKey;
+
+typedef struct CellList {
+  ListKey *cells[2]; // Current & next generations, sorted
+  u64 count;         // Cells of cells[phase]
+  u64 capacity[2];   // Keys cells[p] can hold
+  u32 phase;         // cells[phase] holds the current generation
+  CellSet edits;     // Cells edited since the last step (cellset_key) ->
+                     // whether they are alive
+  u64 population;    // Number of alive cells, edits included
+  u64 hash;          // Zobrist hash of the alive cells, the same as the
+                     // sparse engine's
+  Rule rule;         // Zeroed: Conway's Life
+} CellList;
+
+typedef void (*ListCellFn)(void *ctx, i32 x, i32 y);
+
+void celllist_free(CellList *self);
+
+bool celllist_get_cell(const CellList *self, i32 x, i32 y);
+void celllist_set_cell(CellList *self, i32 x, i32 y, bool alive);
+// Scratch comes from arena
+void celllist_step(CellList *self, Arena *arena);
+// Bounding box of the alive cells, false if there are none. Cells edited
+// dead since the last step still count
+bool celllist_bounds(const CellList *self, CellRect *rect);
+// Only calls fn for cells within rect
+void celllist_foreach_cell(const CellList *self, CellRect rect, ListCellFn fn,
+                           void *ctx);
+
+#endif // !_CELLLIST_H_
@@ -0,0 +1,138 @@
+// Open addressing hash set of cells keyed by packed integer coordinates.
+//
+// Swiss table layout: every slot has one control byte holding either EMPTY,
+// DELETED or the 7 low bits of the key hash (h2). Lookups hash the key once,
+// then probe whole groups of CELLSET_GROUP_WIDTH control bytes, comparing h2
+// against the group in a single SIMD (or SWAR) operation. Keys are only
+// compared for the few slots whose h2 matches.
+//
+// Each slot also carries a u32 value (e.g. a neighbour count while computing a
+// cycle). It is left untouched by the set itself.
+//
+
+#ifndef _CELLSET_H_
+#define _CELLSET_H_
+
+#include "types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#define CELLSET_GROUP_WIDTH 16
+#else
+#define CELLSET_GROUP_WIDTH 8
+#endif
+
+typedef u64 CellKey; // Packed cell coordinates: x in high 32 bits, y in low
+
+typedef struct CellSet {
+  i8 *ctrl;        // One control byte per slot
+  CellKey *keys;   // Slot keys, valid only where ctrl is full
+  u32 *values;     // Slot values, valid only where ctrl is full
+  u64 capacity;    // Number of slots, power of 2 (0 until first insert)
+  u64 count;       // Number of cells in the set
+  u64 growth_left; // Inserts left before a rehash (tombstones consume it)
+} CellSet;
+
+typedef struct CellRect {
+  i32 min_x, min_y, max_x, max_y; // Inclusive bounds
+} CellRect;
+
+#define CELLRECT_ALL                                                           \
+  ((CellRect){.min_x = INT32_MIN,                                              \
+              .min_y = INT32_MIN,                                              \
+              .max_x = INT32_MAX,                                              \
+              .max_y = INT32_MAX})
+
+static inline bool cellrect_contains(CellRect rect, i32 x, i32 y) {
+  return rect.min_x <= x && x <= rect.max_x && rect.min_y <= y &&
+         y <= rect.max_y;
+}
+
+// Whether (x, y), e.g. the neighbour of a 32-bit cell, is a 32-bit cell
+static inline bool cellset_within(i64 x, i64 y) {
+  return x >= INT32_MIN && x <= INT32_MAX && y >= INT32_MIN && y <= INT32_MAX;
+}
+
+// Cells of the engine API & hashlife, which aren't limited to 32 bits
+typedef struct CellRect64 {
+  i64 min_x, min_y, max_x, max_y; // Inclusive bounds
+} CellRect64;
+
+#define CELLRECT64_ALL                                                         \
+  ((CellRect64){.min_x = INT64_MIN,                                            \
+                .min_y = INT64_MIN,                                            \
+                .max_x = INT64_MAX,                                            \
+                .max_y = INT64_MAX})
+
+static inline bool cellrect64_contains(CellRect64 rect, i64 x, i64 y) {
+  return rect.min_x <= x && x <= rect.max_x && rect.min_y <= y &&
+         y <= rect.max_y;
+}
+
+static inline bool cellrect64_is_empty(CellRect64 rect) {
+  return rect.min_x > rect.max_x || rect.min_y > rect.max_y;
+}
+
+// Part of rect with 32-bit coordinates, empty if there is none
+static inline CellRect64 cellrect64_clip32(CellRect64 rect) {
+  rect.min_x = rect.min_x > INT32_MIN ? rect.min_x : INT32_MIN;
+  rect.min_y = rect.min_y > INT32_MIN ? rect.min_y : INT32_MIN;
+  rect.max_x = rect.max_x < INT32_MAX ? rect.max_x : INT32_MAX;
+  rect.max_y = rect.max_y < INT32_MAX ? rect.max_y : INT32_MAX;
+  return rect;
+}
+
+// rect has to be clipped
+static inline CellRect cellrect64_narrow(CellRect64 rect) {
+  return (CellRect){.min_x = (i32)rect.min_x,
+                    .min_y = (i32)rect.min_y,
+                    .max_x = (i32)rect.max_x,
+                    .max_y = (i32)rect.max_y};
+}
+
+static inline CellKey cellset_key(i32 x, i32 y) {
+  return ((u64)(u32)x << 32) | (u64)(u32)y;
+}
+
+static inline i32 cellset_key_x(CellKey key) { return (i32)(u32)(key >> 32); }
+
+static inline i32 cellset_key_y(CellKey key) { return (i32)(u32)key; }
+
+// Zobrist key of a cell (splitmix64 finalizer): the XOR of the keys of the
+// alive cells hashes a universe, and is updated by XORing births & deaths
+static inline u64 cellset_zobrist(CellKey key) {
+  key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+  key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+  return key ^ (key >> 31);
+}
+
+// A zeroed CellSet is a valid empty set, no create function is needed
+void cellset_free(CellSet *self);
+void cellset_clear(CellSet *self);
+void cellset_reserve(CellSet *self, u64 count);
+
+bool cellset_contains(const CellSet *self, CellKey key);
+// Returns a pointer to the value of key, NULL if absent. Invalidated by the
+// next insertion
+u32 *cellset_get(const CellSet *self, CellKey key);
+// Inserts key with value if absent. Returns a pointer to the (new or existing)
+// value. Invalidated by the next insertion
+u32 *cellset_insert(CellSet *self, CellKey key, u32 value);
+// Same for a key known to be absent, e.g. when building a set out of another
+// one: skips the lookup
+u32 *cellset_insert_new(CellSet *self, CellKey key, u32 value);
+// Returns true if key was in the set
+bool cellset_erase(CellSet *self, CellKey key);
+
+// Bulk variants: reserve once, then prefetch ahead while walking keys
+void cellset_insert_bulk(CellSet *self, const CellKey *keys, u64 n);
+u64 cellset_erase_bulk(CellSet *self, const CellKey *keys, u64 n);
+
+// Index of the first full slot >= slot, capacity if none. Iterate with:
+//   for (u64 i = cellset_next(s, 0); i < s->capacity;
+//        i = cellset_next(s, i + 1))
+u64 cellset_next(const CellSet *self, u64 slot);
+
+#endif // !_CELLSET_H_
@@ -0,0 +1,220 @@
+// Generation engines.
+//
+// An Engine owns the universe in one of several representations and knows how
+// to compute the next generation. Switching kind migrates the cell states to
+// the new representation. Engines don't depend on raylib: cells are handed out
+// through a callback.
+//
+
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+
+#include "arena.h"
+#include "bitgrid.h"
+#include "celllist.h"
+#include "cellset.h"
+#include "hashlife.h"
+#include "history.h"
+#include "islands.h"
+#include "pool.h"
+#include "rule.h"
+#include "sparse.h"
+#include "statemap.h"
+#include "tile.h"
+#include "types.h"
+#include <stdbool.h>
+
+typedef enum EngineKind {
+  engine_sparse,   // Hash sets of alive cells & their neighbourhoods sharded
+                   // by region, 9 probes per birth or death
+  engine_tiled,    // Bit-packed 64x64 tiles, 64 cells per SWAR operation
+  engine_hashlife, // Memoized quadtree, 2^step_exp generations per step
+  engine_states,   // Byte per cell 64x64 tiles, the only one for multi-state
+                   // & range R rules (Generations, Wireworld, Larger than
+                   // Life)
+  engine_list,     // Sorted array of alive cells, a linear merge of rows per
+                   // generation whatever their extent
+  engine_islands,  // Clusters of cells too far apart to interact, each a
+                   // sorted array stepped in parallel with the others
+  engine_bounded,  // Flat bit array of a width x height plane, torus or Klein
+                   // bottle, entered through engine_set_bounds
+  engine_kind_count
+} EngineKind;
+
+// Automatic switching
+//
+// Every ENGINE_AUTO_INTERVAL generations, an automatic engine measures its
+// population and fill (alive cells per occupied 64x64 tile) and migrates to
+// the kind that suits them best, between two steps:
+// - engine_hashlife as long as step_exp isn't 0, only it skips generations,
+//   or cells are within ENGINE_AUTO_EDGE of the 32-bit edge, where the plane
+//   of other kinds ends. Edits there check at the next step
+// - engine_tiled for dense patterns, a tile costs the same whatever its fill
+// - engine_list for large sparse ones, it only depends on the population
+// - engine_sparse for small ones
+// Each kind is entered past a threshold and left below half of it, so a
+// pattern sitting on a threshold doesn't migrate back and forth.
+// Multi-state rules stay on engine_states and bounded universes on
+// engine_bounded.
+//
+
+#define ENGINE_AUTO_INTERVAL 64
+#define ENGINE_AUTO_TILED_FILL 24.0   // Cells per tile to enter engine_tiled
+#define ENGINE_AUTO_LIST_POPULATION 512 // Cells to enter engine_list
+#define ENGINE_AUTO_EDGE (1 << 16) // Cells from the 32-bit edge, far more than
+                                   // patterns travel between two checks
+
+typedef struct EngineAuto {
+  bool enabled;
+  u64 next_check; // Generation of the next measure
+  u64 population; // Measured at the last check
+  u64 tile_nb;    // Occupied tiles at the last check
+  f64 fill;       // population / tile_nb
+  bool at_edge;   // Cells were within ENGINE_AUTO_EDGE of the 32-bit edge
+
+  u64 switch_nb;         // Migrations since automatic switching was enabled
+  EngineKind from;       // Kind the last migration left
+  u64 switch_generation; // Generation of the last migration
+  f64 migration_time;    // Time the last migration took (s)
+} EngineAuto;
+
+// Escaping spaceships
+//
+// Soups throw gliders & other spaceships away, which keep the population and
+// the extent of the universe growing for nothing. Every ENGINE_ESCAPE_INTERVAL
+// generations, an engine removing escapes splits its cells into clusters (see
+// islands_label) and steps each cluster of at most ENGINE_ESCAPE_MAX_CELLS
+// cells on its own: clusters back to their shape, shifted, within
+// ENGINE_ESCAPE_MAX_PERIOD generations are spaceships. Spaceships past the
+// box of the other clusters by ENGINE_ESCAPE_MARGIN cells, and moving away
+// from it, are counted and removed. The rest of the pattern only grows up to
+// one cell per generation: it won't catch the slower ships of Life.
+// Unbounded two-state universes only.
+//
+
+#define ENGINE_ESCAPE_INTERVAL 64
+#define ENGINE_ESCAPE_MAX_CELLS 32
+#define ENGINE_ESCAPE_MAX_PERIOD 4
+#define ENGINE_ESCAPE_MARGIN 32
+
+// Spaceships of Life, others are told apart by their speed & size
+typedef enum EngineShip {
+  engine_ship_glider, // c/4 diagonal, 5 cells
+  engine_ship_lwss,   // c/2 orthogonal, 9 cells at least
+  engine_ship_mwss,   // c/2 orthogonal, 11 cells at least
+  engine_ship_hwss,   // c/2 orthogonal, 13 cells at least
+  engine_ship_other,
+  engine_ship_count
+} EngineShip;
+
+typedef struct EngineEscape {
+  bool enabled;
+  u64 next_check;                 // Generation of the next check
+  u64 ship_nb[engine_ship_count]; // Removed since enabled, by kind
+  u64 cell_nb;                    // Cells of the removed ships
+  u64 last_generation;            // Generation of the last removal
+} EngineEscape;
+
+typedef void (*EngineCellFn)(void *ctx, i64 x, i64 y);
+typedef void (*EngineStateFn)(void *ctx, i64 x, i64 y, u8 state);
+
+typedef struct Engine {
+  EngineKind kind;
+  SparseMap sparse; // engine_sparse: alive cells
+  TileMap tiles;    // engine_tiled: alive cells
+  HashLife life;    // engine_hashlife: alive cells
+  StateMap states;  // engine_states: cell states
+  CellList list;    // engine_list: alive cells
+  IslandMap islands; // engine_islands: alive cells
+  BitGrid grid;     // engine_bounded: alive cells
+  u32 step_exp;     // engine_hashlife: a step is 2^step_exp generations,
+                    // others always step one generation
+  ThreadPool *pool; // Not owned, runs engine_tiled & engine_states tiles,
+                    // engine_bounded bands, engine_sparse shards and
+                    // engine_islands islands. NULL: single thread
+  Rule rule;        // Zeroed: Conway's Life
+  Arena arena;      // Scratch of the step being computed, reset after each
+                    // step
+  const char *store_dir; // Not owned, engine_tiled: directory of the file
+                         // the rows of the tiles are mapped from, NULL: they
+                         // stay in memory (see tilemap_map)
+  u64 store_budget;      // engine_tiled: bytes of rows kept resident
+
+  u64 generation;  // Generations computed since the start
+  History history; // Hashes of the last steps, cleared by edits & switches
+  EngineAuto automatic; // See Automatic switching, kept by migrations
+  EngineEscape escape;  // See Escaping spaceships, kept by migrations
+} Engine;
+
+// A zeroed Engine is a valid empty sparse engine
+void engine_free(Engine *self);
+// Cell states are kept (see engine_kind_contains), kind has to support the
+// rule. Switching to engine_bounded goes through engine_set_bounds, switching
+// from it makes the universe unbounded
+void engine_set_kind(Engine *self, EngineKind kind);
+// Switches to engine_bounded, the rule has to be a two-state one. Cells out of
+// the bounds (see bitgrid.h) are dropped
+void engine_set_bounds(Engine *self, BitGridTopology topology, u32 width,
+                       u32 height);
+// The kind follows the pattern from the next step on, see Automatic switching
+void engine_set_automatic(Engine *self, bool enabled);
+// Escaping spaceships are removed from the next step on, the report starts
+// over
+void engine_set_escape(Engine *self, bool enabled);
+// Maps the tiles of engine_tiled to a file in dir from now on, at most budget
+// bytes of them resident (0: the OS decides), see tilepool.h. Returns an
+// error if no file can be created in dir
+void engine_set_store(Engine *self, const char *dir, u64 budget, Error *err);
+// Only engine_states runs multi-state rules
+bool engine_kind_supports(EngineKind kind, Rule rule);
+// Cells are 64-bit, but only engine_hashlife goes past 32 bits (up to
+// HASHLIFE_MAX_COORD): cells out of the range of a kind read as empty, and are
+// dropped when set or migrated to it. The plane of other kinds ends at the
+// 32-bit edge, no cell is born past it (see Automatic switching)
+bool engine_kind_contains(EngineKind kind, i64 x, i64 y);
+
+// Returns the number of generations computed, 0 if the universe can't grow
+// any further (see hashlife_step). Each step is recorded in the history, see
+// engine_cycle
+u64 engine_step(Engine *self);
+// Computes exactly generations generations, whatever step_exp is, unless
+// time_budget (s) runs out first, a cycle is found or the universe can't grow
+// any further. At least one step is always attempted. Returns the number of
+// generations computed
+u64 engine_step_n(Engine *self, u64 generations, f64 time_budget);
+void engine_set_step_exp(Engine *self, u32 step_exp);
+// Takes effect on the next step, cells are kept. Switches to engine_states if
+// the kind doesn't support rule, an engine_bounded universe becoming unbounded
+void engine_set_rule(Engine *self, Rule rule);
+// A cell is alive if its state isn't 0
+bool engine_get_cell(const Engine *self, i64 x, i64 y);
+void engine_set_cell(Engine *self, i64 x, i64 y, bool alive);
+u8 engine_get_state(const Engine *self, i64 x, i64 y);
+// Two-state kinds only keep whether state is 0
+void engine_set_state(Engine *self, i64 x, i64 y, u8 state);
+// Puts the next state of the rule in the cell, see rule_edit_next
+void engine_toggle_cell(Engine *self, i64 x, i64 y);
+// Number of non-empty cells
+u64 engine_population(const Engine *self);
+// Hash of the alive cells, each kind hashes its own way: Zobrist hashes updated
+// on births & deaths of cells (engine_sparse & engine_list, which hash the
+// same way), rows (engine_tiled) or words
+// (engine_bounded), content hash of the quadtree (engine_hashlife), rows of
+// states (engine_states). It only depends on the cell states
+u64 engine_hash(const Engine *self);
+// Returns true if the universe is static (period 1) or periodic since the last
+// edit. period is a multiple of 2^step_exp for engine_hashlife
+bool engine_cycle(const Engine *self, u64 *period, u64 *cycle_start);
+// Only calls fn for cells within rect, CELLRECT64_ALL for every cell
+void engine_foreach_cell(const Engine *self, CellRect64 rect, EngineCellFn fn,
+                         void *ctx);
+// Same with the state of non-empty cells, always 1 for two-state kinds
+void engine_foreach_state(const Engine *self, CellRect64 rect,
+                          EngineStateFn fn, void *ctx);
+
+const char *engine_kind_name(EngineKind kind);
+// Returns false if name doesn't match any engine
+bool engine_kind_from_name(const char *name, EngineKind *kind);
+const char *engine_ship_name(EngineShip ship);
+
+#endif // !_ENGINE_H_
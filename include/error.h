@@ -1,6 +1,8 @@
 #ifndef _ERROR_H_
 #define _ERROR_H_
 
+#include <stdbool.h>
+
 #define error_to_str_literal(s) _error_to_str_literal_(s)
 #define _error_to_str_literal_(s) #s
 
@@ -7,9 +7,14 @@
 #include "sds.h"
 #pragma GCC diagnostic pop
 
+#include "bench.h"
+#include "engine.h"
 #include "error.h"
 #include "fifo.h"
+#include "kernel.h"
 #include "layout.h"
+#include "pool.h"
+#include "render.h"
 #include "types.h"
 #include <math.h>
 #include <raylib.h>
@@ -32,54 +37,133 @@
 #define GOL_INITIAL_SCREEN_HEIGHT 720.0
 #define GOL_INITIAL_GRID_WIDTH 50.0
 #define GOL_INITIAL_CYCLE_PERIOD 1000
+#define GOL_INITIAL_ENGINE engine_sparse
 
 #define GOL_ALIVE_CELL_SIZE_RATIO 0.9f
 
 #define GOL_GRID_COLOR LIGHTGRAY
 #define GOL_HOVER_COLOR DARKGREEN
-
-typedef u32 Count;
-
-typedef struct GolCellMap {
-  Vector2 key; // Cell Corrdinates
-  Count value; // Neighbour count (only when updating, else not used)
-} GolCellMap;
+#define GOL_BOUNDS_COLOR MAROON // Edges of a bounded universe
+#define GOL_ALIVE_COLOR BLACK // State 1, dying states fade out
+#define GOL_WIREWORLD_HEAD_COLOR BLUE
+#define GOL_WIREWORLD_TAIL_COLOR RED
+#define GOL_WIREWORLD_CONDUCTOR_COLOR ORANGE
 
 typedef enum GolCctState {
   gol_cct_quit,
   gol_cct_error,
   gol_cct_compute,
   gol_cct_toggle_cell,
-  gol_cct_toggle_play
+  gol_cct_toggle_play,
+  gol_cct_set_engine,
+  gol_cct_set_kernel,
+  gol_cct_set_step_exp,
+  gol_cct_set_view,
+  gol_cct_step,
+  gol_cct_set_rule,
+  gol_cct_set_escape
 } GolCctState;
 
+// Integer cell coordinates, exact anywhere in the universe of the engine.
+// Only differences to the camera cell are converted to floats, to draw
+typedef struct GolCell {
+  i64 x, y;
+} GolCell;
+
+// Engine figures for the debug panel, copied by the CCT with each render
+// buffer, under buffer_index_mtx: the main thread never reads the engine
+typedef struct GolStats {
+  EngineKind kind;
+  Rule rule;
+  u64 population;
+  u64 pool_count, pool_capacity, pool_bytes; // Tile pool of the tiled kind
+  KernelKind kernel;                         // See kernel_select
+  f64 kernel_rate;                           // Mcells/s, tiled kinds only
+  u64 active_nb, tile_nb;                    // Active & allocated tiles
+  u64 node_nb;                               // HashLife nodes
+  u64 period, cycle_start;                   // See engine_cycle
+  u64 arena_used, arena_alloc_nb;            // Step arena, last generation
+  f64 arena_time;
+  EngineAuto automatic;
+  bool store; // Tile rows are in a file store, see engine_set_store
+  u64 bits_resident, bits_bytes, bits_evicted_nb;
+  u64 island_nb, merge_nb, split_nb;
+  EngineEscape escape;
+} GolStats;
+
 // Use to send pointers from GolCtx members to Cycle Computation Thread (CCT)
 typedef struct GolCctArgs {
   Fifo *fifo;
-  GolCellMap **alive_cells; // Array of alive cells on the grid. R/W
-  Vector2 **alive_cells_render_buffer_1; // Write
-  Vector2 **alive_cells_render_buffer_2; // Write
-  i32 *buffer_index;                     // Write
+  Engine *engine; // Alive cells on the grid & how to compute cycles. R/W
+  RenderBuffer *render_buffer_1; // Write
+  RenderBuffer *render_buffer_2; // Write
+  i32 *buffer_index;             // Write
+  GolStats *stats;               // Write, under buffer_index_mtx
   mtx_t *buffer_index_mtx; // Prevents CCT to change index when main thread
                            // renders alive cells
   i32 *cycle_period;       // Time in ms between two cycles. Read Only
   f64 *cycle_compute_time; // Time to compute a lifecycle. R/W
-  u64 *cycle_nb;           // Number of cycle since start. R/W
+  u64 *cycle_nb;           // Number of generations since start. R/W
+  u64 *steps_left;         // Generations left to compute as fast as
+                           // possible. R/W
+  bool *play;              // Plays a cycle each cycle_period. R/W
+  bool *autopause;         // Pause when a cycle is found. Read Only
 } GolCctArgs;
 
 typedef struct GolMsgDataToggle {
-  Vector2 cell_coord;
+  GolCell cell_coord;
 } GolMsgDataToggle;
 
+typedef struct GolMsgDataEngine {
+  EngineKind kind;
+  bool automatic; // kind is ignored, the engine picks it
+} GolMsgDataEngine;
+
+typedef struct GolMsgDataKernel {
+  KernelKind kind;
+} GolMsgDataKernel;
+
+typedef struct GolMsgDataStepExp {
+  u32 step_exp;
+} GolMsgDataStepExp;
+
+typedef struct GolMsgDataStep {
+  u64 generations; // Generations to compute as fast as possible
+} GolMsgDataStep;
+
+typedef struct GolMsgDataRule {
+  Rule rule;
+} GolMsgDataRule;
+
+typedef struct GolMsgDataEscape {
+  bool enabled; // Remove escaping spaceships, see engine_set_escape
+} GolMsgDataEscape;
+
+typedef struct GolMsgDataView {
+  CellRect64 view; // Cells to put in the render buffer
+} GolMsgDataView;
+
+// Command line options, see gol_parse_options
+typedef struct GolOptions {
+  bool bounded; // --plane, --torus or --klein WIDTHxHEIGHT, see bitgrid.h
+  BitGridTopology topology;
+  u32 width, height;
+  const char *store_dir; // --store DIR, see engine_set_store. NULL: none
+  u64 store_budget;      // --store-budget MB, in bytes. 0: the OS decides
+} GolOptions;
+
 typedef struct GolCtx {
   bool close;
+  GolOptions options;
 
   Rectangle screen;     // Screen bounds
   Rectangle g_screen;   // Game screen bounds
   Rectangle dbg_screen; // Debug screen bounds
-  Vector2 cam_pos; // "Camera" position relative to the world, considered at the
-                   // top left corner of g_screen
-  Vector2 velocity; // Camera velocity
+  GolCell cam_cell;    // "Camera" position: cell at the top left corner of
+                       // g_screen
+  Vector2 cam_offset;  // Pixels of cam_cell left of & above that corner, in
+                       // [0, cell_size)
+  Vector2 velocity;    // Camera velocity, in pixels
 
   bool is_cmd_mode;
   bool process_cmd;
@@ -89,22 +173,28 @@ typedef struct GolCtx {
   f32 cell_size;  // Width (and height) of a cell
 
   bool mouse_on_g_screen;   // Is mouse in g_screen bounds
-  Vector2 mouse_cell_coord; // Coordinates of the cell under cursor
+  GolCell mouse_cell_coord; // Coordinates of the cell under cursor
 
-  bool play; // If true, plays Game Of Life rules each GOL_CELL_UPDATE_PERIOD
+  u32 step_exp;         // A cycle computes 2^step_exp generations (hashlife)
+  CellRect64 render_view; // Cells the CCT puts in the render buffer, larger
+                          // than the visible cells so it isn't sent every
+                          // frame
 
-  thrd_t cct;    // Cycle Computation Thread (CCT)
-  Fifo cct_fifo; // Cycle Computation Thread fifo
+  thrd_t cct;      // Cycle Computation Thread (CCT)
+  Fifo cct_fifo;   // Cycle Computation Thread fifo
+  ThreadPool pool; // Workers computing tiles, only driven by the CCT
 
   // These have their adresses shared with the Cycle Computation Thread (CCT)
   //
-  GolCellMap *alive_cells; // Array of alive cells on the grid. Main Thread Read
-                           // Only (except at init)
-  Vector2 *alive_cells_render_buffer_1;
-  Vector2 *alive_cells_render_buffer_2; // Two cells buffers. When one is
-                                        // being built, the other one is used
-                                        // for rendering. Main Thread Read Only
+  Engine engine; // Alive cells on the grid & how to compute cycles. Only
+                 // touched by the main thread before & after the CCT
+  RenderBuffer render_buffer_1;
+  RenderBuffer render_buffer_2; // Two cells buffers. When one is being
+                                   // built, the other one is used for
+                                   // rendering. Main Thread Read Only
   i32 buffer_index;       // Which buffer to render. Main Thread Read Only
+  GolStats stats;         // Engine figures of the rendered buffer. Main
+                          // Thread Read Only, under buffer_index_mtx
   mtx_t buffer_index_mtx; // Prevents CCT to change index when main thread
                           // renders alive cells
   i32 cycle_period;       // Time in ms between two cycles. CCT Read Only
@@ -112,8 +202,14 @@ typedef struct GolCtx {
                           // Thread Read Only
   f64 cycle_compute_time; // Time to compute a lifecycle. Main
                           // Thread Read Only
-  u64 cycle_nb;           // Number of cycle since start. Main
+  u64 cycle_nb;           // Number of generations since start. Main
                           // Thread Read Only
+  u64 steps_left;         // Generations left to compute as fast as
+                          // possible (:step). Main Thread Read Only
+  bool play; // If true, plays Game Of Life rules each cycle_period. Main
+             // Thread Read Only, toggled by the CCT (paused on cycles)
+  bool autopause; // Pause (and drop the steps left) when the universe
+                  // becomes static or periodic. CCT Read Only
 
   bool show_dbg; // Shoul show debug info ?
 } GolCtx;
@@ -121,20 +217,28 @@ typedef struct GolCtx {
 int gol_run(GolCtx *self, int argc, char *argv[]);
 void gol_run_loop(GolCtx *self, Error *err);
 
-void gol_init(GolCtx *self, Error *err);
+// Returns false if argv[1..argc) isn't a valid set of options
+bool gol_parse_options(int argc, char *argv[], GolOptions *options);
+void gol_init(GolCtx *self, const GolOptions *options, Error *err);
 
 void gol_event(GolCtx *self, Error *err);
-void gol_update(GolCtx *self);
+void gol_update(GolCtx *self, Error *err);
+void gol_process_cmd(GolCtx *self, Error *err);
+void gol_update_view(GolCtx *self, Error *err);
+void gol_send_step(GolCtx *self, u64 generations, Error *err);
+void gol_send_step_exp(GolCtx *self, u32 step_exp, Error *err);
 
 i32 gol_cct(void *arg);
-void gol_cct_upddate_render_buffer(GolCctArgs *args,
-                                   const GolCellMap *alive_cells, Error *err);
+void gol_cct_upddate_render_buffer(GolCctArgs *args, const Engine *engine,
+                                   CellRect64 view, Error *err);
 
 void gol_draw(GolCtx *self, Error *err);
 void gol_draw_grid(const GolCtx *self);
 void gol_draw_cells(GolCtx *self, Error *err);
+void gol_draw_bounds(const GolCtx *self);
+Color gol_state_color(Rule rule, u8 state);
 void gol_draw_hovered_cell(const GolCtx *self);
-void gol_draw_dbg(const GolCtx *self);
+void gol_draw_dbg(GolCtx *self, Error *err);
 
 int gol_deinit(GolCtx *self, Error *err);
 
@@ -0,0 +1,80 @@
+// HashLife quadtree engine.
+//
+// The universe is a quadtree of canonical nodes: a node at level k is a
+// 2^k x 2^k square made of 4 level k-1 children, level 0 nodes being the dead
+// and the alive cell. Nodes are hash consed, so equal squares are the same
+// node and a node's future only has to be computed once: the result of a level
+// k node (its centre 2^(k-1) square, 2^min(step_exp, k-2) generations later)
+// is memoized in the node.
+//
+// Nodes unreachable from the root are reclaimed by a mark & sweep garbage
+// collection once the store holds more than gc_threshold nodes.
+//
+
+#ifndef _HASHLIFE_H_
+#define _HASHLIFE_H_
+
+#include "cellset.h"
+#include "rule.h"
+#include "types.h"
+#include <stdbool.h>
+
+#define HASHLIFE_MAX_LEVEL 62         // Keeps cell coordinates within i64
+// Cells are within [-HASHLIFE_MAX_COORD, HASHLIFE_MAX_COORD)^2, stepping
+// stops once they grow past it: a step needs them in the centre eighth of the
+// root, which then never goes past HASHLIFE_MAX_LEVEL
+#define HASHLIFE_MAX_COORD (1ll << (HASHLIFE_MAX_LEVEL - 4))
+#define HASHLIFE_MAX_STEP_EXP 48      // Up to 2^48 generations per step
+#define HASHLIFE_GC_THRESHOLD 4000000 // Nodes before the first collection
+
+typedef u32 HlNodeId;
+
+typedef struct HlNode {
+  HlNodeId nw, ne, sw, se; // Children, unused at level 0
+  HlNodeId next;           // Hash chain, free list once reclaimed
+  HlNodeId result;         // Memoized result, HASHLIFE_NONE if not computed
+  u64 population;          // Number of alive cells
+  u64 hash;                // Content hash, independent of node ids
+  u8 level;                // Node is a 2^level square
+  bool marked;             // Garbage collection mark
+} HlNode;
+
+typedef struct HashLife {
+  HlNode *nodes;       // Node store, indexed by HlNodeId
+  HlNodeId *buckets;   // Hash table heads, power of 2
+  u64 bucket_nb;       // Number of buckets
+  HlNodeId free_list;  // Reclaimed nodes, chained through next
+  u64 node_nb;         // Nodes in use
+  u64 gc_threshold;    // Collect when node_nb goes past it
+  HlNodeId empty[HASHLIFE_MAX_LEVEL + 1]; // Empty node of each level, lazily
+  HlNodeId root;       // Universe, centred on (0, 0)
+  u32 step_exp;        // A step advances 2^step_exp generations
+  Rule rule;           // Zeroed: Conway's Life
+} HashLife;
+
+typedef void (*HashLifeCellFn)(void *ctx, i64 x, i64 y);
+
+void hashlife_free(HashLife *self);
+
+bool hashlife_get_cell(const HashLife *self, i64 x, i64 y);
+// x & y have to be within HASHLIFE_MAX_COORD
+void hashlife_set_cell(HashLife *self, i64 x, i64 y, bool alive);
+// Advances 2^step_exp generations, returns the number of generations: 0 once
+// cells have grown past HASHLIFE_MAX_COORD (by up to 2^step_exp cells)
+u64 hashlife_step(HashLife *self);
+void hashlife_set_step_exp(HashLife *self, u32 step_exp);
+// Forgets every memoized result
+void hashlife_set_rule(HashLife *self, Rule rule);
+u64 hashlife_population(const HashLife *self);
+// Hash of the universe in O(level), from the content hashes of the nodes. It
+// doesn't depend on how far the root was expanded, but isn't a Zobrist hash
+u64 hashlife_universe_hash(const HashLife *self);
+// Only walks the branches of the tree that intersect rect
+void hashlife_foreach_cell(const HashLife *self, CellRect64 rect,
+                           HashLifeCellFn fn, void *ctx);
+// Alive cells in rect, only walks the branches of the tree crossing its edges
+u64 hashlife_population_in(const HashLife *self, CellRect64 rect);
+
+void hashlife_gc(HashLife *self);
+
+#endif // !_HASHLIFE_H_
@@ -0,0 +1,44 @@
+// Recent universe hashes, to detect when the universe becomes static or
+// periodic.
+//
+// The last HISTORY_SIZE hashes are kept in a ring buffer, indexed by hash in a
+// CellSet. A hash seen twice (with the same population, so a collision is even
+// less likely) closes a cycle: its period is the number of generations between
+// both, and it starts at the first one. Periods up to HISTORY_SIZE steps are
+// found as soon as the first repetition happens.
+//
+
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include "cellset.h"
+#include "types.h"
+#include <stdbool.h>
+
+#define HISTORY_SIZE 4096 // Steps remembered
+
+typedef struct HistoryEntry {
+  u64 hash;
+  u64 population;
+  u64 generation;
+} HistoryEntry;
+
+typedef struct History {
+  HistoryEntry *entries; // Ring buffer of HISTORY_SIZE entries
+  u32 next;              // Slot of the next entry
+  u32 count;             // Entries in use
+  CellSet index;         // Hash -> slot of its last occurrence
+
+  u64 period;      // Generations between two identical universes, 0 if none
+  u64 cycle_start; // First generation of the cycle
+} History;
+
+// A zeroed History is a valid empty history
+void history_free(History *self);
+// Forgets every entry and the cycle found, when the universe is edited
+void history_clear(History *self);
+// Records the universe of generation. Returns true on the first repetition
+// since the last clear, period & cycle_start are then set
+bool history_push(History *self, u64 hash, u64 population, u64 generation);
+
+#endif // !_HISTORY_H_
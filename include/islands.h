@@ -0,0 +1,75 @@
+// Island universe.
+//
+// Alive cells are split into islands, each a sorted list of its own (see
+// celllist.h) with its bounding box. Two cells only affect each other's next
+// generation when at most ISLANDS_GAP - 1 empty rows or columns separate
+// them, a cell between them seeing both: islands whose boxes are further
+// apart evolve independently, and are stepped in parallel, each worker with
+// its own scratch arena. A soup throwing gliders and debris away ends up as
+// one island per fragment, each list small enough to stay in cache, instead
+// of one list spanning them all.
+//
+// After each step, islands whose boxes came within ISLANDS_GAP of each other
+// are merged. Every ISLANDS_SPLIT_INTERVAL steps, islands are split into
+// their connected components (cells ISLANDS_GAP apart at most), components
+// whose boxes are too close staying together.
+//
+
+#ifndef _ISLANDS_H_
+#define _ISLANDS_H_
+
+#include "arena.h"
+#include "celllist.h"
+#include "cellset.h"
+#include "pool.h"
+#include "rule.h"
+#include "types.h"
+#include <stdbool.h>
+
+#define ISLANDS_GAP 2 // Empty rows or columns keeping islands apart
+#define ISLANDS_SPLIT_INTERVAL 64
+
+typedef struct Island {
+  CellList cells;
+  CellRect box; // Holds the alive cells, may be larger after edits
+} Island;
+
+typedef struct IslandMap {
+  Island *islands; // Dynamic array, cells of two islands more than
+                   // ISLANDS_GAP apart
+  Arena *arenas;   // Dynamic array, scratch of each pool worker
+  u64 step_nb;     // Steps since the start
+  u64 merge_nb;    // Islands merged since the start
+  u64 split_nb;    // Islands split off since the start
+  Rule rule;       // Zeroed: Conway's Life, see islands_set_rule
+} IslandMap;
+
+typedef void (*IslandCellFn)(void *ctx, i32 x, i32 y);
+
+// Labels keys with their connected component, cells at most ISLANDS_GAP
+// apart being connected, from 0 in order of their first cell. Returns the
+// number of components, scratch comes from arena
+u32 islands_label(const CellKey *keys, u32 key_nb, u32 *labels, Arena *arena);
+
+void islands_free(IslandMap *self);
+void islands_set_rule(IslandMap *self, Rule rule);
+
+bool islands_get_cell(const IslandMap *self, i32 x, i32 y);
+// A birth out of every box makes an island, merged with the ones it comes
+// close to
+void islands_set_cell(IslandMap *self, i32 x, i32 y, bool alive);
+// Makes keys alive at once: each connected component of keys (see
+// islands_label) makes an island, then islands that meet are merged, instead
+// of looking every cell up. Scratch comes from arena
+void islands_add_cells(IslandMap *self, const CellKey *keys, u32 key_nb,
+                       Arena *arena);
+// Islands are stepped in parallel on pool (NULL: on the calling thread)
+void islands_step(IslandMap *self, ThreadPool *pool);
+u64 islands_population(const IslandMap *self);
+// Zobrist hash of the alive cells, the same as the sparse engine's
+u64 islands_hash(const IslandMap *self);
+// Only calls fn for cells within rect
+void islands_foreach_cell(const IslandMap *self, CellRect rect,
+                          IslandCellFn fn, void *ctx);
+
+#endif // !_ISLANDS_H_
@@ -0,0 +1,55 @@
+// Tile generation kernels.
+//
+// The same bit-parallel full adder network is compiled for several vector
+// widths, each lane of a vector computing one tile row: scalar (1 row), SSE2
+// (2 rows), AVX2 (4 rows) and AVX-512 (8 rows). The binary is built without
+// -march, the best kernel the CPU supports is picked at runtime by
+// kernel_init(). The scalar one is the reference and can always be selected.
+//
+// Each width has a kernel hard-wired for Conway's Life, one evaluating any
+// Life-like rule through its lookup table, branch free (see rule.h), one
+// evaluating the 512 entry table of isotropic rules as a multiplexer tree over
+// the 9 cells of the neighbourhood, and byte per cell kernels for multi-state &
+// Larger than Life rules.
+//
+
+#ifndef _KERNEL_H_
+#define _KERNEL_H_
+
+#include "rule.h"
+#include "types.h"
+#include <stdbool.h>
+
+typedef enum KernelKind {
+  kernel_scalar,
+  kernel_sse2,
+  kernel_avx2,
+  kernel_avx512,
+  kernel_kind_count
+} KernelKind;
+
+// Detects CPU features and selects the best kernel. Call once at startup
+void kernel_init(void);
+bool kernel_supported(KernelKind kind);
+KernelKind kernel_best(void);
+// Returns false (and keeps the current kernel) if kind isn't supported
+bool kernel_select(KernelKind kind);
+KernelKind kernel_selected(void);
+
+const char *kernel_name(KernelKind kind);
+// Returns false if name doesn't match any kernel
+bool kernel_from_name(const char *name, KernelKind *kind);
+
+// Computes the next generation of the TILE_SIZE rows of a tile with the
+// selected kernel. mid holds the TILE_HALO_SIZE rows of the tile column (halo
+// rows first and last), left and right the words west and east of each of
+// them.
+void kernel_tile(Rule rule, const u64 *mid, const u64 *left, const u64 *right,
+                 u64 *out);
+// Computes the next states of the TILE_SIZE x TILE_SIZE cells of a tile, row
+// by row. heads holds the flags (0 or 1) of the cells in state 1 of the tile
+// and a rule_range(rule) cells border around it, (TILE_SIZE + 2 * range)^2
+// bytes.
+void kernel_state_tile(Rule rule, const u8 *heads, const u8 *cells, u8 *out);
+
+#endif // !_KERNEL_H_
@@ -0,0 +1,68 @@
+// Morton (Z-order) codes of 2D coordinates.
+//
+// The code of (x, y) interleaves their bits, x in the even bits and y in the
+// odd ones, coordinates being biased so that signed order is kept. Sorting
+// codes walks the plane quadrant by quadrant, recursively: coordinates close
+// to each other mostly get close codes.
+//
+// The codes of the points of a rectangle all lie between the codes of its
+// top-left & bottom-right corners, with gaps where the curve leaves the
+// rectangle. A sorted array of codes is walked over a rectangle by jumping
+// over those gaps with BIGMIN (Tropf & Herzog), the smallest code past a gap
+// that is back in the rectangle, found in one pass over the bits.
+//
+
+#ifndef _MORTON_H_
+#define _MORTON_H_
+
+#include "cellset.h"
+#include "types.h"
+
+#define MORTON_X_BITS 0x5555555555555555ull
+#define MORTON_Y_BITS 0xAAAAAAAAAAAAAAAAull
+
+typedef void (*MortonFn)(void *ctx, i32 x, i32 y);
+
+// Bits of v at even positions
+static inline u64 morton_spread(u32 v) {
+  u64 bits = v;
+  bits = (bits | bits << 16) & 0x0000FFFF0000FFFFull;
+  bits = (bits | bits << 8) & 0x00FF00FF00FF00FFull;
+  bits = (bits | bits << 4) & 0x0F0F0F0F0F0F0F0Full;
+  bits = (bits | bits << 2) & 0x3333333333333333ull;
+  return (bits | bits << 1) & MORTON_X_BITS;
+}
+
+// Even bits of bits, packed
+static inline u32 morton_compact(u64 bits) {
+  bits &= MORTON_X_BITS;
+  bits = (bits | bits >> 1) & 0x3333333333333333ull;
+  bits = (bits | bits >> 2) & 0x0F0F0F0F0F0F0F0Full;
+  bits = (bits | bits >> 4) & 0x00FF00FF00FF00FFull;
+  bits = (bits | bits >> 8) & 0x0000FFFF0000FFFFull;
+  return (u32)(bits | bits >> 16);
+}
+
+static inline u64 morton_encode(i32 x, i32 y) {
+  return morton_spread((u32)x ^ 0x80000000u) |
+         morton_spread((u32)y ^ 0x80000000u) << 1;
+}
+
+static inline i32 morton_x(u64 code) {
+  return (i32)(morton_compact(code) ^ 0x80000000u);
+}
+
+static inline i32 morton_y(u64 code) {
+  return (i32)(morton_compact(code >> 1) ^ 0x80000000u);
+}
+
+// Smallest code > code whose point is in the rectangle of corners min & max
+// (codes of its top-left & bottom-right points), code being out of it and
+// between both
+u64 morton_bigmin(u64 code, u64 min, u64 max);
+// Calls fn in Z-order for the points of the sorted codes[0, n) within rect.
+// Codes out of rect cost a binary search per gap, not one step each
+void morton_foreach(const u64 *codes, u64 n, CellRect rect, MortonFn fn,
+                    void *ctx);
+
+#endif // !_MORTON_H_
@@ -0,0 +1,59 @@
+// Work-stealing thread pool.
+//
+// pool_run executes tasks [0, task_nb) in parallel and returns once they are
+// all done, the calling thread being worker 0. Each worker starts with a
+// contiguous range of tasks and takes them one by one from its front; a worker
+// running out of tasks steals the back half of another worker's range.
+//
+// Tasks must not depend on the order they run in: which worker runs a task
+// changes from run to run, so a deterministic result only requires each task
+// to write its own outputs.
+//
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include "error.h"
+#include "types.h"
+#include <stdbool.h>
+#include <threads.h>
+
+#define POOL_MAX_THREADS 256
+#define POOL_CACHE_LINE 64
+
+typedef void (*PoolTaskFn)(void *ctx, u32 worker, u32 task);
+
+typedef struct PoolWorker {
+  _Alignas(POOL_CACHE_LINE) mtx_t mtx; // Protects begin & end
+  u32 begin, end;                      // Tasks left to this worker
+  u32 index;                           // Worker index, 0 is the caller
+  struct ThreadPool *pool;
+} PoolWorker;
+
+typedef struct ThreadPool {
+  u32 thread_nb;       // Workers, including the calling thread
+  thrd_t *threads;     // thread_nb - 1 threads
+  PoolWorker *workers; // thread_nb workers
+
+  mtx_t mtx;    // Protects everything below
+  cnd_t start;  // Signaled when a job is posted or on quit
+  cnd_t done;   // Signaled when the last worker is done
+  u64 job;      // Incremented for each job
+  u32 busy;     // Threads still working on the current job
+  bool quit;    // Threads must exit
+  PoolTaskFn fn;
+  void *ctx;
+} ThreadPool;
+
+// Number of hardware threads, 1 if unknown
+u32 pool_hardware_threads(void);
+
+// thread_nb == 0: one worker per hardware thread
+void pool_create(ThreadPool *self, u32 thread_nb, Error *err);
+void pool_destroy(ThreadPool *self);
+
+// A NULL pool runs every task on the calling thread
+void pool_run(ThreadPool *self, u32 task_nb, PoolTaskFn fn, void *ctx);
+u32 pool_thread_nb(const ThreadPool *self);
+
+#endif // !_POOL_H_
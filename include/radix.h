@@ -0,0 +1,16 @@
+// LSD radix sort of u64 keys, 8 bits per pass.
+//
+// One pass counts the 8 byte histograms, then each byte position scatters the
+// keys between keys & tmp. Byte positions where every key is the same are
+// skipped: keys that only differ in their low bytes cost few passes.
+//
+
+#ifndef _RADIX_H_
+#define _RADIX_H_
+
+#include "types.h"
+
+// Sorts n keys in O(n) with tmp as scratch of n keys
+void radix_sort(u64 *keys, u64 *tmp, u64 n);
+
+#endif // !_RADIX_H_
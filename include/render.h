@@ -0,0 +1,35 @@
+// Render buffers.
+//
+// The CCT copies the cells in view out of the engine into a render buffer,
+// which the main thread draws while the CCT fills the other one. Cells are
+// sorted by state, so each state is drawn in one run of the same colour:
+// two-state rules are a single run, other rules are counted state by state
+// first, then pushed at the end of their state's run (a counting sort).
+//
+
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+#include "cellset.h"
+#include "engine.h"
+#include "rule.h"
+#include "types.h"
+
+// Integer cell coordinates, exact anywhere in the universe of the engine
+typedef struct RenderCell {
+  i64 x, y;
+} RenderCell;
+
+typedef struct RenderBuffer {
+  RenderCell *cells; // Dynamic array, cells of state s are
+                     // [ends[s - 1], ends[s])
+  u32 ends[RULE_MAX_STATES + 1]; // ends[0] is 0
+  Rule rule;                     // Rule the states belong to
+} RenderBuffer;
+
+void render_buffer_free(RenderBuffer *self);
+// Replaces the cells of self with the cells of engine within view
+void render_buffer_fill(RenderBuffer *self, const Engine *engine,
+                        CellRect64 view);
+
+#endif // !_RENDER_H_
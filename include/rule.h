@@ -0,0 +1,151 @@
+// Cellular automaton rules.
+//
+// Life-like rules are written in B/S notation. A rule is two 9 bit masks
+// indexed by the number of alive neighbours: bit n of birth is set if a dead
+// cell with n alive neighbours becomes alive, bit n of survival if an alive one
+// stays alive. The masks are the lookup table engines evaluate: bit tests for
+// the sparse engine & hashlife, a branchless bit-sliced multiplexer tree in the
+// tile kernels (see kernel.h).
+//
+// Isotropic non-totalistic rules are written in Hensel notation: a count can be
+// restricted to some shapes of its neighbours, e.g. B2-a/S12 (2e: N & E, 2a:
+// N & NE...). They are compiled into a lookup table of the 512 neighbourhoods
+// of a cell instead of the masks, which every engine with a 3x3 neighbourhood
+// evaluates, and Generations rules can use too (B2-a/S12/C3).
+//
+// Multi-state rules are only run by engine_states, a cell being a state from 0
+// (empty) to rule_states() - 1:
+// - Generations (B/S/C): alive cells (state 1) that don't survive go through
+//   the dying states 2 to C - 1 before being empty. Only alive cells count as
+//   neighbours and dying cells can't be born again.
+// - Wireworld: electron heads (1) become tails (2), tails become conductors
+//   (3), conductors become heads next to 1 or 2 heads.
+// - Larger than Life (R../C../M../S..../B..../NM): Generations over the
+//   (2R + 1)^2 Moore neighbourhood, births & survivals are ranges of counts
+//   rather than masks. M1 counts the cell itself. R is at most RULE_MAX_RANGE
+//   so a tile only reads the 8 adjacent ones.
+// In every family the neighbours that matter are in state 1.
+//
+// B0 rules are rejected: every empty cell of the infinite plane would be born.
+//
+
+#ifndef _RULE_H_
+#define _RULE_H_
+
+#include "types.h"
+#include <stdbool.h>
+
+#define RULE_STR_SIZE 80    // Hensel B & S parts are up to 34 characters
+#define RULE_MAX_STATES 255 // Generations rules with more states are rejected
+#define RULE_MAX_RANGE 64   // TILE_SIZE
+
+// Neighbourhood of a cell: bit (dy + 1) * 3 + dx + 1 is set if the cell at
+// (x + dx, y + dy) is alive, the cell itself is RULE_NEIGHBOURHOOD_CELL
+#define RULE_NEIGHBOURHOODS 512
+#define RULE_NEIGHBOURHOOD_CELL (1u << 4)
+
+#define RULE_WIREWORLD_HEAD 1
+#define RULE_WIREWORLD_TAIL 2
+#define RULE_WIREWORLD_CONDUCTOR 3
+
+typedef enum RuleFamily {
+  rule_life_like,        // Two states, B/S
+  rule_generations,      // B/S/C, C states
+  rule_wireworld,        // 4 states, birth & survival are unused
+  rule_larger_than_life, // R/C/M/S/B, birth & survival are unused
+} RuleFamily;
+
+// A zeroed Rule is Conway's Life (B/S, where every cell dies, isn't useful)
+typedef struct Rule {
+  RuleFamily family;
+  u16 birth;    // Bit n: dead cells with n alive neighbours are born
+  u16 survival; // Bit n: alive cells with n alive neighbours survive
+  u8 states;    // rule_generations: number of states (C), 3 or more.
+                // rule_larger_than_life: C, 0 or 2 for two states
+  u8 range;     // rule_larger_than_life: radius of the neighbourhood (R)
+  bool middle;  // rule_larger_than_life: the cell is one of its neighbours
+  u16 birth_min, birth_max;       // rule_larger_than_life: counts of births
+  u16 survival_min, survival_max; // & survivals, inclusive
+  bool isotropic; // rule_life_like & rule_generations: table replaces the
+                  // masks
+  u64 table[RULE_NEIGHBOURHOODS / 64]; // Bit n: the cell with neighbourhood n
+                                       // is alive next generation
+} Rule;
+
+#define RULE_CONWAY ((Rule){.birth = 1 << 3, .survival = 1 << 2 | 1 << 3})
+
+// Replaces the zeroed Rule by RULE_CONWAY
+static inline Rule rule_resolve(Rule rule) {
+  return rule.family != rule_life_like || rule.birth || rule.survival ||
+                 rule.isotropic
+             ? rule
+             : RULE_CONWAY;
+}
+
+static inline bool rule_is_conway(Rule rule) {
+  rule = rule_resolve(rule);
+  return rule.family == rule_life_like && !rule.isotropic &&
+         rule.birth == RULE_CONWAY.birth &&
+         rule.survival == RULE_CONWAY.survival;
+}
+
+static inline u32 rule_states(Rule rule) {
+  switch (rule.family) {
+  case rule_generations:
+    return rule.states;
+  case rule_wireworld:
+    return 4;
+  case rule_larger_than_life:
+    return rule.states > 2 ? rule.states : 2;
+  default:
+    return 2;
+  }
+}
+
+// Next state of a cell of a Life-like rule, rule must be resolved and not
+// isotropic
+static inline bool rule_next(Rule rule, bool alive, u32 count) {
+  return ((u32)rule.survival << 9 | rule.birth) >> ((u32)alive * 9 + count) &
+         1;
+}
+
+// Next state of the cell with the given neighbourhood, for a Life-like rule
+// (isotropic or not), rule must be resolved
+static inline bool rule_next_neighbourhood(Rule rule, u32 neighbourhood) {
+  if (rule.isotropic) {
+    return rule.table[neighbourhood >> 6] >> (neighbourhood & 63) & 1;
+  }
+  return rule_next(
+      rule, neighbourhood & RULE_NEIGHBOURHOOD_CELL,
+      (u32)__builtin_popcount(neighbourhood & ~RULE_NEIGHBOURHOOD_CELL));
+}
+
+// State a click puts in a cell of the given state: cycles through every state,
+// in the order circuits are drawn for Wireworld (conductor, head, tail)
+static inline u8 rule_edit_next(Rule rule, u8 state) {
+  if (rule.family == rule_wireworld) {
+    static const u8 next[4] = {RULE_WIREWORLD_CONDUCTOR, RULE_WIREWORLD_TAIL,
+                               0, RULE_WIREWORLD_HEAD};
+    return next[state & 3];
+  }
+  return (u8)((state + 1u) % rule_states(rule));
+}
+
+// Radius of the neighbourhood, 1 for every family but Larger than Life
+static inline u32 rule_range(Rule rule) {
+  return rule.family == rule_larger_than_life ? rule.range : 1;
+}
+
+// Parses "B36/S23" (case insensitive, either order), "B2-a/S12" in Hensel
+// notation, "B2/S/C3" for a Generations rule, "R5,C0,M1,S34..58,B34..45,NM" for
+// a Larger than Life one
+// (C & M default to 0, NM to the only neighbourhood supported) or a rule name:
+// life, highlife, daynight, seeds, brain, starwars, wireworld, bosco, majority.
+// Returns false if str isn't a valid rule
+bool rule_parse(const char *str, Rule *rule);
+// Writes the notation of rule in str, at least RULE_STR_SIZE bytes. Hensel
+// letters are listed in canonical order, or the excluded ones after '-' when
+// that's shorter
+void rule_format(Rule rule, char *str);
+
+#endif // !_RULE_H_
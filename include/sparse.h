@@ -0,0 +1,84 @@
+// Sharded hash set universe.
+//
+// Alive cells & the neighbourhoods (see rule.h) of the cells next to them are
+// kept in hash sets from one generation to the next: a birth or death updates
+// the neighbourhoods of its 3x3 cells, which become candidates. Only
+// candidates can change state next step, so a step costs the births & deaths
+// of the last one rather than the population.
+//
+// Shards
+//
+// The plane is cut in SPARSE_REGION_SIZE x SPARSE_REGION_SIZE regions, each
+// owned by one of SPARSE_SHARDS shards (regions hashed to spread a pattern
+// over every shard). A shard only holds the cells, neighbourhoods &
+// candidates of its regions, so shards step in parallel without locks, in
+// two phases:
+// - evaluate: each shard finds the flips (births & deaths) among its
+//   candidates. A flip on the edge of a region also changes neighbourhoods of
+//   the next regions: it is posted to the outboxes of their shards
+// - apply: each shard applies its flips to its cells, then updates its
+//   neighbourhoods from its flips & the ones other shards posted to it
+// Only flips on region edges are exchanged, a few percent of them.
+//
+// Few flips are applied to the alive cells of a shard in place. When they are
+// many, erasing deaths would leave as many tombstones and slow probes &
+// iteration down until the next rehash: the next generation is built into a
+// second set instead, sized for it, then both are swapped.
+//
+
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include "cellset.h"
+#include "pool.h"
+#include "rule.h"
+#include "types.h"
+#include <stdbool.h>
+
+#define SPARSE_SHARD_BITS 4
+#define SPARSE_SHARDS (1u << SPARSE_SHARD_BITS)
+#define SPARSE_REGION_SHIFT 6
+#define SPARSE_REGION_SIZE (1 << SPARSE_REGION_SHIFT)
+// Candidates a step needs to run its shards on the pool, fewer are evaluated
+// faster than the pool wakes up
+#define SPARSE_PARALLEL_CANDIDATES 4096
+
+typedef struct SparseShard {
+  _Alignas(POOL_CACHE_LINE) CellSet cells; // Alive cells
+  CellSet cells_next;     // Spare set busy steps build the next generation
+                          // into, swapped with cells
+  CellSet neighbourhoods; // Neighbourhood of the cells next to alive ones
+  CellKey *candidates;    // Dynamic array of the cells whose neighbourhood
+                          // changed since the last step
+  CellKey *flips;         // Dynamic array, flips of the step being computed
+  CellKey *outbox[SPARSE_SHARDS]; // Dynamic arrays, flips of the step being
+                                  // computed changing neighbourhoods of
+                                  // other shards
+  u64 hash;                       // Zobrist hash of the alive cells
+} SparseShard;
+
+typedef struct SparseMap {
+  SparseShard shards[SPARSE_SHARDS];
+  u64 cells_computed; // Candidates evaluated last step
+  f64 compute_time;   // Time spent stepping shards last step (s)
+  Rule rule;          // Zeroed: Conway's Life, see sparse_set_rule
+} SparseMap;
+
+typedef void (*SparseCellFn)(void *ctx, i32 x, i32 y);
+
+void sparse_free(SparseMap *self);
+// Every neighbourhood is evaluated again at the next step
+void sparse_set_rule(SparseMap *self, Rule rule);
+
+bool sparse_get_cell(const SparseMap *self, i32 x, i32 y);
+void sparse_set_cell(SparseMap *self, i32 x, i32 y, bool alive);
+// Shards are stepped in parallel on pool (NULL: on the calling thread)
+void sparse_step(SparseMap *self, ThreadPool *pool);
+u64 sparse_population(const SparseMap *self);
+// Zobrist hash of the alive cells, the same as CellList's
+u64 sparse_hash(const SparseMap *self);
+// Only calls fn for cells within rect
+void sparse_foreach_cell(const SparseMap *self, CellRect rect, SparseCellFn fn,
+                         void *ctx);
+
+#endif // !_SPARSE_H_
@@ -0,0 +1,84 @@
+// Byte tiled universe for multi-state rules.
+//
+// Same layout as the bit-packed TileMap (see tile.h): TILE_SIZE x TILE_SIZE
+// tiles from a TilePool, indexed by their tile coordinates and computed in
+// parallel on a thread pool. A cell is a byte holding its state, 4KB per
+// generation of a tile, so a row of 64 cells still goes through the kernel in
+// 1 to 4 vector operations.
+//
+// Cells only react to the neighbours in state 1, and cells in a quiescent state
+// (empty, Wireworld conductors) only change next to one. A tile without other
+// states and that no state 1 cell of a neighbour faces already holds its next
+// generation: only tiles with live, dying or Wireworld electron cells and their
+// neighbours are computed.
+//
+// Larger than Life neighbourhoods reach rule_range() cells away: the kernel
+// reads a border that wide from the adjacent tiles, and cells that close to an
+// edge face the neighbours on that side.
+//
+// Tiles are found in a rect through their sorted Morton codes, like TileMap's.
+//
+
+#ifndef _STATEMAP_H_
+#define _STATEMAP_H_
+
+#include "arena.h"
+#include "cellset.h"
+#include "pool.h"
+#include "rule.h"
+#include "tile.h"
+#include "tilepool.h"
+#include "types.h"
+#include <stdbool.h>
+
+typedef struct StateTile {
+  i32 x, y;             // Tile coordinates (cell coordinates >> TILE_SHIFT)
+  u32 population[2];    // Non-empty cells of cells[p]
+  u32 transient[2];     // Cells of cells[p] not in a quiescent state
+  TileBorders heads[2]; // Borders of the cells in state 1 of cells[p], up to
+                        // the range of the rule from the edges
+  u64 hash[2];          // Zobrist hash of the rows of cells[p]
+  bool edited;  // Set by edits & rule changes: the tile has to be computed
+  bool settled; // cells[phase ^ 1] is a copy of cells[phase]
+  bool active;  // Step scratch, has to be computed
+  // Current & next generations, rows start on a cache line
+  _Alignas(POOL_CACHE_LINE) u8 cells[2][TILE_SIZE][TILE_SIZE];
+} StateTile;
+
+typedef struct StateMap {
+  CellSet index;     // Tile coordinates -> index in tiles
+  StateTile **tiles; // Dynamic array of the tiles
+  TilePool tile_pool; // Where tiles live, see tilepool.h
+  u32 phase;         // tiles[i]->cells[phase] holds the current generation
+  u64 population;    // Number of non-empty cells
+  u64 hash;          // Zobrist hash of the rows of the tiles
+  Rule rule;         // Zeroed: Conway's Life
+  u32 *active;       // Step scratch from the arena, indices of the tiles
+                     // to compute
+  u64 *zorder;       // Dynamic array of the sorted Morton codes of the tile
+                     // coordinates
+  bool zorder_stale; // Tiles were added or dropped since zorder was sorted,
+                     // sorted again by the next step
+
+  u64 active_nb;      // Tiles that went through the kernel last step
+  u64 cells_computed; // Cells that went through the kernel last step
+  f64 compute_time;   // Time spent computing tiles last step (s)
+} StateMap;
+
+typedef void (*StateCellFn)(void *ctx, i32 x, i32 y, u8 state);
+
+void statemap_free(StateMap *self);
+// Takes effect on the next step, every tile is computed once
+void statemap_set_rule(StateMap *self, Rule rule);
+
+u8 statemap_get_state(const StateMap *self, i32 x, i32 y);
+void statemap_set_state(StateMap *self, i32 x, i32 y, u8 state);
+// Tiles are computed in parallel on pool (NULL: on the calling thread),
+// scratch comes from arena
+void statemap_step(StateMap *self, ThreadPool *pool, Arena *arena);
+// Only calls fn for non-empty cells within rect, tile by tile in Z-order
+// unless tiles were added since the last step
+void statemap_foreach_cell(const StateMap *self, CellRect rect, StateCellFn fn,
+                           void *ctx);
+
+#endif // !_STATEMAP_H_
@@ -0,0 +1,118 @@
+// Bit-packed tiled universe.
+//
+// The universe is cut in TILE_SIZE x TILE_SIZE tiles, one u64 bitmask per row
+// (bit x of row y is the cell (x, y) of the tile). Tiles are indexed by their
+// tile coordinates in a CellSet whose value is the position in the tiles array.
+//
+// A generation is computed 64 cells at a time with a bit-parallel full adder
+// network (SWAR, see kernel.h), halo rows & columns being read from the 8
+// adjacent tiles. Tiles are independent work units run on a thread pool, the
+// result doesn't depend on the number of threads.
+//
+// Only active tiles are computed. bits[phase ^ 1] holds the generation before
+// the current one, so if a tile and the borders of its 8 neighbours facing it
+// are the same as 2 generations ago, the tile's next generation is the one it
+// already holds in bits[phase ^ 1]: still lifes and period 2 oscillators cost
+// nothing, and other oscillators only wake up neighbours they touch.
+//
+// Tiles live in a TilePool (see tilepool.h): they don't move as tiles come
+// and go, and memory stays flat as patterns travel. Their rows can be kept
+// in a file, paged in as tiles wake up & out once they have been asleep for
+// long, so universes larger than memory run, only slower.
+//
+// The Morton codes of the tiles (see morton.h) are kept sorted, so the tiles
+// in a rect, e.g. the visible part of the universe, are found without going
+// through every tile.
+//
+
+#ifndef _TILE_H_
+#define _TILE_H_
+
+#include "arena.h"
+#include "cellset.h"
+#include "pool.h"
+#include "rule.h"
+#include "tilepool.h"
+#include "types.h"
+#include <stdbool.h>
+
+#define TILE_SHIFT 6
+#define TILE_SIZE (1 << TILE_SHIFT) // Tile width and height in cells
+#define TILE_MASK (TILE_SIZE - 1)
+#define TILE_HALO_SIZE (TILE_SIZE + 2) // Rows with the one above and below
+
+// Whether tile (x, y) holds cells with 32-bit coordinates. The plane of tiled
+// universes ends there: tiles past it are never allocated, births stop at the
+// edge
+static inline bool tile_within(i64 x, i64 y) {
+  return x >= INT32_MIN >> TILE_SHIFT && x <= INT32_MAX >> TILE_SHIFT &&
+         y >= INT32_MIN >> TILE_SHIFT && y <= INT32_MAX >> TILE_SHIFT;
+}
+
+// Bit (dy + 1) * 3 + dx + 1 is set if cells facing the tile (x + dx, y + dy)
+// are alive (or changed), bit 4 if any cell is
+typedef u16 TileBorders;
+#define TILE_BORDERS_ALL 0x1FF
+#define TILE_BORDERS_CENTRE 0x010
+
+// Every step reads the header of every tile, the rows only for active ones &
+// their neighbours: rows live apart, in a pool of their own that can be
+// mapped out of core (see tilepool.h)
+typedef struct Tile {
+  // Tile coordinates (cell coordinates >> TILE_SHIFT). A header fills a
+  // cache line
+  _Alignas(POOL_CACHE_LINE) i32 x;
+  i32 y;
+  u32 population[2];      // Alive cells of bits[p]
+  TileBorders borders[2]; // Borders of bits[p]
+  TileBorders changed[2]; // Where bits[p] differs from 2 generations before
+  u64 hash[2];            // Zobrist hash of the rows of bits[p]
+  bool edited; // Set by tilemap_set_cell: bits[phase] isn't the generation
+               // after bits[phase ^ 1], so it can't be reused
+  bool active; // Step scratch, has to be computed
+  // Current & next generations, see TileMap.phase, from TileMap.bits_pool.
+  // Rows start on a cache line
+  u64 (*bits)[TILE_SIZE];
+} Tile;
+
+typedef struct TileMap {
+  CellSet index;    // Tile coordinates -> index in tiles
+  Tile **tiles;     // Dynamic array of the tiles
+  TilePool tile_pool; // Where tile headers live, see tilepool.h
+  TilePool bits_pool; // Where the rows of the tiles live, see tilemap_map
+  u32 phase;        // tiles[i]->bits[phase] holds the current generation
+  u64 population;   // Number of alive cells
+  u64 hash;         // Zobrist hash of the rows of the tiles
+  Rule rule;        // Zeroed: Conway's Life
+  u32 *active;      // Step scratch from the arena, indices of the tiles
+                    // to compute
+  u64 *zorder;       // Dynamic array of the sorted Morton codes of the tile
+                     // coordinates
+  bool zorder_stale; // Tiles were added or dropped since zorder was sorted,
+                     // sorted again by the next step
+
+  u64 active_nb;      // Tiles that went through the kernel last step
+  u64 cells_computed; // Cells that went through the kernel last step
+  f64 compute_time;   // Time spent computing tiles last step (s)
+} TileMap;
+
+typedef void (*TileCellFn)(void *ctx, i32 x, i32 y);
+
+void tilemap_free(TileMap *self);
+
+// Keeps the rows of the tiles of the empty self in a file created in dir, at
+// most budget bytes of them resident (0: the OS decides), see tilepool.h.
+// They stay in memory if the file can't be created
+void tilemap_map(TileMap *self, const char *dir, u64 budget, Error *err);
+
+bool tilemap_get_cell(const TileMap *self, i32 x, i32 y);
+void tilemap_set_cell(TileMap *self, i32 x, i32 y, bool alive);
+// Tiles are computed in parallel on pool (NULL: on the calling thread),
+// scratch comes from arena
+void tilemap_step(TileMap *self, ThreadPool *pool, Arena *arena);
+// Only calls fn for cells within rect, tile by tile in Z-order unless tiles
+// were added since the last step
+void tilemap_foreach_cell(const TileMap *self, CellRect rect, TileCellFn fn,
+                          void *ctx);
+
+#endif // !_TILE_H_
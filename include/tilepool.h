@@ -0,0 +1,101 @@
+// Slab allocator of tiles.
+//
+// Tiles come out of slabs of TILEPOOL_SLAB_SIZE bytes, cache line aligned, so
+// the rows of a tile start on a cache line & never share one with another
+// tile. A released tile goes to a free list (its first bytes point to the
+// next free tile) and is handed out again by the next allocation: a pattern
+// that keeps allocating & releasing tiles, e.g. a spaceship, reuses the same
+// slabs instead of growing the heap. Tiles never move, pointers to them stay
+// valid until they are released.
+//
+// Tiles are only allocated & released between steps, on the thread that runs
+// them, so there is no locking.
+//
+// Built with TILEPOOL_HUGE_PAGES, slabs are 2MB aligned and advised as
+// transparent huge pages (Linux), one TLB entry for 2MB of tiles.
+//
+// Out of core store
+//
+// A mapped pool (see tilepool_map) keeps its slabs in a file instead, mapped
+// TILEPOOL_STORE_SLAB_SIZE bytes at a time into a range of addresses reserved
+// up front, so tiles still never move. The file is unlinked as soon as it is
+// created: it goes away with the process.
+//
+// File backed pages can be written back & dropped by the OS under memory
+// pressure, where heap memory would get the process killed. On top of that,
+// the pool keeps at most budget bytes of slabs resident: users stamp the
+// slabs of the tiles they are about to use with tilepool_touch, and
+// tilepool_evict pages the least recently used ones out. A tile of an evicted
+// slab is read back from the file on demand, by the page faults of its first
+// access.
+//
+
+#ifndef _TILEPOOL_H_
+#define _TILEPOOL_H_
+
+#include "arena.h"
+#include "error.h"
+#include "types.h"
+
+#ifdef TILEPOOL_HUGE_PAGES
+#define TILEPOOL_SLAB_SIZE (2u << 20)
+#else
+#define TILEPOOL_SLAB_SIZE (256u << 10)
+#endif
+
+#define TILEPOOL_STORE_SLAB_SHIFT 16 // 64KB, a multiple of the page size
+#define TILEPOOL_STORE_SLAB_SIZE (1u << TILEPOOL_STORE_SLAB_SHIFT)
+#define TILEPOOL_STORE_SLAB_BITS 24 // At most 2^24 slabs, 1TB of addresses
+
+typedef struct TilePool {
+  void **slabs;   // Dynamic array of slabs
+  void *free;     // Last released tile, NULL if none
+  u64 size;       // Bytes of a tile, multiple of POOL_CACHE_LINE
+  u64 per_slab;   // Tiles in a slab
+  u64 count;      // Tiles in use
+  u64 capacity;   // Tiles the slabs hold
+
+  // Mapped pools only, see Out of core store
+  u8 *base;        // Reserved addresses slab i is mapped at
+                   // base + i * TILEPOOL_STORE_SLAB_SIZE, NULL: heap slabs
+  i32 fd;          // Store file
+  u64 budget;      // Bytes of slabs kept resident, 0: the OS decides
+  u64 *used;       // Dynamic array, clock of the last touch of each slab
+  u8 *resident;    // Dynamic array, whether each slab was touched since its
+                   // last eviction
+  u64 resident_nb; // Slabs touched since their last eviction
+  u64 clock;       // Calls to tilepool_evict so far
+  u64 evicted_nb;  // Slabs evicted so far
+} TilePool;
+
+// A zeroed TilePool is a valid empty pool
+void tilepool_free(TilePool *self);
+// Moves the slabs of the empty self to a file created in dir, keeping at
+// most budget bytes (rounded down to whole slabs) resident. self is left
+// untouched if the file can't be created or mapped
+void tilepool_map(TilePool *self, const char *dir, u64 budget, Error *err);
+// Zeroed tile of size bytes (the same for every call, aligned on
+// POOL_CACHE_LINE). Never returns NULL
+void *tilepool_alloc(TilePool *self, u64 size);
+void tilepool_release(TilePool *self, void *tile);
+// Pages out the least recently touched slabs past the budget of a mapped
+// pool, scratch comes from arena
+void tilepool_evict(TilePool *self, Arena *arena);
+
+// Marks the slab of tile as used since the last tilepool_evict
+static inline void tilepool_touch(TilePool *const self,
+                                  const void *const tile) {
+  if (!self->base) {
+    return;
+  }
+
+  const u64 slab = (u64)((const u8 *)tile - self->base) >>
+                   TILEPOOL_STORE_SLAB_SHIFT;
+  self->used[slab] = self->clock;
+  if (!self->resident[slab]) {
+    self->resident[slab] = true;
+    self->resident_nb += 1;
+  }
+}
+
+#endif // !_TILEPOOL_H_
@@ -0,0 +1,15 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include "types.h"
+#include <time.h>
+
+// Wall clock time in seconds, for engine side measurements (raylib's GetTime()
+// is only available once the window is open)
+static inline f64 timer_now(void) {
+  struct timespec now = {0};
+  timespec_get(&now, TIME_UTC);
+  return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+}
+
+#endif // !_TIMER_H_
@@ -0,0 +1,76 @@
+#include "arena.h"
+#include "timer.h"
+#include <assert.h>
+#include <stdlib.h>
+
+static ArenaBlock *arena_block_create(u64 size) {
+  // aligned_alloc wants a multiple of the alignment: the header & size are
+  ArenaBlock *const block =
+      aligned_alloc(ARENA_ALIGN, sizeof(ArenaBlock) + size);
+  assert(block && "Not enough memory, this is the end...");
+  *block = (ArenaBlock){.size = size};
+  return block;
+}
+
+static void arena_free_blocks(Arena *const self) {
+  for (ArenaBlock *block = self->blocks; block;) {
+    ArenaBlock *const next = block->next;
+    free(block);
+    block = next;
+  }
+  self->blocks = NULL;
+  self->capacity = 0;
+}
+
+void arena_free(Arena *const self) {
+  arena_free_blocks(self);
+  *self = (Arena){0};
+}
+
+void *arena_alloc(Arena *const self, u64 size) {
+  size = (size + ARENA_ALIGN - 1) & ~(u64)(ARENA_ALIGN - 1);
+  self->used += size;
+  self->alloc_nb += 1;
+
+  ArenaBlock *block = self->blocks;
+  if (!block || block->size - block->used < size) {
+    // Blocks at least double the capacity, so a generation needs few of them
+    const f64 time_start = timer_now();
+    u64 block_size = self->capacity > ARENA_MIN_BLOCK ? self->capacity
+                                                      : ARENA_MIN_BLOCK;
+    while (block_size < size) {
+      block_size *= 2;
+    }
+    block = arena_block_create(block_size);
+    block->next = self->blocks;
+    self->blocks = block;
+    self->capacity += block_size;
+    self->time += timer_now() - time_start;
+  }
+
+  void *const ptr = block->data + block->used;
+  block->used += size;
+  return ptr;
+}
+
+void arena_reset(Arena *const self) {
+  // Merge the blocks the generation needed into one
+  if (self->blocks && self->blocks->next) {
+    const f64 time_start = timer_now();
+    const u64 capacity = self->capacity;
+    arena_free_blocks(self);
+    self->blocks = arena_block_create(capacity);
+    self->capacity = capacity;
+    self->time += timer_now() - time_start;
+  }
+  if (self->blocks) {
+    self->blocks->used = 0;
+  }
+
+  self->last_used = self->used;
+  self->last_alloc_nb = self->alloc_nb;
+  self->last_time = self->time;
+  self->used = 0;
+  self->alloc_nb = 0;
+  self->time = 0.0;
+}
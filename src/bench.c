@@ -0,0 +1,231 @@
+#include "bench.h"
+#include "engine.h"
+#include "kernel.h"
+#include "pool.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct BenchResult {
+  f64 time;       // Seconds for every generation
+  f64 view_time;  // Seconds extracting the view after each generation
+  u64 cells;      // Cells that went through the kernel
+  u64 checksum;   // Order independent hash of the final alive cells
+  u64 population; // Final number of alive cells
+} BenchResult;
+
+// Soups are within 32-bit coordinates
+static void bench_hash_cell(void *const ctx, i64 x, i64 y) {
+  const u64 h = cellset_key((i32)x, (i32)y) * 0x9E3779B97F4A7C15ull;
+  *(u64 *)ctx += h ^ (h >> 29);
+}
+
+// rand() may only have 15 bits
+static u64 bench_rand(u64 bound) {
+  const u64 r = (u64)(rand() & 0x7FFF) << 45 | (u64)(rand() & 0x7FFF) << 30 |
+                (u64)(rand() & 0x7FFF) << 15 | (u64)(rand() & 0x7FFF);
+  return r % bound;
+}
+
+// Same soup or gliders for every run
+static void bench_seed(Engine *const engine, u32 size,
+                       BenchWorkload workload) {
+  srand(1);
+  if (workload == bench_gliders) {
+    // Heading south east, mirrored at random
+    const i32 glider[5][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+    for (u32 i = 0; i < BENCH_GLIDER_NB; i++) {
+      const i32 x = (i32)bench_rand(size - 2);
+      const i32 y = (i32)bench_rand(size - 2);
+      const u64 way = bench_rand(4);
+      for (u32 j = 0; j < 5; j++) {
+        engine_set_cell(engine, x + (way & 1 ? 2 - glider[j][0] : glider[j][0]),
+                        y + (way & 2 ? 2 - glider[j][1] : glider[j][1]), true);
+      }
+    }
+    return;
+  }
+
+  for (i32 y = 0; y < (i32)size; y++) {
+    for (i32 x = 0; x < (i32)size; x++) {
+      if (rand() % 2) {
+        engine_set_cell(engine, x, y, true);
+      }
+    }
+  }
+}
+
+static bool bench_once(u32 size, u32 generations, u32 thread_nb,
+                       EngineKind kind, Rule rule, BenchWorkload workload,
+                       BenchResult *const result) {
+  Error err = {0};
+  ThreadPool pool;
+  pool_create(&pool, thread_nb, &err);
+  if (err.status) {
+    fprintf(stderr, "Could not create pool: %s\n", err.msg);
+    pool_destroy(&pool);
+    return false;
+  }
+
+  Engine engine = {.pool = &pool};
+  engine_set_rule(&engine, rule);
+  if (kind == engine_bounded) {
+    // The soup fills a torus, width rounded up to whole words
+    engine_set_bounds(&engine, bitgrid_torus,
+                      (size + TILE_MASK) >> TILE_SHIFT << TILE_SHIFT, size);
+  } else {
+    engine_set_kind(&engine, kind);
+  }
+  bench_seed(&engine, size, workload);
+
+  // A view in the middle of the soup, as the render buffer copy extracts it
+  const i32 centre = (i32)size / 2;
+  const CellRect64 view = {.min_x = centre - BENCH_VIEW_WIDTH / 2,
+                           .min_y = centre - BENCH_VIEW_HEIGHT / 2,
+                           .max_x = centre + BENCH_VIEW_WIDTH / 2 - 1,
+                           .max_y = centre + BENCH_VIEW_HEIGHT / 2 - 1};
+
+  *result = (BenchResult){0};
+  for (u32 i = 0; i < generations; i++) {
+    const u64 population = engine_population(&engine);
+    const f64 time_start = timer_now();
+    engine_step(&engine);
+    result->time += timer_now() - time_start;
+    result->cells += kind == engine_states    ? engine.states.cells_computed
+                     : kind == engine_bounded ? engine.grid.cells_computed
+                     : kind == engine_sparse  ? engine.sparse.cells_computed
+                     : kind == engine_list    ? population
+                                              : engine.tiles.cells_computed;
+
+    u64 view_checksum = 0;
+    const f64 view_start = timer_now();
+    engine_foreach_cell(&engine, view, &bench_hash_cell, &view_checksum);
+    result->view_time += timer_now() - view_start;
+  }
+
+  engine_foreach_cell(&engine, CELLRECT64_ALL, &bench_hash_cell,
+                      &result->checksum);
+  result->population = engine_population(&engine);
+
+  engine_free(&engine);
+  pool_destroy(&pool);
+
+  return true;
+}
+
+static bool bench_parse(const char *const arg, u32 *const value) {
+  char *end;
+  const unsigned long parsed = strtoul(arg, &end, 10);
+  if (*end || end == arg || !parsed || parsed > UINT32_MAX) {
+    fprintf(stderr, "Invalid bench argument: %s\n", arg);
+    return false;
+  }
+  *value = (u32)parsed;
+  return true;
+}
+
+i32 bench_run(i32 argc, char *argv[]) {
+  u32 size = BENCH_DEFAULT_SIZE;
+  u32 generations = BENCH_DEFAULT_GENERATIONS;
+  u32 max_threads = pool_hardware_threads();
+  Rule rule = RULE_CONWAY;
+  EngineKind kind = engine_tiled;
+  BenchWorkload workload = bench_soup;
+
+  if ((argc > 0 && !bench_parse(argv[0], &size)) ||
+      (argc > 1 && !bench_parse(argv[1], &generations)) ||
+      (argc > 2 && !bench_parse(argv[2], &max_threads))) {
+    return EXIT_FAILURE;
+  }
+  if (argc > 3 && !rule_parse(argv[3], &rule)) {
+    fprintf(stderr, "Invalid bench rule: %s\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+  if (argc > 4 && (!engine_kind_from_name(argv[4], &kind) ||
+                   (kind != engine_tiled && kind != engine_states &&
+                    kind != engine_bounded && kind != engine_sparse &&
+                    kind != engine_list))) {
+    fprintf(stderr, "Invalid bench engine: %s\n", argv[4]);
+    return EXIT_FAILURE;
+  }
+  if (argc > 5) {
+    if (!strcmp(argv[5], "gliders")) {
+      workload = bench_gliders;
+    } else if (strcmp(argv[5], "soup")) {
+      fprintf(stderr, "Invalid bench workload: %s\n", argv[5]);
+      return EXIT_FAILURE;
+    }
+  }
+  // Gliders are 3x3 & their coordinates 32-bit
+  if (workload == bench_gliders && (size < 3 || size > INT32_MAX)) {
+    fprintf(stderr, "Gliders are scattered over 3 to %d cells wide\n",
+            INT32_MAX);
+    return EXIT_FAILURE;
+  }
+  if (kind == engine_bounded && size > BITGRID_MAX_SIZE) {
+    fprintf(stderr, "Bounded universes are up to %u cells wide\n",
+            BITGRID_MAX_SIZE);
+    return EXIT_FAILURE;
+  }
+  // Multi-state rules only run on the states engine
+  if (!engine_kind_supports(kind, rule)) {
+    kind = engine_states;
+  }
+  if (max_threads > POOL_MAX_THREADS) {
+    max_threads = POOL_MAX_THREADS;
+  }
+  // The list engine steps on the calling thread
+  if (kind == engine_list) {
+    max_threads = 1;
+  }
+
+  kernel_init();
+  char rule_str[RULE_STR_SIZE];
+  rule_format(rule, rule_str);
+  printf("Bench: %ux%u %s, %u generations, %s engine, %s kernel, %s\n",
+         size, size, workload == bench_gliders ? "gliders" : "soup",
+         generations, engine_kind_name(kind), kernel_name(kernel_selected()),
+         rule_str);
+  printf("%8s %12s %12s %9s %11s %10s  %s\n", "threads", "time (ms)",
+         "Mcells/s", "speedup", "efficiency", "view (us)", "checksum");
+
+  BenchResult single = {0};
+  bool deterministic = true;
+
+  // 1, 2, 4... and max_threads itself
+  for (u32 thread_nb = 1;; thread_nb = thread_nb * 2 < max_threads
+                                           ? thread_nb * 2
+                                           : max_threads) {
+    BenchResult result;
+    if (!bench_once(size, generations, thread_nb, kind, rule, workload,
+                    &result)) {
+      return EXIT_FAILURE;
+    }
+    if (thread_nb == 1) {
+      single = result;
+    }
+
+    const bool same = result.checksum == single.checksum &&
+                      result.population == single.population;
+    deterministic &= same;
+
+    const f64 speedup = single.time / result.time;
+    printf("%8u %12.2lf %12.1lf %8.2lfx %10.1lf%% %10.1lf  %016lx%s\n",
+           thread_nb, result.time * 1e3,
+           (f64)result.cells / result.time * 1e-6, speedup,
+           speedup / thread_nb * 100.0, result.view_time / generations * 1e6,
+           result.checksum, same ? "" : " MISMATCH");
+
+    if (thread_nb == max_threads) {
+      break;
+    }
+  }
+
+  if (!deterministic) {
+    fprintf(stderr, "Results depend on the number of threads!\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
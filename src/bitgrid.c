@@ -0,0 +1,247 @@
+#include "bitgrid.h"
+#include "kernel.h"
+#include "timer.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const bitgrid_topology_names[bitgrid_topology_count] = {
+    [bitgrid_plane] = "plane",
+    [bitgrid_torus] = "torus",
+    [bitgrid_klein] = "klein",
+};
+
+// Zobrist hashing by words, as the tiles hash their rows (see tile.c): empty
+// words hash to 0, births & deaths only rehash the words they change
+static inline u64 bitgrid_word_hash(u64 index, u64 word) {
+  return word ? cellset_zobrist(word ^ (index * 0x9E3779B97F4A7C15ull)) : 0;
+}
+
+// Bit x of the result is bit TILE_MASK - x of word
+static inline u64 bitgrid_reverse(u64 word) {
+  word = (word >> 1 & 0x5555555555555555ull) |
+         (word & 0x5555555555555555ull) << 1;
+  word = (word >> 2 & 0x3333333333333333ull) |
+         (word & 0x3333333333333333ull) << 2;
+  word = (word >> 4 & 0x0F0F0F0F0F0F0F0Full) |
+         (word & 0x0F0F0F0F0F0F0F0Full) << 4;
+  return __builtin_bswap64(word);
+}
+
+void bitgrid_create(BitGrid *const self, BitGridTopology topology, u32 width,
+                    u32 height) {
+  assert(topology < bitgrid_topology_count && "Unknown topology");
+  assert(width && !(width & TILE_MASK) && width <= BITGRID_MAX_SIZE &&
+         "Width must be a positive multiple of TILE_SIZE");
+  assert(height && height <= BITGRID_MAX_SIZE && "Invalid height");
+
+  *self = (BitGrid){.topology = topology,
+                    .width = width,
+                    .height = height,
+                    .words = width >> TILE_SHIFT,
+                    .band_nb = (height + TILE_MASK) >> TILE_SHIFT};
+
+  // aligned_alloc wants a multiple of the alignment
+  const u64 size = ((u64)self->words * height * sizeof(u64) +
+                    POOL_CACHE_LINE - 1) &
+                   ~(u64)(POOL_CACHE_LINE - 1);
+  for (u32 p = 0; p < 2; p++) {
+    self->bits[p] = aligned_alloc(POOL_CACHE_LINE, size);
+    assert(self->bits[p] && "Not enough memory, this is the end...");
+    memset(self->bits[p], 0, size);
+  }
+  self->band_population = calloc(self->band_nb, sizeof(u64));
+  self->band_hash = calloc(self->band_nb, sizeof(u64));
+  assert(self->band_population && self->band_hash &&
+         "Not enough memory, this is the end...");
+}
+
+void bitgrid_free(BitGrid *const self) {
+  free(self->bits[0]);
+  free(self->bits[1]);
+  free(self->band_population);
+  free(self->band_hash);
+  *self = (BitGrid){0};
+}
+
+bool bitgrid_contains(const BitGrid *const self, i32 x, i32 y) {
+  return x >= 0 && y >= 0 && (u32)x < self->width && (u32)y < self->height;
+}
+
+bool bitgrid_get_cell(const BitGrid *const self, i32 x, i32 y) {
+  if (!bitgrid_contains(self, x, y)) {
+    return false;
+  }
+  const u64 index = (u64)y * self->words + ((u32)x >> TILE_SHIFT);
+  return self->bits[self->phase][index] >> (x & TILE_MASK) & 1;
+}
+
+void bitgrid_set_cell(BitGrid *const self, i32 x, i32 y, bool alive) {
+  if (!bitgrid_contains(self, x, y)) {
+    return;
+  }
+
+  const u64 index = (u64)y * self->words + ((u32)x >> TILE_SHIFT);
+  u64 *const word = &self->bits[self->phase][index];
+  const u64 bit = 1ull << (x & TILE_MASK);
+
+  if (alive == !(*word & bit)) {
+    const u64 hash = bitgrid_word_hash(index, *word) ^
+                     bitgrid_word_hash(index, *word ^ bit);
+    const u32 band = (u32)y >> TILE_SHIFT;
+    *word ^= bit;
+    self->band_population[band] += alive ? 1 : (u64)-1;
+    self->population += alive ? 1 : (u64)-1;
+    self->band_hash[band] ^= hash;
+    self->hash ^= hash;
+  }
+}
+
+// Row y of bits, or the row the topology puts there if y is just past an edge.
+// NULL if there is no such row: its cells are dead
+static const u64 *bitgrid_halo_row(const BitGrid *const self,
+                                   const u64 *const bits, i64 y,
+                                   bool *const mirrored) {
+  *mirrored = false;
+  if (y >= 0 && y < self->height) {
+    return bits + (u64)y * self->words;
+  }
+  if ((y != -1 && y != self->height) || self->topology == bitgrid_plane) {
+    return NULL;
+  }
+
+  *mirrored = self->topology == bitgrid_klein;
+  return bits + (y < 0 ? (u64)(self->height - 1) * self->words : 0);
+}
+
+// Word j of a halo row, j being -1 or words past the west & east edges
+static inline u64 bitgrid_halo_word(const BitGrid *const self,
+                                    const u64 *const row, bool mirrored,
+                                    i64 j) {
+  if (!row) {
+    return 0;
+  }
+  if (j < 0 || j >= self->words) {
+    if (self->topology == bitgrid_plane) {
+      return 0;
+    }
+    j = j < 0 ? self->words - 1 : 0;
+  }
+  return mirrored ? bitgrid_reverse(row[self->words - 1 - j]) : row[j];
+}
+
+// Pool task: next generation of the rows of band
+static void bitgrid_step_band(void *const ctx, u32 worker, u32 band) {
+  (void)worker;
+  BitGrid *const self = (BitGrid *)ctx;
+  const u64 *const cur = self->bits[self->phase];
+  u64 *const nxt = self->bits[self->phase ^ 1];
+  u64 mid[TILE_HALO_SIZE], left[TILE_HALO_SIZE], right[TILE_HALO_SIZE];
+  u64 next[TILE_SIZE];
+
+  const u32 y0 = band << TILE_SHIFT;
+  const u32 rows =
+      self->height - y0 < TILE_SIZE ? self->height - y0 : TILE_SIZE;
+
+  // Rows y0 - 1 to y0 + TILE_SIZE, the ones past the last row of a short band
+  // only reach rows that aren't written back
+  const u64 *halo[TILE_HALO_SIZE];
+  bool mirrored[TILE_HALO_SIZE];
+  for (u32 r = 0; r < TILE_HALO_SIZE; r++) {
+    mirrored[r] = false;
+    halo[r] = r <= rows + 1 ? bitgrid_halo_row(self, cur, (i64)y0 + r - 1,
+                                               &mirrored[r])
+                            : NULL;
+  }
+
+  u64 population = 0;
+  u64 hash = self->band_hash[band];
+
+  for (u32 j = 0; j < self->words; j++) {
+    u64 any = 0;
+    for (u32 r = 0; r < TILE_HALO_SIZE; r++) {
+      mid[r] = bitgrid_halo_word(self, halo[r], mirrored[r], j);
+      left[r] = bitgrid_halo_word(self, halo[r], mirrored[r], (i64)j - 1);
+      right[r] = bitgrid_halo_word(self, halo[r], mirrored[r], (i64)j + 1);
+      any |= mid[r] | left[r] | right[r];
+    }
+
+    // B0 rules are rejected, dead neighbourhoods stay dead
+    if (any) {
+      kernel_tile(self->rule, mid, left, right, next);
+    } else {
+      memset(next, 0, sizeof(next));
+    }
+
+    for (u32 r = 0; r < rows; r++) {
+      const u64 index = (u64)(y0 + r) * self->words + j;
+      if (next[r] != cur[index]) {
+        hash ^= bitgrid_word_hash(index, cur[index]) ^
+                bitgrid_word_hash(index, next[r]);
+      }
+      nxt[index] = next[r];
+      population += (u64)__builtin_popcountll(next[r]);
+    }
+  }
+
+  self->band_population[band] = population;
+  self->band_hash[band] = hash;
+}
+
+void bitgrid_step(BitGrid *const self, ThreadPool *const pool) {
+  // Bands only write their own rows of the next generation, so they can be
+  // computed in any order
+  const f64 time_start = timer_now();
+
+  pool_run(pool, self->band_nb, &bitgrid_step_band, self);
+
+  self->compute_time = timer_now() - time_start;
+  self->cells_computed = (u64)self->width * self->height;
+  self->phase ^= 1;
+
+  self->population = 0;
+  self->hash = 0;
+  for (u32 band = 0; band < self->band_nb; band++) {
+    self->population += self->band_population[band];
+    self->hash ^= self->band_hash[band];
+  }
+}
+
+void bitgrid_foreach_cell(const BitGrid *const self, CellRect rect,
+                          BitGridCellFn fn, void *ctx) {
+  // Clip rect to the universe
+  const i64 min_x = rect.min_x > 0 ? rect.min_x : 0;
+  const i64 min_y = rect.min_y > 0 ? rect.min_y : 0;
+  const i64 max_x =
+      rect.max_x < (i64)self->width - 1 ? rect.max_x : (i64)self->width - 1;
+  const i64 max_y =
+      rect.max_y < (i64)self->height - 1 ? rect.max_y : (i64)self->height - 1;
+
+  for (i64 y = min_y; y <= max_y; y++) {
+    const u64 *const row = self->bits[self->phase] + (u64)y * self->words;
+    for (i64 j = min_x >> TILE_SHIFT; j <= max_x >> TILE_SHIFT; j++) {
+      for (u64 bits = row[j]; bits; bits &= bits - 1) {
+        const i64 x = j * TILE_SIZE + __builtin_ctzll(bits);
+        if (x >= min_x && x <= max_x) {
+          fn(ctx, (i32)x, (i32)y);
+        }
+      }
+    }
+  }
+}
+
+const char *bitgrid_topology_name(BitGridTopology topology) {
+  assert(topology < bitgrid_topology_count && "Unknown topology");
+  return bitgrid_topology_names[topology];
+}
+
+bool bitgrid_topology_from_name(const char *const name,
+                                BitGridTopology *const topology) {
+  for (u32 i = 0; i < bitgrid_topology_count; i++) {
+    if (!strcmp(name, bitgrid_topology_names[i])) {
+      *topology = (BitGridTopology)i;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,322 @@
+#include "celllist.h"
+#include "radix.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define CELLLIST_MIN_CAPACITY 1024
+
+static inline ListKey celllist_key(i32 x, i32 y) {
+  return (u64)((u32)y ^ 0x80000000u) << 32 | ((u32)x ^ 0x80000000u);
+}
+
+static inline i32 celllist_key_x(ListKey key) {
+  return (i32)((u32)key ^ 0x80000000u);
+}
+
+static inline i32 celllist_key_y(ListKey key) {
+  return (i32)((u32)(key >> 32) ^ 0x80000000u);
+}
+
+static void celllist_reserve(CellList *const self, u32 p, u64 count) {
+  if (count <= self->capacity[p]) {
+    return;
+  }
+
+  u64 capacity =
+      self->capacity[p] ? self->capacity[p] : CELLLIST_MIN_CAPACITY;
+  while (capacity < count) {
+    capacity *= 2;
+  }
+  self->cells[p] = realloc(self->cells[p], capacity * sizeof(ListKey));
+  assert(self->cells[p] && "Not enough memory, this is the end...");
+  self->capacity[p] = capacity;
+}
+
+// Index of the first cell >= key
+static u64 celllist_lower_bound(const CellList *const self, ListKey key) {
+  const ListKey *const cells = self->cells[self->phase];
+  u64 lo = 0, hi = self->count;
+  while (lo < hi) {
+    const u64 mid = lo + (hi - lo) / 2;
+    if (cells[mid] < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+void celllist_free(CellList *const self) {
+  free(self->cells[0]);
+  free(self->cells[1]);
+  cellset_free(&self->edits);
+  *self = (CellList){0};
+}
+
+bool celllist_get_cell(const CellList *const self, i32 x, i32 y) {
+  const u32 *const edit = cellset_get(&self->edits, cellset_key(x, y));
+  if (edit) {
+    return *edit;
+  }
+
+  const ListKey key = celllist_key(x, y);
+  const u64 i = celllist_lower_bound(self, key);
+  return i < self->count && self->cells[self->phase][i] == key;
+}
+
+void celllist_set_cell(CellList *const self, i32 x, i32 y, bool alive) {
+  if (celllist_get_cell(self, x, y) == alive) {
+    return;
+  }
+
+  const CellKey key = cellset_key(x, y);
+  *cellset_insert(&self->edits, key, alive) = alive;
+  self->population += alive ? 1 : (u64)-1;
+  self->hash ^= cellset_zobrist(key);
+}
+
+// Sorts the edits & merges them into the list
+static void celllist_merge_edits(CellList *const self, Arena *const arena) {
+  const u64 edit_nb = self->edits.count;
+  if (!edit_nb) {
+    return;
+  }
+
+  ListKey *const keys = arena_alloc(arena, edit_nb * sizeof(ListKey));
+  ListKey *const tmp = arena_alloc(arena, edit_nb * sizeof(ListKey));
+  u64 j = 0;
+  for (u64 i = cellset_next(&self->edits, 0); i < self->edits.capacity;
+       i = cellset_next(&self->edits, i + 1)) {
+    keys[j++] = celllist_key(cellset_key_x(self->edits.keys[i]),
+                             cellset_key_y(self->edits.keys[i]));
+  }
+  radix_sort(keys, tmp, edit_nb);
+
+  const u32 cur = self->phase;
+  const u32 nxt = cur ^ 1;
+  celllist_reserve(self, nxt, self->count + edit_nb);
+  const ListKey *const cells = self->cells[cur];
+  ListKey *const out = self->cells[nxt];
+
+  u64 i = 0, count = 0;
+  j = 0;
+  while (i < self->count || j < edit_nb) {
+    if (j == edit_nb || (i < self->count && cells[i] < keys[j])) {
+      out[count++] = cells[i++];
+      continue;
+    }
+
+    // Edits replace the cell they are about
+    const ListKey key = keys[j++];
+    i += i < self->count && cells[i] == key;
+    if (*cellset_get(&self->edits, cellset_key(celllist_key_x(key),
+                                               celllist_key_y(key)))) {
+      out[count++] = key;
+    }
+  }
+
+  self->phase = nxt;
+  self->count = count;
+  cellset_free(&self->edits);
+}
+
+// Bits of the window at w whose columns have 32-bit x: the plane ends at the
+// 32-bit edge, no cell is born past it
+static inline u64 celllist_within(i64 w) {
+  const i64 lo = (i64)INT32_MIN - (w - 1);
+  const i64 hi = (i64)INT32_MAX - (w - 1);
+  u64 mask = ~0ull;
+  if (lo > 0) {
+    mask = lo > 63 ? 0 : mask << lo;
+  }
+  if (hi < 63) {
+    mask = hi < 0 ? 0 : mask & ((2ull << hi) - 1);
+  }
+  return mask;
+}
+
+// Appends the next generation of row y to out. cells[begin[k], end[k]) are
+// the cells of row y - 1 + k. The row is swept by windows of the 64 columns
+// w - 1 to w + 62 that hold cells, bit i of window[k] being the cell at
+// w - 1 + i of row y - 1 + k: each of the columns w to w + 61 next to a cell
+// reads its neighbourhood (see rule.h) with 3 shifts, then looks up table.
+// Returns the number of cells appended
+static u64 celllist_step_row(const ListKey *const cells, u64 begin[3],
+                             const u64 end[3], i32 y,
+                             const u64 table[RULE_NEIGHBOURHOODS / 64],
+                             ListKey *const out, u64 *const hash) {
+  u64 count = 0;
+  i64 w = INT64_MIN;
+
+  for (;;) {
+    // Leftmost column next to a cell, past the last window
+    i64 first = INT64_MAX;
+    for (u32 k = 0; k < 3; k++) {
+      if (begin[k] < end[k] && celllist_key_x(cells[begin[k]]) - 1 < first) {
+        first = (i64)celllist_key_x(cells[begin[k]]) - 1;
+      }
+    }
+    if (first == INT64_MAX) {
+      return count;
+    }
+    w = first > w + 62 ? first : w + 62;
+
+    // Cells up to w + 60 are only next to columns of this window
+    u64 window[3];
+    for (u32 k = 0; k < 3; k++) {
+      window[k] = 0;
+      for (u64 i = begin[k];
+           i < end[k] && celllist_key_x(cells[i]) <= w + 62; i++) {
+        const i64 x = celllist_key_x(cells[i]);
+        window[k] |= 1ull << (x - w + 1);
+        begin[k] += x <= w + 60;
+      }
+    }
+
+    const u64 any = window[0] | window[1] | window[2];
+    for (u64 columns = (any | any << 1 | any >> 1) & 0x7FFFFFFFFFFFFFFEull &
+                       celllist_within(w);
+         columns; columns &= columns - 1) {
+      const u32 i = (u32)__builtin_ctzll(columns);
+      const u32 neighbourhood = (u32)((window[0] >> (i - 1) & 7) |
+                                      (window[1] >> (i - 1) & 7) << 3 |
+                                      (window[2] >> (i - 1) & 7) << 6);
+      const bool alive = window[1] >> i & 1;
+      const bool next = table[neighbourhood >> 6] >> (neighbourhood & 63) & 1;
+      const i32 x = (i32)(w - 1 + i);
+      if (next) {
+        out[count++] = celllist_key(x, y);
+      }
+      if (next != alive) {
+        *hash ^= cellset_zobrist(cellset_key(x, y));
+      }
+    }
+  }
+}
+
+void celllist_step(CellList *const self, Arena *const arena) {
+  celllist_merge_edits(self, arena);
+
+  // Next state of every neighbourhood
+  const Rule rule = rule_resolve(self->rule);
+  u64 table[RULE_NEIGHBOURHOODS / 64] = {0};
+  for (u32 n = 0; n < RULE_NEIGHBOURHOODS; n++) {
+    table[n / 64] |= (u64)rule_next_neighbourhood(rule, n) << (n % 64);
+  }
+
+  const u32 cur = self->phase;
+  const u32 nxt = cur ^ 1;
+  const ListKey *const cells = self->cells[cur];
+
+  // Index of the first cell of each row, the last one ends the list
+  u64 *const rows = arena_alloc(arena, (self->count + 1) * sizeof(u64));
+  u64 row_nb = 0;
+  for (u64 i = 0; i < self->count; i++) {
+    if (!i || cells[i] >> 32 != cells[i - 1] >> 32) {
+      rows[row_nb++] = i;
+    }
+  }
+  rows[row_nb] = self->count;
+
+  // Output rows are swept in order, r being the first row at y - 1 or after
+  u64 count = 0;
+  u64 r = 0;
+  i64 y = row_nb ? (i64)celllist_key_y(cells[0]) - 1 : 0;
+  while (r < row_nb) {
+    u64 begin[3], end[3];
+    u64 row = r;
+    u64 len = 0;
+    for (u32 k = 0; k < 3; k++) {
+      begin[k] = end[k] = 0;
+      if (row < row_nb && celllist_key_y(cells[rows[row]]) == y - 1 + k) {
+        begin[k] = rows[row];
+        end[k] = rows[row + 1];
+        len += end[k] - begin[k];
+        row += 1;
+      }
+    }
+
+    // Each cell faces 3 cells of the row at most. Rows past the 32-bit edge
+    // stay empty
+    if (y >= INT32_MIN && y <= INT32_MAX) {
+      celllist_reserve(self, nxt, count + 3 * len);
+      count += celllist_step_row(cells, begin, end, (i32)y, table,
+                                 self->cells[nxt] + count, &self->hash);
+    }
+
+    // The next row needs rows y to y + 2
+    if (celllist_key_y(cells[rows[r]]) == y - 1) {
+      r += 1;
+    }
+    if (r < row_nb) {
+      const i64 row_y = celllist_key_y(cells[rows[r]]);
+      y = row_y - 1 > y + 1 ? row_y - 1 : y + 1;
+    }
+  }
+
+  self->phase = nxt;
+  self->count = count;
+  self->population = count;
+}
+
+static inline void celllist_bound(CellRect *const rect, i32 x, i32 y) {
+  rect->min_x = x < rect->min_x ? x : rect->min_x;
+  rect->min_y = y < rect->min_y ? y : rect->min_y;
+  rect->max_x = x > rect->max_x ? x : rect->max_x;
+  rect->max_y = y > rect->max_y ? y : rect->max_y;
+}
+
+bool celllist_bounds(const CellList *const self, CellRect *const rect) {
+  *rect = (CellRect){.min_x = INT32_MAX,
+                     .min_y = INT32_MAX,
+                     .max_x = INT32_MIN,
+                     .max_y = INT32_MIN};
+
+  // Rows are sorted, only columns need a pass
+  const ListKey *const cells = self->cells[self->phase];
+  if (self->count) {
+    celllist_bound(rect, celllist_key_x(cells[0]), celllist_key_y(cells[0]));
+    celllist_bound(rect, celllist_key_x(cells[self->count - 1]),
+                   celllist_key_y(cells[self->count - 1]));
+  }
+  for (u64 i = 0; i < self->count; i++) {
+    const i32 x = celllist_key_x(cells[i]);
+    rect->min_x = x < rect->min_x ? x : rect->min_x;
+    rect->max_x = x > rect->max_x ? x : rect->max_x;
+  }
+
+  for (u64 i = cellset_next(&self->edits, 0); i < self->edits.capacity;
+       i = cellset_next(&self->edits, i + 1)) {
+    if (self->edits.values[i]) {
+      celllist_bound(rect, cellset_key_x(self->edits.keys[i]),
+                     cellset_key_y(self->edits.keys[i]));
+    }
+  }
+  return rect->min_x <= rect->max_x;
+}
+
+void celllist_foreach_cell(const CellList *const self, CellRect rect,
+                           ListCellFn fn, void *ctx) {
+  // Rows before rect are skipped, the list ends after it
+  const ListKey *const cells = self->cells[self->phase];
+  for (u64 i = celllist_lower_bound(self, celllist_key(rect.min_x, rect.min_y));
+       i < self->count && celllist_key_y(cells[i]) <= rect.max_y; i++) {
+    const i32 x = celllist_key_x(cells[i]);
+    const i32 y = celllist_key_y(cells[i]);
+    if (cellrect_contains(rect, x, y) &&
+        !(self->edits.count &&
+          cellset_contains(&self->edits, cellset_key(x, y)))) {
+      fn(ctx, x, y);
+    }
+  }
+
+  for (u64 i = cellset_next(&self->edits, 0); i < self->edits.capacity;
+       i = cellset_next(&self->edits, i + 1)) {
+    const i32 x = cellset_key_x(self->edits.keys[i]);
+    const i32 y = cellset_key_y(self->edits.keys[i]);
+    if (self->edits.values[i] && cellrect_contains(rect, x, y)) {
+      fn(ctx, x, y);
+    }
+  }
+}
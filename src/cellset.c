@@ -0,0 +1,314 @@
+#include "cellset.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define CELLSET_EMPTY ((i8)-128)  // 0b10000000
+#define CELLSET_DELETED ((i8)-2)  // 0b11111110
+#define CELLSET_PREFETCH_DIST 8   // Bulk operations hash this far ahead
+
+// Multiply then fold the high half in: cheap, and since both coordinates end
+// up in the low 32 bits, h1 (position) and h2 (control byte) depend on x & y
+static inline u64 cellset_hash(CellKey key) {
+  u64 h = key * 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 32);
+}
+
+static inline i8 cellset_h2(u64 hash) { return (i8)(hash & 0x7F); }
+
+static inline u64 cellset_h1(u64 hash) { return hash >> 7; }
+
+// Group matching
+//
+// A match is a bitmask with one set bit per matching slot. SSE2 gives one bit
+// per slot, SWAR gives the top bit of each matching byte, hence the shift
+// used to get slot indices back.
+#if defined(__SSE2__)
+#define CELLSET_MASK_SHIFT 0
+
+static inline u64 cellset_match(const i8 *group, i8 h2) {
+  const __m128i ctrl = _mm_load_si128((const __m128i *)(const void *)group);
+  return (u64)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+}
+
+static inline u64 cellset_match_empty(const i8 *group) {
+  return cellset_match(group, CELLSET_EMPTY);
+}
+
+static inline u64 cellset_match_empty_or_deleted(const i8 *group) {
+  // Only EMPTY and DELETED have their sign bit set
+  const __m128i ctrl = _mm_load_si128((const __m128i *)(const void *)group);
+  return (u64)(u32)_mm_movemask_epi8(ctrl);
+}
+#else
+#define CELLSET_MASK_SHIFT 3
+#define CELLSET_LSBS 0x0101010101010101ull
+#define CELLSET_MSBS 0x8080808080808080ull
+
+static inline u64 cellset_load_group(const i8 *group) {
+  u64 ctrl;
+  memcpy(&ctrl, group, sizeof(ctrl));
+  return ctrl;
+}
+
+// May report false positives in bytes following a true match, harmless since
+// keys are compared afterwards
+static inline u64 cellset_match(const i8 *group, i8 h2) {
+  const u64 x = cellset_load_group(group) ^ (CELLSET_LSBS * (u8)h2);
+  return (x - CELLSET_LSBS) & ~x & CELLSET_MSBS;
+}
+
+static inline u64 cellset_match_empty(const i8 *group) {
+  // EMPTY is the only control byte with bit 7 set and bit 1 cleared
+  const u64 ctrl = cellset_load_group(group);
+  return ctrl & ~(ctrl << 6) & CELLSET_MSBS;
+}
+
+static inline u64 cellset_match_empty_or_deleted(const i8 *group) {
+  return cellset_load_group(group) & CELLSET_MSBS;
+}
+#endif
+
+static inline u64 cellset_mask_first(u64 mask) {
+  return (u64)__builtin_ctzll(mask) >> CELLSET_MASK_SHIFT;
+}
+
+static inline u64 cellset_capacity_for(u64 count) {
+  u64 capacity = CELLSET_GROUP_WIDTH;
+  while (capacity - capacity / 8 < count) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+// Triangular probing over groups: visits every group once when the number of
+// groups is a power of 2
+static u64 cellset_find_slot(const CellSet *const self, CellKey key,
+                             u64 hash) {
+  const u64 group_mask = self->capacity / CELLSET_GROUP_WIDTH - 1;
+  const i8 h2 = cellset_h2(hash);
+  u64 group = cellset_h1(hash) & group_mask;
+
+  for (u64 step = 1;; step++) {
+    const i8 *const ctrl = self->ctrl + group * CELLSET_GROUP_WIDTH;
+
+    for (u64 match = cellset_match(ctrl, h2); match; match &= match - 1) {
+      const u64 slot = group * CELLSET_GROUP_WIDTH + cellset_mask_first(match);
+      if (self->keys[slot] == key) {
+        return slot;
+      }
+    }
+
+    if (cellset_match_empty(ctrl)) {
+      return self->capacity;
+    }
+
+    group = (group + step) & group_mask;
+  }
+}
+
+static u64 cellset_find_free_slot(const CellSet *const self, u64 hash) {
+  const u64 group_mask = self->capacity / CELLSET_GROUP_WIDTH - 1;
+  u64 group = cellset_h1(hash) & group_mask;
+
+  for (u64 step = 1;; step++) {
+    const i8 *const ctrl = self->ctrl + group * CELLSET_GROUP_WIDTH;
+    const u64 match = cellset_match_empty_or_deleted(ctrl);
+    if (match) {
+      return group * CELLSET_GROUP_WIDTH + cellset_mask_first(match);
+    }
+    group = (group + step) & group_mask;
+  }
+}
+
+static void cellset_rehash(CellSet *const self, u64 capacity) {
+  assert(capacity >= CELLSET_GROUP_WIDTH && !(capacity & (capacity - 1)) &&
+         "Capacity must be a power of 2");
+
+  CellSet new_set = {
+      .ctrl = aligned_alloc(CELLSET_GROUP_WIDTH, capacity),
+      .keys = malloc(capacity * sizeof(CellKey)),
+      .values = malloc(capacity * sizeof(u32)),
+      .capacity = capacity,
+      .count = self->count,
+      .growth_left = capacity - capacity / 8 - self->count};
+  assert(new_set.ctrl && new_set.keys && new_set.values &&
+         "Not enough memory, this is the end...");
+
+  memset(new_set.ctrl, CELLSET_EMPTY, capacity);
+
+  // No duplicates, no tombstones: insert straight into the first free slot
+  for (u64 i = cellset_next(self, 0); i < self->capacity;
+       i = cellset_next(self, i + 1)) {
+    const u64 hash = cellset_hash(self->keys[i]);
+    const u64 slot = cellset_find_free_slot(&new_set, hash);
+    new_set.ctrl[slot] = cellset_h2(hash);
+    new_set.keys[slot] = self->keys[i];
+    new_set.values[slot] = self->values[i];
+  }
+
+  cellset_free(self);
+  *self = new_set;
+}
+
+void cellset_free(CellSet *const self) {
+  free(self->ctrl);
+  free(self->keys);
+  free(self->values);
+  *self = (CellSet){0};
+}
+
+void cellset_clear(CellSet *const self) {
+  if (self->capacity) {
+    memset(self->ctrl, CELLSET_EMPTY, self->capacity);
+  }
+  self->count = 0;
+  self->growth_left = self->capacity - self->capacity / 8;
+}
+
+void cellset_reserve(CellSet *const self, u64 count) {
+  const u64 capacity = cellset_capacity_for(count);
+  if (capacity > self->capacity) {
+    cellset_rehash(self, capacity);
+  }
+}
+
+bool cellset_contains(const CellSet *const self, CellKey key) {
+  return cellset_get(self, key) != NULL;
+}
+
+u32 *cellset_get(const CellSet *const self, CellKey key) {
+  if (!self->count) {
+    return NULL;
+  }
+
+  const u64 slot = cellset_find_slot(self, key, cellset_hash(key));
+  return slot < self->capacity ? &self->values[slot] : NULL;
+}
+
+// Stores key, absent from the set, growing it if needed
+static u32 *cellset_put(CellSet *const self, CellKey key, u64 hash,
+                        u32 value) {
+  u64 slot = self->capacity ? cellset_find_free_slot(self, hash) : 0;
+
+  // Reusing a tombstone is free, taking an EMPTY slot consumes growth
+  if (!self->capacity ||
+      (!self->growth_left && self->ctrl[slot] == CELLSET_EMPTY)) {
+    // Mostly tombstones: rehash in place, else grow
+    const u64 capacity = self->count * 2 < self->capacity - self->capacity / 8
+                             ? self->capacity
+                             : cellset_capacity_for(self->count + 1) * 2;
+    cellset_rehash(self, capacity);
+    slot = cellset_find_free_slot(self, hash);
+  }
+
+  if (self->ctrl[slot] == CELLSET_EMPTY) {
+    self->growth_left -= 1;
+  }
+  self->ctrl[slot] = cellset_h2(hash);
+  self->keys[slot] = key;
+  self->values[slot] = value;
+  self->count += 1;
+
+  return &self->values[slot];
+}
+
+u32 *cellset_insert(CellSet *const self, CellKey key, u32 value) {
+  const u64 hash = cellset_hash(key);
+
+  if (self->capacity) {
+    const u64 slot = cellset_find_slot(self, key, hash);
+    if (slot < self->capacity) {
+      return &self->values[slot];
+    }
+  }
+
+  return cellset_put(self, key, hash, value);
+}
+
+u32 *cellset_insert_new(CellSet *const self, CellKey key, u32 value) {
+  return cellset_put(self, key, cellset_hash(key), value);
+}
+
+bool cellset_erase(CellSet *const self, CellKey key) {
+  if (!self->count) {
+    return false;
+  }
+
+  const u64 slot = cellset_find_slot(self, key, cellset_hash(key));
+  if (slot == self->capacity) {
+    return false;
+  }
+
+  // A group that still has an EMPTY slot never made a probe go past it, so the
+  // slot can go back to EMPTY. Otherwise leave a tombstone.
+  const i8 *const group =
+      self->ctrl + (slot & ~(u64)(CELLSET_GROUP_WIDTH - 1));
+  if (cellset_match_empty(group)) {
+    self->ctrl[slot] = CELLSET_EMPTY;
+    self->growth_left += 1;
+  } else {
+    self->ctrl[slot] = CELLSET_DELETED;
+  }
+  self->count -= 1;
+
+  return true;
+}
+
+void cellset_insert_bulk(CellSet *const self, const CellKey *const keys,
+                         u64 n) {
+  cellset_reserve(self, self->count + n);
+
+  for (u64 i = 0; i < n; i++) {
+    if (i + CELLSET_PREFETCH_DIST < n) {
+      const u64 hash = cellset_hash(keys[i + CELLSET_PREFETCH_DIST]);
+      const u64 group_mask = self->capacity / CELLSET_GROUP_WIDTH - 1;
+      __builtin_prefetch(self->ctrl +
+                         (cellset_h1(hash) & group_mask) * CELLSET_GROUP_WIDTH);
+    }
+    cellset_insert(self, keys[i], 0);
+  }
+}
+
+u64 cellset_erase_bulk(CellSet *const self, const CellKey *const keys, u64 n) {
+  u64 erased = 0;
+
+  for (u64 i = 0; i < n && self->count; i++) {
+    if (i + CELLSET_PREFETCH_DIST < n) {
+      const u64 hash = cellset_hash(keys[i + CELLSET_PREFETCH_DIST]);
+      const u64 group_mask = self->capacity / CELLSET_GROUP_WIDTH - 1;
+      __builtin_prefetch(self->ctrl +
+                         (cellset_h1(hash) & group_mask) * CELLSET_GROUP_WIDTH);
+    }
+    erased += cellset_erase(self, keys[i]);
+  }
+
+  return erased;
+}
+
+u64 cellset_next(const CellSet *const self, u64 slot) {
+  while (slot < self->capacity) {
+    const u64 offset = slot & (CELLSET_GROUP_WIDTH - 1);
+    const i8 *const group = self->ctrl + (slot - offset);
+
+    // Full slots are the ones that are neither EMPTY nor DELETED
+    u64 full = ~cellset_match_empty_or_deleted(group);
+#if CELLSET_MASK_SHIFT
+    full &= CELLSET_MSBS;
+#else
+    full &= (1ull << CELLSET_GROUP_WIDTH) - 1;
+#endif
+    full &= ~0ull << (offset << CELLSET_MASK_SHIFT);
+
+    if (full) {
+      return slot - offset + cellset_mask_first(full);
+    }
+    slot += CELLSET_GROUP_WIDTH - offset;
+  }
+
+  return self->capacity;
+}
@@ -0,0 +1,825 @@
+#include "engine.h"
+#include "timer.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+static const char *const engine_ship_names[engine_ship_count] = {
+    [engine_ship_glider] = "glider",
+    [engine_ship_lwss] = "LWSS",
+    [engine_ship_mwss] = "MWSS",
+    [engine_ship_hwss] = "HWSS",
+    [engine_ship_other] = "other",
+};
+
+static const char *const engine_kind_names[engine_kind_count] = {
+    [engine_sparse] = "sparse",
+    [engine_tiled] = "tiled",
+    [engine_hashlife] = "hashlife",
+    [engine_states] = "states",
+    [engine_list] = "list",
+    [engine_islands] = "islands",
+    [engine_bounded] = "bounded",
+};
+
+// Engine
+//
+
+void engine_free(Engine *const self) {
+  sparse_free(&self->sparse);
+  tilemap_free(&self->tiles);
+  hashlife_free(&self->life);
+  statemap_free(&self->states);
+  celllist_free(&self->list);
+  islands_free(&self->islands);
+  bitgrid_free(&self->grid);
+  arena_free(&self->arena);
+  history_free(&self->history);
+  *self = (Engine){0};
+}
+
+static void engine_migrate_cell(void *const ctx, i64 x, i64 y, u8 state) {
+  engine_set_state((Engine *)ctx, x, y, state);
+}
+
+static void engine_migrate_key(void *const ctx, i64 x, i64 y) {
+  if (cellset_within(x, y)) {
+    arrput(*(CellKey **)ctx, cellset_key((i32)x, (i32)y));
+  }
+}
+
+// Moves the cells, settings & generation of self to the empty migrated
+static void engine_migrate(Engine *const self, Engine *const migrated) {
+  // Tiles stay in memory if the store can't be created anymore
+  migrated->store_dir = self->store_dir;
+  migrated->store_budget = self->store_budget;
+  if (migrated->kind == engine_tiled && migrated->store_dir) {
+    Error err = {0};
+    tilemap_map(&migrated->tiles, migrated->store_dir, migrated->store_budget,
+                &err);
+  }
+
+  engine_set_step_exp(migrated, self->step_exp);
+  engine_set_rule(migrated, self->rule);
+  if (migrated->kind == engine_islands) {
+    // Islands are built from all the cells at once, looking each one up
+    // among the islands would be O(cells x islands)
+    CellKey *keys = NULL;
+    engine_foreach_cell(self, CELLRECT64_ALL, &engine_migrate_key, &keys);
+    islands_add_cells(&migrated->islands, keys, (u32)arrlenu(keys),
+                      &migrated->arena);
+    arena_reset(&migrated->arena);
+    arrfree(keys);
+  } else {
+    engine_foreach_state(self, CELLRECT64_ALL, &engine_migrate_cell,
+                         migrated);
+  }
+
+  // The history starts over, kinds don't hash the same way
+  migrated->generation = self->generation;
+  migrated->automatic = self->automatic;
+  migrated->escape = self->escape;
+  engine_free(self);
+  *self = *migrated;
+}
+
+void engine_set_kind(Engine *const self, EngineKind kind) {
+  assert(kind < engine_kind_count && "Unknown engine kind");
+  assert(engine_kind_supports(kind, self->rule) &&
+         "Kind doesn't support the rule");
+
+  if (kind == self->kind) {
+    return;
+  }
+  assert(kind != engine_bounded && "Bounded universes need engine_set_bounds");
+
+  Engine migrated = {.kind = kind, .pool = self->pool};
+  engine_migrate(self, &migrated);
+}
+
+void engine_set_bounds(Engine *const self, BitGridTopology topology,
+                       u32 width, u32 height) {
+  assert(engine_kind_supports(engine_bounded, self->rule) &&
+         "Bounded universes only run two-state rules");
+
+  Engine migrated = {.kind = engine_bounded, .pool = self->pool};
+  bitgrid_create(&migrated.grid, topology, width, height);
+  engine_migrate(self, &migrated);
+}
+
+void engine_set_store(Engine *const self, const char *const dir, u64 budget,
+                      Error *const err) {
+  // Tries the directory out
+  TilePool pool = {0};
+  tilepool_map(&pool, dir, budget, err);
+  tilepool_free(&pool);
+  if (err->status) {
+    return;
+  }
+
+  self->store_dir = dir;
+  self->store_budget = budget;
+  if (self->kind == engine_tiled) {
+    Engine migrated = {.kind = engine_tiled, .pool = self->pool};
+    engine_migrate(self, &migrated);
+  }
+}
+
+// Automatic switching
+//
+
+void engine_set_automatic(Engine *const self, bool enabled) {
+  self->automatic = (EngineAuto){.enabled = enabled,
+                                 .from = self->kind,
+                                 .next_check = self->generation};
+}
+
+// Whether (x, y) is within ENGINE_AUTO_EDGE cells of the 32-bit edge, or past
+// it
+static inline bool engine_auto_at_edge(i64 x, i64 y) {
+  return x < (i64)INT32_MIN + ENGINE_AUTO_EDGE ||
+         x > (i64)INT32_MAX - ENGINE_AUTO_EDGE ||
+         y < (i64)INT32_MIN + ENGINE_AUTO_EDGE ||
+         y > (i64)INT32_MAX - ENGINE_AUTO_EDGE;
+}
+
+static inline bool engine_auto_tile_at_edge(i32 x, i32 y) {
+  return engine_auto_at_edge((i64)x * TILE_SIZE, (i64)y * TILE_SIZE) ||
+         engine_auto_at_edge((i64)x * TILE_SIZE + TILE_MASK,
+                             (i64)y * TILE_SIZE + TILE_MASK);
+}
+
+// Cells are within 32 bits
+static void engine_auto_count_tile(void *const ctx, i64 x, i64 y) {
+  cellset_insert((CellSet *)ctx,
+                 cellset_key((i32)(x >> TILE_SHIFT), (i32)(y >> TILE_SHIFT)),
+                 0);
+}
+
+// Population & occupied tiles of the universe
+static void engine_auto_measure(const Engine *const self,
+                                EngineAuto *const automatic) {
+  automatic->population = engine_population(self);
+  automatic->tile_nb = 0;
+  automatic->at_edge = false;
+
+  // Tiled engines count their tiles, the others hand out their cells
+  if (self->kind == engine_tiled) {
+    const u32 phase = self->tiles.phase;
+    for (u64 i = 0; i < arrlenu(self->tiles.tiles); i++) {
+      const Tile *const tile = self->tiles.tiles[i];
+      automatic->tile_nb += !!tile->population[phase];
+      automatic->at_edge |= tile->population[phase] &&
+                            engine_auto_tile_at_edge(tile->x, tile->y);
+    }
+  } else {
+    CellSet tiles = {0};
+    engine_foreach_cell(self, CELLRECT64_ALL, &engine_auto_count_tile,
+                        &tiles);
+    automatic->tile_nb = tiles.count;
+    for (u64 i = cellset_next(&tiles, 0); i < tiles.capacity;
+         i = cellset_next(&tiles, i + 1)) {
+      automatic->at_edge |= engine_auto_tile_at_edge(
+          cellset_key_x(tiles.keys[i]), cellset_key_y(tiles.keys[i]));
+    }
+    cellset_free(&tiles);
+  }
+
+  automatic->fill = automatic->tile_nb ? (f64)automatic->population /
+                                             (f64)automatic->tile_nb
+                                       : 0.0;
+}
+
+// Thresholds are halved for the current kind, see Automatic switching
+static EngineKind engine_auto_choose(const Engine *const self) {
+  const EngineAuto *const automatic = &self->automatic;
+  if (self->step_exp || automatic->at_edge) {
+    return engine_hashlife;
+  }
+
+  const f64 fill = self->kind == engine_tiled ? ENGINE_AUTO_TILED_FILL / 2
+                                              : ENGINE_AUTO_TILED_FILL;
+  if (automatic->fill >= fill) {
+    return engine_tiled;
+  }
+
+  const u64 population = self->kind == engine_list
+                             ? ENGINE_AUTO_LIST_POPULATION / 2
+                             : ENGINE_AUTO_LIST_POPULATION;
+  return automatic->population >= population ? engine_list : engine_sparse;
+}
+
+static void engine_auto_switch(Engine *const self) {
+  self->automatic.next_check = self->generation + ENGINE_AUTO_INTERVAL;
+  if (self->kind == engine_bounded || self->rule.family != rule_life_like) {
+    return;
+  }
+
+  // Other kinds would lose the cells near & past the 32-bit edge
+  const CellRect64 range = {.min_x = (i64)INT32_MIN + ENGINE_AUTO_EDGE,
+                            .min_y = (i64)INT32_MIN + ENGINE_AUTO_EDGE,
+                            .max_x = (i64)INT32_MAX - ENGINE_AUTO_EDGE,
+                            .max_y = (i64)INT32_MAX - ENGINE_AUTO_EDGE};
+  if (self->kind == engine_hashlife &&
+      hashlife_population_in(&self->life, range) != engine_population(self)) {
+    return;
+  }
+
+  // Hashlife hands out its cells slowly, only step_exp matters to it
+  if (!self->step_exp) {
+    engine_auto_measure(self, &self->automatic);
+  }
+
+  const EngineKind kind = engine_auto_choose(self);
+  if (kind == self->kind) {
+    return;
+  }
+
+  const EngineKind from = self->kind;
+  const f64 time_start = timer_now();
+  engine_set_kind(self, kind);
+  self->automatic.switch_nb += 1;
+  self->automatic.from = from;
+  self->automatic.switch_generation = self->generation;
+  self->automatic.migration_time = timer_now() - time_start;
+}
+
+// Escaping spaceships
+//
+
+void engine_set_escape(Engine *const self, bool enabled) {
+  self->escape = (EngineEscape){.enabled = enabled,
+                                .next_check = self->generation};
+}
+
+// Cells are within 32 bits
+static void engine_escape_collect(void *const ctx, i64 x, i64 y) {
+  CellKey **const keys = (CellKey **)ctx;
+  *(*keys)++ = cellset_key((i32)x, (i32)y);
+}
+
+static EngineShip engine_escape_classify(u32 period, i32 dx, i32 dy,
+                                         u64 min_population) {
+  if (period != 4) {
+    return engine_ship_other;
+  }
+  if (abs(dx) == 1 && abs(dy) == 1 && min_population == 5) {
+    return engine_ship_glider;
+  }
+  if (abs(dx) + abs(dy) != 2 || (dx && dy)) {
+    return engine_ship_other;
+  }
+  switch (min_population) {
+  case 9:
+    return engine_ship_lwss;
+  case 11:
+    return engine_ship_mwss;
+  case 13:
+    return engine_ship_hwss;
+  default:
+    return engine_ship_other;
+  }
+}
+
+// Steps the cells of a cluster on their own, box holding them. Returns the
+// spaceship they are & its shift over a period, engine_ship_count if they
+// aren't one
+static EngineShip engine_escape_ship(const Engine *const self,
+                                     const CellKey *const cells, u32 cell_nb,
+                                     CellRect box, i32 *const dx,
+                                     i32 *const dy, Arena *const arena) {
+  CellList list = {.rule = self->rule};
+  for (u32 i = 0; i < cell_nb; i++) {
+    celllist_set_cell(&list, cellset_key_x(cells[i]), cellset_key_y(cells[i]),
+                      true);
+  }
+
+  EngineShip ship = engine_ship_count;
+  u64 min_population = cell_nb;
+  CellRect next;
+  for (u32 period = 1; period <= ENGINE_ESCAPE_MAX_PERIOD; period++) {
+    celllist_step(&list, arena);
+    if (!celllist_bounds(&list, &next)) {
+      break;
+    }
+    if (list.population < min_population) {
+      min_population = list.population;
+    }
+    if (list.population != cell_nb) {
+      continue;
+    }
+
+    // The same population, the same shape if every cell moved by the shift
+    // of the box
+    *dx = next.min_x - box.min_x;
+    *dy = next.min_y - box.min_y;
+    bool same = true;
+    for (u32 i = 0; same && i < cell_nb; i++) {
+      const i64 x = (i64)cellset_key_x(cells[i]) + *dx;
+      const i64 y = (i64)cellset_key_y(cells[i]) + *dy;
+      same = cellset_within(x, y) && celllist_get_cell(&list, (i32)x, (i32)y);
+    }
+    if (same) {
+      // Still lifes & oscillators stay where they are
+      if (*dx || *dy) {
+        ship = engine_escape_classify(period, *dx, *dy, min_population);
+      }
+      break;
+    }
+  }
+
+  celllist_free(&list);
+  return ship;
+}
+
+// Whether a spaceship in box shifting by (dx, dy) moves away from rest
+static bool engine_escape_away(CellRect box, i32 dx, i32 dy, CellRect rest) {
+  return (dx > 0 && (i64)box.min_x - rest.max_x > ENGINE_ESCAPE_MARGIN) ||
+         (dx < 0 && (i64)rest.min_x - box.max_x > ENGINE_ESCAPE_MARGIN) ||
+         (dy > 0 && (i64)box.min_y - rest.max_y > ENGINE_ESCAPE_MARGIN) ||
+         (dy < 0 && (i64)rest.min_y - box.max_y > ENGINE_ESCAPE_MARGIN);
+}
+
+static inline CellRect engine_escape_union(CellRect a, CellRect b) {
+  return (CellRect){.min_x = a.min_x < b.min_x ? a.min_x : b.min_x,
+                    .min_y = a.min_y < b.min_y ? a.min_y : b.min_y,
+                    .max_x = a.max_x > b.max_x ? a.max_x : b.max_x,
+                    .max_y = a.max_y > b.max_y ? a.max_y : b.max_y};
+}
+
+// Removes the spaceships escaping the rest of the pattern, see Escaping
+// spaceships. Scratch comes from arena
+static void engine_escape_remove(Engine *const self, Arena *const arena) {
+  const u32 cell_nb = (u32)engine_population(self);
+  CellKey *const keys = arena_alloc(arena, cell_nb * sizeof(CellKey));
+  CellKey *keys_end = keys;
+  engine_foreach_cell(self, CELLRECT64_ALL, &engine_escape_collect,
+                      &keys_end);
+  u32 *const labels = arena_alloc(arena, cell_nb * sizeof(u32));
+  const u32 cluster_nb = islands_label(keys, cell_nb, labels, arena);
+
+  // Cells sorted by cluster, those of cluster c are [starts[c], starts[c + 1])
+  u32 *const starts = arena_alloc(arena, (cluster_nb + 1) * sizeof(u32));
+  memset(starts, 0, (cluster_nb + 1) * sizeof(u32));
+  for (u32 i = 0; i < cell_nb; i++) {
+    starts[labels[i] + 1] += 1;
+  }
+  for (u32 c = 0; c < cluster_nb; c++) {
+    starts[c + 1] += starts[c];
+  }
+  CellKey *const cells = arena_alloc(arena, cell_nb * sizeof(CellKey));
+  u32 *const ends = arena_alloc(arena, cluster_nb * sizeof(u32));
+  memcpy(ends, starts, cluster_nb * sizeof(u32));
+  for (u32 i = 0; i < cell_nb; i++) {
+    cells[ends[labels[i]]++] = keys[i];
+  }
+
+  // Spaceships, the other clusters are the rest of the pattern
+  CellRect *const boxes = arena_alloc(arena, cluster_nb * sizeof(CellRect));
+  EngineShip *const ships =
+      arena_alloc(arena, cluster_nb * sizeof(EngineShip));
+  i32 *const shifts = arena_alloc(arena, 2 * cluster_nb * sizeof(i32));
+  CellRect rest = {.min_x = INT32_MAX,
+                   .min_y = INT32_MAX,
+                   .max_x = INT32_MIN,
+                   .max_y = INT32_MIN};
+  for (u32 c = 0; c < cluster_nb; c++) {
+    const u32 count = starts[c + 1] - starts[c];
+    const CellKey *const cluster = &cells[starts[c]];
+    boxes[c] = (CellRect){.min_x = INT32_MAX,
+                          .min_y = INT32_MAX,
+                          .max_x = INT32_MIN,
+                          .max_y = INT32_MIN};
+    for (u32 i = 0; i < count; i++) {
+      const i32 x = cellset_key_x(cluster[i]);
+      const i32 y = cellset_key_y(cluster[i]);
+      boxes[c] = engine_escape_union(
+          boxes[c],
+          (CellRect){.min_x = x, .min_y = y, .max_x = x, .max_y = y});
+    }
+
+    ships[c] = count <= ENGINE_ESCAPE_MAX_CELLS
+                   ? engine_escape_ship(self, cluster, count, boxes[c],
+                                        &shifts[2 * c], &shifts[2 * c + 1],
+                                        arena)
+                   : engine_ship_count;
+    if (ships[c] == engine_ship_count) {
+      rest = engine_escape_union(rest, boxes[c]);
+    }
+  }
+
+  // Nothing to escape from
+  if (rest.min_x > rest.max_x) {
+    return;
+  }
+
+  EngineEscape *const escape = &self->escape;
+  for (u32 c = 0; c < cluster_nb; c++) {
+    if (ships[c] == engine_ship_count ||
+        !engine_escape_away(boxes[c], shifts[2 * c], shifts[2 * c + 1],
+                            rest)) {
+      continue;
+    }
+
+    for (u32 i = starts[c]; i < starts[c + 1]; i++) {
+      engine_set_cell(self, cellset_key_x(cells[i]), cellset_key_y(cells[i]),
+                      false);
+    }
+    escape->ship_nb[ships[c]] += 1;
+    escape->cell_nb += starts[c + 1] - starts[c];
+    escape->last_generation = self->generation;
+  }
+}
+
+static void engine_escape_check(Engine *const self) {
+  self->escape.next_check = self->generation + ENGINE_ESCAPE_INTERVAL;
+  if (self->kind == engine_bounded || self->rule.family != rule_life_like) {
+    return;
+  }
+
+  // Clusters are labelled with 32-bit cells
+  const u64 population = engine_population(self);
+  const CellRect64 range = cellrect64_clip32(CELLRECT64_ALL);
+  if (!population || population > UINT32_MAX ||
+      (self->kind == engine_hashlife &&
+       hashlife_population_in(&self->life, range) != population)) {
+    return;
+  }
+
+  // The step arena keeps the footprint of the steps
+  Arena arena = {0};
+  engine_escape_remove(self, &arena);
+  arena_free(&arena);
+}
+
+static u64 engine_step_kind(Engine *const self) {
+  switch (self->kind) {
+  case engine_sparse:
+    sparse_step(&self->sparse, self->pool);
+    return 1;
+  case engine_tiled:
+    tilemap_step(&self->tiles, self->pool, &self->arena);
+    return 1;
+  case engine_hashlife:
+    return hashlife_step(&self->life);
+  case engine_states:
+    statemap_step(&self->states, self->pool, &self->arena);
+    return 1;
+  case engine_list:
+    celllist_step(&self->list, &self->arena);
+    return 1;
+  case engine_islands:
+    islands_step(&self->islands, self->pool);
+    return 1;
+  case engine_bounded:
+    bitgrid_step(&self->grid, self->pool);
+    return 1;
+  default:
+    assert(0 && "Don't go here");
+    return 0;
+  }
+}
+
+u64 engine_step(Engine *const self) {
+  // The universe the history starts from may already be part of the cycle
+  if (!self->history.count) {
+    history_push(&self->history, engine_hash(self), engine_population(self),
+                 self->generation);
+  }
+
+  const u64 generations = engine_step_kind(self);
+  arena_reset(&self->arena);
+  if (!generations) {
+    return 0;
+  }
+  self->generation += generations;
+  history_push(&self->history, engine_hash(self), engine_population(self),
+               self->generation);
+
+  // Ships are gone before the pattern is measured
+  if (self->escape.enabled && self->generation >= self->escape.next_check) {
+    engine_escape_check(self);
+  }
+  // Between two generations, nothing refers to the previous representation
+  if (self->automatic.enabled &&
+      self->generation >= self->automatic.next_check) {
+    engine_auto_switch(self);
+  }
+  return generations;
+}
+
+u64 engine_step_n(Engine *const self, u64 generations, f64 time_budget) {
+  const f64 deadline = timer_now() + time_budget;
+  u64 done = 0;
+
+  const u64 period = self->history.period;
+
+  // Automatic switching may move to hashlife between two steps: the kind is
+  // checked before each one. On hashlife, largest power of 2 steps first,
+  // then restore the step size
+  while (done < generations && (!done || timer_now() < deadline) &&
+         self->history.period == period) {
+    if (self->kind == engine_hashlife) {
+      const u32 msb = 63 - (u32)__builtin_clzll(generations - done);
+      hashlife_set_step_exp(&self->life, msb < HASHLIFE_MAX_STEP_EXP
+                                             ? msb
+                                             : HASHLIFE_MAX_STEP_EXP);
+    }
+    const u64 step = engine_step(self);
+    if (!step) {
+      break;
+    }
+    done += step;
+  }
+  hashlife_set_step_exp(&self->life, self->step_exp);
+
+  return done;
+}
+
+void engine_set_step_exp(Engine *const self, u32 step_exp) {
+  self->step_exp = step_exp;
+  hashlife_set_step_exp(&self->life, step_exp);
+}
+
+bool engine_kind_supports(EngineKind kind, Rule rule) {
+  return kind == engine_states || rule.family == rule_life_like;
+}
+
+void engine_set_rule(Engine *const self, Rule rule) {
+  // Cells are migrated with the states the current rule knows
+  if (!engine_kind_supports(self->kind, rule)) {
+    engine_set_kind(self, engine_states);
+  }
+
+  self->rule = rule;
+  sparse_set_rule(&self->sparse, rule);
+  self->tiles.rule = rule;
+  hashlife_set_rule(&self->life, rule);
+  statemap_set_rule(&self->states, rule);
+  self->list.rule = rule;
+  islands_set_rule(&self->islands, rule);
+  self->grid.rule = rule;
+  history_clear(&self->history);
+}
+
+bool engine_kind_contains(EngineKind kind, i64 x, i64 y) {
+  if (kind == engine_hashlife) {
+    return x >= -HASHLIFE_MAX_COORD && x < HASHLIFE_MAX_COORD &&
+           y >= -HASHLIFE_MAX_COORD && y < HASHLIFE_MAX_COORD;
+  }
+  return cellset_within(x, y);
+}
+
+bool engine_get_cell(const Engine *const self, i64 x, i64 y) {
+  return engine_get_state(self, x, y) != 0;
+}
+
+void engine_set_cell(Engine *const self, i64 x, i64 y, bool alive) {
+  engine_set_state(self, x, y, alive);
+}
+
+u8 engine_get_state(const Engine *const self, i64 x, i64 y) {
+  if (!engine_kind_contains(self->kind, x, y)) {
+    return 0;
+  }
+
+  // Kinds but hashlife are 32-bit
+  const i32 x32 = (i32)x;
+  const i32 y32 = (i32)y;
+  switch (self->kind) {
+  case engine_sparse:
+    return sparse_get_cell(&self->sparse, x32, y32);
+  case engine_tiled:
+    return tilemap_get_cell(&self->tiles, x32, y32);
+  case engine_hashlife:
+    return hashlife_get_cell(&self->life, x, y);
+  case engine_states:
+    return statemap_get_state(&self->states, x32, y32);
+  case engine_list:
+    return celllist_get_cell(&self->list, x32, y32);
+  case engine_islands:
+    return islands_get_cell(&self->islands, x32, y32);
+  case engine_bounded:
+    return bitgrid_get_cell(&self->grid, x32, y32);
+  default:
+    assert(0 && "Don't go here");
+    return 0;
+  }
+}
+
+void engine_set_state(Engine *const self, i64 x, i64 y, u8 state) {
+  if (!engine_kind_contains(self->kind, x, y)) {
+    return;
+  }
+
+  const bool alive = state != 0;
+  const i32 x32 = (i32)x;
+  const i32 y32 = (i32)y;
+
+  // Cells near the 32-bit edge go to hashlife before the next step
+  if (self->automatic.enabled && alive && self->kind != engine_hashlife &&
+      engine_auto_at_edge(x, y)) {
+    self->automatic.next_check = self->generation;
+  }
+
+  // Cycles found before the edit are over
+  history_clear(&self->history);
+
+  switch (self->kind) {
+  case engine_sparse:
+    sparse_set_cell(&self->sparse, x32, y32, alive);
+    break;
+  case engine_tiled:
+    tilemap_set_cell(&self->tiles, x32, y32, alive);
+    break;
+  case engine_hashlife:
+    hashlife_set_cell(&self->life, x, y, alive);
+    break;
+  case engine_states:
+    statemap_set_state(&self->states, x32, y32, state);
+    break;
+  case engine_list:
+    celllist_set_cell(&self->list, x32, y32, alive);
+    break;
+  case engine_islands:
+    islands_set_cell(&self->islands, x32, y32, alive);
+    break;
+  case engine_bounded:
+    bitgrid_set_cell(&self->grid, x32, y32, alive);
+    break;
+  default:
+    assert(0 && "Don't go here");
+  }
+}
+
+void engine_toggle_cell(Engine *const self, i64 x, i64 y) {
+  engine_set_state(self, x, y,
+                   rule_edit_next(self->rule, engine_get_state(self, x, y)));
+}
+
+u64 engine_population(const Engine *const self) {
+  switch (self->kind) {
+  case engine_sparse:
+    return sparse_population(&self->sparse);
+  case engine_tiled:
+    return self->tiles.population;
+  case engine_hashlife:
+    return hashlife_population(&self->life);
+  case engine_states:
+    return self->states.population;
+  case engine_list:
+    return self->list.population;
+  case engine_islands:
+    return islands_population(&self->islands);
+  case engine_bounded:
+    return self->grid.population;
+  default:
+    assert(0 && "Don't go here");
+    return 0;
+  }
+}
+
+u64 engine_hash(const Engine *const self) {
+  switch (self->kind) {
+  case engine_sparse:
+    return sparse_hash(&self->sparse);
+  case engine_tiled:
+    return self->tiles.hash;
+  case engine_hashlife:
+    return hashlife_universe_hash(&self->life);
+  case engine_states:
+    return self->states.hash;
+  case engine_list:
+    return self->list.hash;
+  case engine_islands:
+    return islands_hash(&self->islands);
+  case engine_bounded:
+    return self->grid.hash;
+  default:
+    assert(0 && "Don't go here");
+    return 0;
+  }
+}
+
+bool engine_cycle(const Engine *const self, u64 *const period,
+                  u64 *const cycle_start) {
+  *period = self->history.period;
+  *cycle_start = self->history.cycle_start;
+  return self->history.period != 0;
+}
+
+// Adapters between the cell & state callbacks, 32-bit kinds & the 64-bit API
+typedef struct EngineCellCtx {
+  EngineCellFn fn;
+  void *ctx;
+} EngineCellCtx;
+
+typedef struct EngineStateCtx {
+  EngineStateFn fn;
+  void *ctx;
+} EngineStateCtx;
+
+static void engine_cell_widen(void *const ctx, i32 x, i32 y) {
+  const EngineCellCtx *const cell_ctx = (const EngineCellCtx *)ctx;
+  cell_ctx->fn(cell_ctx->ctx, x, y);
+}
+
+static void engine_state_widen(void *const ctx, i32 x, i32 y, u8 state) {
+  const EngineStateCtx *const state_ctx = (const EngineStateCtx *)ctx;
+  state_ctx->fn(state_ctx->ctx, x, y, state);
+}
+
+static void engine_state_to_cell(void *const ctx, i32 x, i32 y, u8 state) {
+  (void)state;
+  const EngineCellCtx *const cell_ctx = (const EngineCellCtx *)ctx;
+  cell_ctx->fn(cell_ctx->ctx, x, y);
+}
+
+static void engine_cell_to_state(void *const ctx, i64 x, i64 y) {
+  const EngineStateCtx *const state_ctx = (const EngineStateCtx *)ctx;
+  state_ctx->fn(state_ctx->ctx, x, y, 1);
+}
+
+void engine_foreach_cell(const Engine *const self, CellRect64 rect,
+                         EngineCellFn fn, void *const ctx) {
+  if (self->kind == engine_hashlife) {
+    hashlife_foreach_cell(&self->life, rect, fn, ctx);
+    return;
+  }
+
+  // Other kinds only have cells with 32-bit coordinates
+  rect = cellrect64_clip32(rect);
+  if (cellrect64_is_empty(rect)) {
+    return;
+  }
+  const CellRect rect32 = cellrect64_narrow(rect);
+  EngineCellCtx cell_ctx = {.fn = fn, .ctx = ctx};
+
+  switch (self->kind) {
+  case engine_sparse:
+    sparse_foreach_cell(&self->sparse, rect32, &engine_cell_widen, &cell_ctx);
+    break;
+  case engine_tiled:
+    tilemap_foreach_cell(&self->tiles, rect32, &engine_cell_widen, &cell_ctx);
+    break;
+  case engine_states:
+    // Non-empty cells are the alive ones
+    statemap_foreach_cell(&self->states, rect32, &engine_state_to_cell,
+                          &cell_ctx);
+    break;
+  case engine_list:
+    celllist_foreach_cell(&self->list, rect32, &engine_cell_widen, &cell_ctx);
+    break;
+  case engine_islands:
+    islands_foreach_cell(&self->islands, rect32, &engine_cell_widen,
+                         &cell_ctx);
+    break;
+  case engine_bounded:
+    bitgrid_foreach_cell(&self->grid, rect32, &engine_cell_widen, &cell_ctx);
+    break;
+  default:
+    assert(0 && "Don't go here");
+  }
+}
+
+void engine_foreach_state(const Engine *const self, CellRect64 rect,
+                          EngineStateFn fn, void *const ctx) {
+  EngineStateCtx state_ctx = {.fn = fn, .ctx = ctx};
+
+  if (self->kind == engine_states) {
+    rect = cellrect64_clip32(rect);
+    if (!cellrect64_is_empty(rect)) {
+      statemap_foreach_cell(&self->states, cellrect64_narrow(rect),
+                            &engine_state_widen, &state_ctx);
+    }
+    return;
+  }
+
+  engine_foreach_cell(self, rect, &engine_cell_to_state, &state_ctx);
+}
+
+const char *engine_kind_name(EngineKind kind) {
+  assert(kind < engine_kind_count && "Unknown engine kind");
+  return engine_kind_names[kind];
+}
+
+const char *engine_ship_name(EngineShip ship) {
+  assert(ship < engine_ship_count && "Unknown spaceship");
+  return engine_ship_names[ship];
+}
+
+bool engine_kind_from_name(const char *const name, EngineKind *const kind) {
+  for (u32 i = 0; i < engine_kind_count; i++) {
+    if (!strcmp(name, engine_kind_names[i])) {
+      *kind = (EngineKind)i;
+      return true;
+    }
+  }
+  return false;
+}
@@ -16,11 +16,23 @@
 #pragma GCC diagnostic pop
 
 i32 gol_run(GolCtx *const self, i32 argc, char *argv[]) {
-  (void)argc;
-  (void)argv;
   Error err = {0};
 
-  gol_init(self, &err);
+  // Headless, no window is opened
+  if (argc > 1 && !strcmp(argv[1], "--bench")) {
+    return bench_run(argc - 2, argv + 2);
+  }
+
+  GolOptions options;
+  if (!gol_parse_options(argc, argv, &options)) {
+    fprintf(stderr, "Usage: %s [--plane|--torus|--klein WIDTHxHEIGHT] "
+                    "[--store DIR] [--store-budget MB]\n"
+                    "\tWIDTH is a multiple of %u, both up to %u\n",
+            argv[0], TILE_SIZE, BITGRID_MAX_SIZE);
+    return EXIT_FAILURE;
+  }
+
+  gol_init(self, &options, &err);
 
 #ifdef GOL_DEBUG
   SetTraceLogLevel(LOG_ALL);
@@ -46,38 +58,123 @@ i32 gol_run(GolCtx *const self, i32 argc, char *argv[]) {
   return EXIT_SUCCESS;
 }
 
-void gol_init(GolCtx *const self, Error *const err) {
+// WIDTHxHEIGHT of a bounded universe
+static bool gol_parse_size(const char *const str, GolOptions *const options) {
+  char *end;
+  const unsigned long width = strtoul(str, &end, 10);
+  if (*end != 'x' || end == str) {
+    return false;
+  }
+  const char *const height_str = end + 1;
+  const unsigned long height = strtoul(height_str, &end, 10);
+  if (*end || end == height_str || !width || !height ||
+      width % TILE_SIZE || width > BITGRID_MAX_SIZE ||
+      height > BITGRID_MAX_SIZE) {
+    return false;
+  }
+
+  options->bounded = true;
+  options->width = (u32)width;
+  options->height = (u32)height;
+  return true;
+}
+
+bool gol_parse_options(i32 argc, char *argv[], GolOptions *const options) {
+  *options = (GolOptions){0};
+
+  // Every option takes a value
+  for (i32 i = 1; i < argc; i += 2) {
+    if (i + 1 == argc || strncmp(argv[i], "--", 2)) {
+      return false;
+    }
+
+    const char *const value = argv[i + 1];
+    if (!strcmp(argv[i], "--store")) {
+      options->store_dir = value;
+    } else if (!strcmp(argv[i], "--store-budget")) {
+      char *end;
+      const unsigned long long budget = strtoull(value, &end, 10);
+      if (*end || end == value || budget > UINT64_MAX >> 20) {
+        return false;
+      }
+      options->store_budget = (u64)budget << 20;
+    } else if (options->bounded ||
+               !bitgrid_topology_from_name(argv[i] + 2, &options->topology) ||
+               !gol_parse_size(value, options)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void gol_init(GolCtx *const self, const GolOptions *const options,
+              Error *const err) {
 
   *self = (GolCtx){0};
+  self->options = *options;
 
   self->cmd = sdsempty();
 
+  // Pick the best tile kernel this CPU supports
+  kernel_init();
+  TraceLog(LOG_INFO, "Tile kernel: %s", kernel_name(kernel_selected()));
+
+  // One worker per hardware thread, the CCT being one of them
+  pool_create(&self->pool, 0, err);
+  if (err->status) {
+    TraceLog(LOG_FATAL, "Could not create thread pool:\n\t%s", err->msg);
+    return;
+  }
+  TraceLog(LOG_INFO, "Thread pool: %u threads", pool_thread_nb(&self->pool));
+  self->engine.pool = &self->pool;
+
   self->screen = (Rectangle){.width = GOL_INITIAL_SCREEN_WIDTH,
                              .height = GOL_INITIAL_SCREEN_HEIGHT,
                              .x = 0.0f,
                              .y = 0.0f};
   self->cell_size = GOL_INITIAL_GRID_WIDTH;
   self->cycle_period = GOL_INITIAL_CYCLE_PERIOD, self->draw_grid = true;
+  self->autopause = true;
+  // Empty, so the first frame sends the visible cells to the CCT
+  self->render_view =
+      (CellRect64){.min_x = 0, .min_y = 0, .max_x = -1, .max_y = -1};
 
   // Init arrays so it isn't NULL
-  arrsetcap(self->alive_cells_render_buffer_1, 50);
-  arrsetcap(self->alive_cells_render_buffer_2, 50);
+  arrsetcap(self->render_buffer_1.cells, 50);
+  arrsetcap(self->render_buffer_2.cells, 50);
 
   // srand((u32)time(NULL));
   // for (u32 i = 0; i < 100; i++) {
   //   for (u32 j = 0; j < 100; j++) {
   //     if ((rand() * 2.0 / RAND_MAX) > 0.5) {
-  //       const Vector2 cell = {
-  //           .x = floorf(((f32)rand() * 100.0f) / (f32)RAND_MAX),
-  //           .y = floorf(((f32)rand() * 100.0f) / (f32)RAND_MAX)};
-  //       hmput(self->alive_cells, cell, 0);
+  //       engine_set_cell(&self->engine, rand() % 100, rand() % 100, true);
   //     }
   //   }
   // }
-  for (u32 i = 0; i < 100; i++) {
-    for (u32 j = 0; j < 100; j++) {
-      const Vector2 cell = {.x = (f32)i, .y = (f32)j};
-      hmput(self->alive_cells, cell, 0);
+  engine_set_kind(&self->engine, GOL_INITIAL_ENGINE);
+  engine_set_automatic(&self->engine, !options->bounded);
+  if (options->store_dir) {
+    // Tiles stay in memory without a store
+    Error store_err = {0};
+    engine_set_store(&self->engine, options->store_dir,
+                     options->store_budget, &store_err);
+    if (store_err.status) {
+      TraceLog(LOG_WARNING, "Tile store: %s", store_err.msg);
+    } else {
+      TraceLog(LOG_INFO, "Tile store: %s, %lu MB resident at most",
+               options->store_dir, options->store_budget >> 20);
+    }
+  }
+  if (options->bounded) {
+    engine_set_bounds(&self->engine, options->topology, options->width,
+                      options->height);
+    TraceLog(LOG_INFO, "Universe: %ux%u %s", options->width, options->height,
+             bitgrid_topology_name(options->topology));
+  }
+  for (i32 i = 0; i < 100; i++) {
+    for (i32 j = 0; j < 100; j++) {
+      engine_set_cell(&self->engine, i, j, true);
     }
   }
 
@@ -101,13 +198,17 @@ void gol_init(GolCtx *const self, Error *const err) {
       .fifo = &self->cct_fifo,
       .cycle_period = &self->cycle_period,
       .cycle_nb = &self->cycle_nb,
+      .steps_left = &self->steps_left,
+      .play = &self->play,
+      .autopause = &self->autopause,
       .cycle_compute_time = &self->cycle_compute_time,
 
       .buffer_index = &self->buffer_index,
+      .stats = &self->stats,
       .buffer_index_mtx = &self->buffer_index_mtx,
-      .alive_cells = &self->alive_cells,
-      .alive_cells_render_buffer_1 = &self->alive_cells_render_buffer_1,
-      .alive_cells_render_buffer_2 = &self->alive_cells_render_buffer_2};
+      .engine = &self->engine,
+      .render_buffer_1 = &self->render_buffer_1,
+      .render_buffer_2 = &self->render_buffer_2};
 
   if (thrd_create(&self->cct, &gol_cct, cct_args) != thrd_success) {
     free(cct_args);
@@ -133,7 +234,7 @@ void gol_init(GolCtx *const self, Error *const err) {
 void gol_run_loop(GolCtx *self, Error *err) {
   gol_event(self, err);
 
-  gol_update(self);
+  gol_update(self, err);
 
   BeginDrawing();
 
@@ -192,17 +293,16 @@ void gol_event(GolCtx *const self, Error *const err) {
 #endif /* ifdef GOL_DEBUG */
 
     if (IsKeyPressed(KEY_C)) {
-      self->cam_pos.x = 0.0f;
-      self->cam_pos.y = 0.0f;
+      self->cam_cell = (GolCell){0};
+      self->cam_offset = (Vector2){0};
     }
 
     if (IsKeyPressed(KEY_G)) {
       self->draw_grid = !self->draw_grid;
     }
 
-    // Toggle Play
+    // Toggle Play, the CCT owns play since it pauses on cycles
     if (IsKeyPressed(KEY_SPACE)) {
-      self->play = !self->play;
       FifoMsg msg = {
           .state = gol_cct_toggle_play,
       };
@@ -226,6 +326,16 @@ void gol_event(GolCtx *const self, Error *const err) {
     if (IsKeyPressed(KEY_DOWN)) {
       self->cycle_period = (i32)((f32)self->cycle_period * 1.25f);
     }
+
+    // Generations per cycle (hashlife engine)
+    //
+    if (IsKeyPressed(KEY_RIGHT_BRACKET) &&
+        self->step_exp < HASHLIFE_MAX_STEP_EXP) {
+      gol_send_step_exp(self, self->step_exp + 1, err);
+    }
+    if (IsKeyPressed(KEY_LEFT_BRACKET) && self->step_exp > 0) {
+      gol_send_step_exp(self, self->step_exp - 1, err);
+    }
   }
 
   // Mouse on g_screen
@@ -234,11 +344,13 @@ void gol_event(GolCtx *const self, Error *const err) {
   if (self->mouse_on_g_screen) {
     // Compute mouse grid pos coordinate
     //
-    self->mouse_cell_coord = (Vector2){
-        .x = floorf((mouse_pos.x - self->g_screen.x + self->cam_pos.x) /
-                    self->cell_size),
-        .y = floorf((mouse_pos.y - self->g_screen.y + self->cam_pos.y) /
-                    self->cell_size)};
+    self->mouse_cell_coord = (GolCell){
+        .x = self->cam_cell.x +
+             (i64)floorf((mouse_pos.x - self->g_screen.x + self->cam_offset.x) /
+                         self->cell_size),
+        .y = self->cam_cell.y +
+             (i64)floorf((mouse_pos.y - self->g_screen.y + self->cam_offset.y) /
+                         self->cell_size)};
 
     if (IsKeyDown(KEY_LEFT_CONTROL)) {
       // Mouse Left + Ctrl: toggle cell
@@ -275,24 +387,239 @@ void gol_event(GolCtx *const self, Error *const err) {
   // Mouse wheel gri_width change
   //
   if (self->cell_size + mouse_wheel.y > 0.0f) {
+    // Same part of cam_cell at the corner
+    const f32 scale = (self->cell_size + mouse_wheel.y) / self->cell_size;
+    self->cam_offset.x *= scale;
+    self->cam_offset.y *= scale;
     self->cell_size += mouse_wheel.y;
   }
 }
 
-void gol_update(GolCtx *const self) {
+// Moves the camera along one axis: whole cells go to cell, so offset stays
+// within a cell & as precise anywhere in the universe as around the origin
+static void gol_move_camera_axis(i64 *const cell, f32 *const offset,
+                                 f32 pixels, f32 cell_size) {
+  const f32 pos = *offset + pixels;
+  const f32 cells = floorf(pos / cell_size);
+  *offset = fmaxf(pos - cells * cell_size, 0.0f);
+
+  // Far enough for any engine, & cell differences to the camera never
+  // overflow
+  *cell = *cell + (i64)cells;
+  if (*cell < -HASHLIFE_MAX_COORD) {
+    *cell = -HASHLIFE_MAX_COORD;
+  } else if (*cell > HASHLIFE_MAX_COORD) {
+    *cell = HASHLIFE_MAX_COORD;
+  }
+}
+
+void gol_update(GolCtx *const self, Error *const err) {
   // Update cam position
   //
-  self->cam_pos.x += self->velocity.x;
-  self->cam_pos.y += self->velocity.y;
+  gol_move_camera_axis(&self->cam_cell.x, &self->cam_offset.x,
+                       self->velocity.x, self->cell_size);
+  gol_move_camera_axis(&self->cam_cell.y, &self->cam_offset.y,
+                       self->velocity.y, self->cell_size);
+
+  gol_update_view(self, err);
 
   if (self->process_cmd) {
-    self->close = !strcmp(self->cmd, ":q");
+    gol_process_cmd(self, err);
     // Clear command
     sdsrange(self->cmd, 1, 0);
     self->process_cmd = false;
   }
 }
 
+void gol_update_view(GolCtx *const self, Error *const err) {
+  // Visible cells
+  //
+  const i64 left = self->cam_cell.x;
+  const i64 top = self->cam_cell.y;
+  const i64 width = (i64)ceilf(self->g_screen.width / self->cell_size) + 1;
+  const i64 height = (i64)ceilf(self->g_screen.height / self->cell_size) + 1;
+
+  if (cellrect64_contains(self->render_view, left, top) &&
+      cellrect64_contains(self->render_view, left + width, top + height)) {
+    return;
+  }
+
+  // Keep one screen of margin on each side, so dragging the camera doesn't
+  // send a new view every frame
+  self->render_view = (CellRect64){.min_x = left - width,
+                                   .min_y = top - height,
+                                   .max_x = left + 2 * width,
+                                   .max_y = top + 2 * height};
+
+  // Malloc must be freed in the thread enqueue succeeded!
+  FifoMsg msg = {.state = gol_cct_set_view,
+                 .data = malloc(sizeof(GolMsgDataView))};
+  assert(msg.data && "Not enough memory, this is the end...");
+
+  ((GolMsgDataView *)msg.data)->view = self->render_view;
+  fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
+
+  if (err->status) {
+    TraceLog(LOG_FATAL, "Could not message thread...\n\t%s", err->msg);
+  }
+}
+
+void gol_send_step(GolCtx *const self, u64 generations, Error *const err) {
+  // Malloc must be freed in the thread enqueue succeeded!
+  FifoMsg msg = {.state = gol_cct_step,
+                 .data = malloc(sizeof(GolMsgDataStep))};
+  assert(msg.data && "Not enough memory, this is the end...");
+
+  ((GolMsgDataStep *)msg.data)->generations = generations;
+  fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
+
+  if (err->status) {
+    TraceLog(LOG_FATAL, "Could not message thread...\n\t%s", err->msg);
+  }
+}
+
+void gol_send_step_exp(GolCtx *const self, u32 step_exp, Error *const err) {
+  self->step_exp = step_exp;
+
+  // Malloc must be freed in the thread enqueue succeeded!
+  FifoMsg msg = {.state = gol_cct_set_step_exp,
+                 .data = malloc(sizeof(GolMsgDataStepExp))};
+  assert(msg.data && "Not enough memory, this is the end...");
+
+  ((GolMsgDataStepExp *)msg.data)->step_exp = step_exp;
+  fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
+
+  if (err->status) {
+    TraceLog(LOG_FATAL, "Could not message thread...\n\t%s", err->msg);
+  }
+}
+
+void gol_process_cmd(GolCtx *const self, Error *const err) {
+  i32 argc = 0;
+  sds *argv = sdssplitargs(self->cmd, &argc);
+
+  if (!argv || !argc) {
+    TraceLog(LOG_WARNING, "Invalid command: %s", self->cmd);
+  } else if (!strcmp(argv[0], ":q")) {
+    self->close = true;
+  } else if (!strcmp(argv[0], ":engine") && argc == 2) {
+    // :engine <auto|sparse|tiled|hashlife|states|list|islands>
+    //
+    EngineKind kind = engine_sparse;
+    const bool automatic = !strcmp(argv[1], "auto");
+    if (!automatic && !engine_kind_from_name(argv[1], &kind)) {
+      TraceLog(LOG_WARNING, "Unknown engine: %s", argv[1]);
+    } else {
+      // Malloc must be freed in the thread enqueue succeeded!
+      FifoMsg msg = {.state = gol_cct_set_engine,
+                     .data = malloc(sizeof(GolMsgDataEngine))};
+      assert(msg.data && "Not enough memory, this is the end...");
+
+      ((GolMsgDataEngine *)msg.data)->kind = kind;
+      ((GolMsgDataEngine *)msg.data)->automatic = automatic;
+      fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
+
+      if (err->status) {
+        TraceLog(LOG_FATAL, "Could not message thread...\n\t%s", err->msg);
+      }
+    }
+  } else if (!strcmp(argv[0], ":kernel") && argc == 2) {
+    // :kernel <auto|scalar|sse2|avx2|avx512>
+    //
+    KernelKind kind = kernel_best();
+    if (strcmp(argv[1], "auto") && !kernel_from_name(argv[1], &kind)) {
+      TraceLog(LOG_WARNING, "Unknown kernel: %s", argv[1]);
+    } else if (!kernel_supported(kind)) {
+      TraceLog(LOG_WARNING, "Kernel not supported by this CPU: %s", argv[1]);
+    } else {
+      // Malloc must be freed in the thread enqueue succeeded!
+      FifoMsg msg = {.state = gol_cct_set_kernel,
+                     .data = malloc(sizeof(GolMsgDataKernel))};
+      assert(msg.data && "Not enough memory, this is the end...");
+
+      ((GolMsgDataKernel *)msg.data)->kind = kind;
+      fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
+
+      if (err->status) {
+        TraceLog(LOG_FATAL, "Could not message thread...\n\t%s", err->msg);
+      }
+    }
+  } else if (!strcmp(argv[0], ":step") && argc == 2) {
+    // :step <n>, n generations as fast as possible, 0 stops
+    //
+    char *end;
+    const unsigned long long generations = strtoull(argv[1], &end, 10);
+    if (*end || end == argv[1]) {
+      TraceLog(LOG_WARNING, "Invalid number of generations: %s", argv[1]);
+    } else {
+      gol_send_step(self, generations, err);
+    }
+  } else if (!strcmp(argv[0], ":stepexp") && argc == 2) {
+    // :stepexp <k>, 2^k generations per cycle
+    //
+    char *end;
+    const unsigned long step_exp = strtoul(argv[1], &end, 10);
+    if (*end || end == argv[1] || step_exp > HASHLIFE_MAX_STEP_EXP) {
+      TraceLog(LOG_WARNING, "Invalid step exponent (0 to %d): %s",
+               HASHLIFE_MAX_STEP_EXP, argv[1]);
+    } else {
+      gol_send_step_exp(self, (u32)step_exp, err);
+    }
+  } else if (!strcmp(argv[0], ":rule") && argc == 2) {
+    // :rule <B3/S23|B2-a/S12|B2/S/C3|R5,C0,M1,S34..58,B34..45,NM|life|
+    //        highlife|daynight|seeds|brain|starwars|wireworld|bosco|majority>
+    //
+    Rule rule;
+    if (!rule_parse(argv[1], &rule)) {
+      TraceLog(LOG_WARNING, "Invalid rule: %s", argv[1]);
+    } else {
+      // Malloc must be freed in the thread enqueue succeeded!
+      FifoMsg msg = {.state = gol_cct_set_rule,
+                     .data = malloc(sizeof(GolMsgDataRule))};
+      assert(msg.data && "Not enough memory, this is the end...");
+
+      ((GolMsgDataRule *)msg.data)->rule = rule;
+      fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
+
+      if (err->status) {
+        TraceLog(LOG_FATAL, "Could not message thread...\n\t%s", err->msg);
+      }
+    }
+  } else if (!strcmp(argv[0], ":escapes") && argc == 2) {
+    // :escapes <on|off>, remove the spaceships escaping the pattern
+    //
+    if (!strcmp(argv[1], "on") || !strcmp(argv[1], "off")) {
+      // Malloc must be freed in the thread enqueue succeeded!
+      FifoMsg msg = {.state = gol_cct_set_escape,
+                     .data = malloc(sizeof(GolMsgDataEscape))};
+      assert(msg.data && "Not enough memory, this is the end...");
+
+      ((GolMsgDataEscape *)msg.data)->enabled = !strcmp(argv[1], "on");
+      fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
+
+      if (err->status) {
+        TraceLog(LOG_FATAL, "Could not message thread...\n\t%s", err->msg);
+      }
+    } else {
+      TraceLog(LOG_WARNING, "Invalid escapes (on or off): %s", argv[1]);
+    }
+  } else if (!strcmp(argv[0], ":autopause") && argc == 2) {
+    // :autopause <on|off>, pause when the universe becomes static or periodic
+    //
+    if (!strcmp(argv[1], "on") || !strcmp(argv[1], "off")) {
+      self->autopause = !strcmp(argv[1], "on");
+    } else {
+      TraceLog(LOG_WARNING, "Invalid autopause (on or off): %s", argv[1]);
+    }
+  } else {
+    TraceLog(LOG_WARNING, "Unknown command: %s", self->cmd);
+  }
+
+  if (argv) {
+    sdsfreesplitres(argv, argc);
+  }
+}
+
 i32 gol_cct(void *arg) {
   GolCctArgs *args = (GolCctArgs *)arg;
 
@@ -301,22 +628,44 @@ i32 gol_cct(void *arg) {
   FifoMsg msg = {.state = gol_cct_compute};
   Error err = {0};
   f64 cycle_last_update = 0.0;
-  bool play = false;
+  bool *const play = args->play;
+  bool cycle_reported = false; // The cycle found since the last edit is logged
+  u64 escape_reported = 0; // Generation of the last removal logged
+  // Until the main thread sends the visible one
+  CellRect64 view = CELLRECT64_ALL;
+
+  // Computed generations are published at most once per frame
+  f64 render_last_update = 0.0;
+  bool render_outdated = false;
 
-  gol_cct_upddate_render_buffer(args, *args->alive_cells, &err);
+  gol_cct_upddate_render_buffer(args, args->engine, view, &err);
 
   while (msg.state != gol_cct_quit && !err.status) {
-    i32 timeout_ms;
-    if (play) {
+    const f64 time = GetTime();
+
+    if (render_outdated && time - render_last_update >= 1.0 / GOL_FPS) {
+      gol_cct_upddate_render_buffer(args, args->engine, view, &err);
+      render_last_update = time;
+      render_outdated = false;
+    }
+
+    // Wait for a message until there is something to compute or publish,
+    // forever if there is nothing to do
+    //
+    f64 timeout = INFINITY;
+    if (*args->steps_left) {
+      timeout = 0.0;
+    } else if (*play) {
       // Take compute time into account
-      timeout_ms =
-          *args->cycle_period - ((i32)((GetTime() - cycle_last_update) * 1e3));
-      if (timeout_ms < 0) {
-        timeout_ms = 0;
-      }
-    } else {
-      timeout_ms = -1;
+      timeout = *args->cycle_period * 1e-3 - (time - cycle_last_update);
     }
+    if (render_outdated) {
+      timeout = fmin(timeout, 1.0 / GOL_FPS - (time - render_last_update));
+    }
+    const i32 timeout_ms = isinf(timeout) ? -1
+                           : timeout > 0.0 ? (i32)(timeout * 1e3)
+                                           : 0;
+
     msg = fifo_dequeue_msg(args->fifo, timeout_ms, &err);
     if (err.status) {
       if (err.code == error_timeout) {
@@ -338,7 +687,7 @@ i32 gol_cct(void *arg) {
     } break;
 
     case gol_cct_toggle_play:
-      play = !play;
+      *play = !*play;
       msg.state = gol_cct_compute;
       fifo_enqueue_msg(args->fifo, msg, -1, &err);
       break;
@@ -347,80 +696,196 @@ i32 gol_cct(void *arg) {
 
       GolMsgDataToggle *msg_data = (GolMsgDataToggle *)msg.data;
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wsign-conversion"
-      const bool found = hmdel(*args->alive_cells, msg_data->cell_coord);
-#pragma GCC diagnostic pop
-      if (!found) {
-        hmput(*args->alive_cells, msg_data->cell_coord, 0);
+      const GolCell cell = msg_data->cell_coord;
+      if (!engine_kind_contains(args->engine->kind, cell.x, cell.y)) {
+        TraceLog(LOG_WARNING, "Cell (%ld, %ld) is out of the %s engine", cell.x,
+                 cell.y, engine_kind_name(args->engine->kind));
       }
+      engine_toggle_cell(args->engine, cell.x, cell.y);
 
-      gol_cct_upddate_render_buffer(args, *args->alive_cells, &err);
+      gol_cct_upddate_render_buffer(args, args->engine, view, &err);
 
       free(msg_data);
     } break;
 
-    case gol_cct_compute: {
-
-      const f64 time_start = GetTime();
+    case gol_cct_set_engine: {
+
+      GolMsgDataEngine *msg_data = (GolMsgDataEngine *)msg.data;
+
+      if (msg_data->automatic) {
+        // Bounded universes & multi-state rules keep their engine
+        engine_set_automatic(args->engine, true);
+        TraceLog(LOG_INFO, "CCT: automatic engine switching");
+        render_outdated = true;
+      } else if ((msg_data->kind == engine_bounded) !=
+                 (args->engine->kind == engine_bounded)) {
+        // The bounds would be lost
+        TraceLog(LOG_WARNING, "CCT: only bounded universes run on the %s "
+                              "engine, see --plane, --torus & --klein",
+                 engine_kind_name(engine_bounded));
+      } else if (!engine_kind_supports(msg_data->kind, args->engine->rule)) {
+        // Multi-state rules only run on the states engine
+        TraceLog(LOG_WARNING, "CCT: %s engine doesn't support the rule",
+                 engine_kind_name(msg_data->kind));
+      } else {
+        // A kind picked by hand sticks
+        engine_set_automatic(args->engine, false);
+        engine_set_kind(args->engine, msg_data->kind);
+        TraceLog(LOG_INFO, "CCT: switched to %s engine",
+                 engine_kind_name(msg_data->kind));
 
-      // Iterate over alive cells to build a neighbour map of the board
-      //
-      GolCellMap *neighbour = NULL;
-
-      for (u32 i = 0; i < hmlen(*args->alive_cells); i++) {
-        // Search cell 8 neighbour
-        for (f32 x = (*args->alive_cells)[i].key.x - 1.0f;
-             x <= (*args->alive_cells)[i].key.x + 1.0f; x++) {
-          for (f32 y = (*args->alive_cells)[i].key.y - 1.0f;
-               y <= (*args->alive_cells)[i].key.y + 1.0f; y++) {
-
-            const Vector2 adj_cell = {.x = x, .y = y};
-            const ptrdiff_t index = hmgeti(neighbour, adj_cell);
-
-            if (index == -1) {
-              // Doesn't exists
-              if ((*args->alive_cells)[i].key.x == x &&
-                  (*args->alive_cells)[i].key.y == y) {
-                // Current cell
-                hmput(neighbour, adj_cell, 0);
-              } else {
-                // Not current cell
-                hmput(neighbour, adj_cell, 1);
-              }
-            } else {
-              // Exists
-              if (!((*args->alive_cells)[i].key.x == x &&
-                    (*args->alive_cells)[i].key.y == y)) {
-                // Not Current cell
-                neighbour[index].value += 1;
-              }
-            }
-          }
-        }
+        gol_cct_upddate_render_buffer(args, args->engine, view, &err);
       }
 
-      // Iterate over the neighbour map and add or remove alive cells
-      // depending on count
-      for (u32 i = 0; i < hmlen(neighbour); i++) {
-        if (neighbour[i].value < 2 || neighbour[i].value > 3) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-value"
-#pragma GCC diagnostic ignored "-Wsign-conversion"
-          hmdel(*args->alive_cells, neighbour[i].key);
-#pragma GCC diagnostic pop
-        } else if (neighbour[i].value == 3) {
-          hmput(*args->alive_cells, neighbour[i].key, 0);
-        }
+      free(msg_data);
+    } break;
+
+    case gol_cct_set_kernel: {
+
+      GolMsgDataKernel *msg_data = (GolMsgDataKernel *)msg.data;
+
+      // Kernels are interchangeable between two cycles
+      kernel_select(msg_data->kind);
+      TraceLog(LOG_INFO, "CCT: switched to %s kernel",
+               kernel_name(msg_data->kind));
+      render_outdated = true;
+
+      free(msg_data);
+    } break;
+
+    case gol_cct_set_step_exp: {
+
+      GolMsgDataStepExp *msg_data = (GolMsgDataStepExp *)msg.data;
+
+      engine_set_step_exp(args->engine, msg_data->step_exp);
+
+      free(msg_data);
+    } break;
+
+    case gol_cct_set_rule: {
+
+      GolMsgDataRule *msg_data = (GolMsgDataRule *)msg.data;
+
+      char rule_str[RULE_STR_SIZE];
+      const EngineKind kind = args->engine->kind;
+      rule_format(msg_data->rule, rule_str);
+      // Switching to the states engine would lose the bounds
+      if (kind == engine_bounded &&
+          !engine_kind_supports(kind, msg_data->rule)) {
+        TraceLog(LOG_WARNING,
+                 "CCT: bounded universes only run two-state rules: %s",
+                 rule_str);
+        free(msg_data);
+        break;
       }
+      engine_set_rule(args->engine, msg_data->rule);
+      TraceLog(LOG_INFO, "CCT: switched to rule %s", rule_str);
+      if (args->engine->kind != kind) {
+        TraceLog(LOG_INFO, "CCT: switched to %s engine",
+                 engine_kind_name(args->engine->kind));
+      }
+
+      // States have other colours
+      gol_cct_upddate_render_buffer(args, args->engine, view, &err);
+
+      free(msg_data);
+    } break;
+
+    case gol_cct_set_escape: {
+
+      GolMsgDataEscape *msg_data = (GolMsgDataEscape *)msg.data;
+
+      // Bounded universes & multi-state rules keep their cells
+      engine_set_escape(args->engine, msg_data->enabled);
+      escape_reported = 0;
+      TraceLog(LOG_INFO, "CCT: escaping spaceships %s",
+               msg_data->enabled ? "removed" : "kept");
+      render_outdated = true;
+
+      free(msg_data);
+    } break;
+
+    case gol_cct_set_view: {
+
+      GolMsgDataView *msg_data = (GolMsgDataView *)msg.data;
+
+      view = msg_data->view;
+      gol_cct_upddate_render_buffer(args, args->engine, view, &err);
+
+      free(msg_data);
+    } break;
+
+    case gol_cct_step: {
+
+      GolMsgDataStep *msg_data = (GolMsgDataStep *)msg.data;
+
+      // Replaces the steps left, 0 cancels them
+      *args->steps_left = msg_data->generations;
+
+      free(msg_data);
+    } break;
+
+    case gol_cct_compute: {
 
-      hmfree(neighbour);
+      const f64 time_start = GetTime();
+      u64 generations;
+
+      if (*args->steps_left) {
+        // As many generations as a frame allows, then check messages
+        generations =
+            engine_step_n(args->engine, *args->steps_left, 1.0 / GOL_FPS);
+        *args->steps_left -= generations;
+      } else if (*play && time_start - cycle_last_update >=
+                             *args->cycle_period * 1e-3) {
+        generations = engine_step(args->engine);
+      } else {
+        break;
+      }
 
-      gol_cct_upddate_render_buffer(args, *args->alive_cells, &err);
+      // Cells too far from the origin for hashlife: whatever is asked, the
+      // universe can't go on
+      if (!generations) {
+        TraceLog(LOG_WARNING,
+                 "CCT: universe too large to step past generation %lu",
+                 args->engine->generation);
+        *play = false;
+        *args->steps_left = 0;
+        break;
+      }
 
-      *args->cycle_nb += 1;
+      *args->cycle_nb += generations;
       cycle_last_update = GetTime();
       *args->cycle_compute_time = cycle_last_update - time_start;
+      render_outdated = true;
+
+      // Static or periodic universe, engine_step_n stops on the step that
+      // finds it
+      u64 period, cycle_start;
+      const bool cycle = engine_cycle(args->engine, &period, &cycle_start);
+      if (cycle && !cycle_reported) {
+        TraceLog(LOG_INFO, "CCT: %s of period %lu from generation %lu",
+                 period == 1 ? "static universe" : "cycle", period,
+                 cycle_start);
+        if (*args->autopause) {
+          *play = false;
+          *args->steps_left = 0;
+        }
+      }
+      cycle_reported = cycle;
+
+      const EngineEscape *const escape = &args->engine->escape;
+      if (escape->last_generation > escape_reported) {
+        TraceLog(LOG_INFO,
+                 "CCT: escaping spaceships removed by generation %lu: %lu "
+                 "gliders, %lu LWSS, %lu MWSS, %lu HWSS, %lu others (%lu "
+                 "cells)",
+                 escape->last_generation, escape->ship_nb[engine_ship_glider],
+                 escape->ship_nb[engine_ship_lwss],
+                 escape->ship_nb[engine_ship_mwss],
+                 escape->ship_nb[engine_ship_hwss],
+                 escape->ship_nb[engine_ship_other], escape->cell_nb);
+      }
+      escape_reported = escape->last_generation;
 
     } break;
 
@@ -437,26 +902,68 @@ i32 gol_cct(void *arg) {
   return err.status;
 }
 
+static GolStats gol_cct_stats(const Engine *const engine) {
+  const TileMap *const tiles = &engine->tiles;
+  const StateMap *const states = &engine->states;
+  const TilePool *const bits_pool = &tiles->bits_pool;
+  GolStats stats = {
+      .kind = engine->kind,
+      .rule = engine->rule,
+      .population = engine_population(engine),
+      .kernel = kernel_selected(),
+      .node_nb = engine->life.node_nb,
+      .period = engine->history.period,
+      .cycle_start = engine->history.cycle_start,
+      .arena_used = engine->arena.last_used,
+      .arena_alloc_nb = engine->arena.last_alloc_nb,
+      .arena_time = engine->arena.last_time,
+      .automatic = engine->automatic,
+      .store = bits_pool->base != NULL,
+      .bits_resident =
+          bits_pool->base ? bits_pool->resident_nb * TILEPOOL_STORE_SLAB_SIZE
+                          : bits_pool->capacity * bits_pool->size,
+      .bits_bytes = bits_pool->capacity * bits_pool->size,
+      .bits_evicted_nb = bits_pool->evicted_nb,
+      .island_nb = arrlenu(engine->islands.islands),
+      .merge_nb = engine->islands.merge_nb,
+      .split_nb = engine->islands.split_nb,
+      .escape = engine->escape};
+
+  // Kernel throughput is only meaningful for the tiled engines
+  const TilePool *tile_pool = &tiles->tile_pool;
+  if (engine->kind == engine_tiled && tiles->compute_time > 0.0) {
+    stats.kernel_rate =
+        (f64)tiles->cells_computed / tiles->compute_time * 1e-6;
+  } else if (engine->kind == engine_states && states->compute_time > 0.0) {
+    stats.kernel_rate =
+        (f64)states->cells_computed / states->compute_time * 1e-6;
+  }
+  if (engine->kind == engine_states) {
+    stats.active_nb = states->active_nb;
+    stats.tile_nb = arrlenu(states->tiles);
+    tile_pool = &states->tile_pool;
+  } else {
+    stats.active_nb = tiles->active_nb;
+    stats.tile_nb = arrlenu(tiles->tiles);
+  }
+  stats.pool_count = tile_pool->count;
+  stats.pool_capacity = tile_pool->capacity;
+  stats.pool_bytes = tile_pool->capacity * tile_pool->size;
+
+  return stats;
+}
+
 void gol_cct_upddate_render_buffer(GolCctArgs *const args,
-                                   const GolCellMap *const alive_cells,
-                                   Error *const err) {
+                                   const Engine *const engine,
+                                   const CellRect64 view, Error *const err) {
 
   // Isolate the buffer to change. At this point, buffer_index still point
   // to the buffer used for render. It's why index 0 returns buffer n°2, not
   // n°1
-  Vector2 **alive_cells_render_buffer = *args->buffer_index
-                                            ? args->alive_cells_render_buffer_2
-                                            : args->alive_cells_render_buffer_1;
-
-  // Clear the buffer (should be fast since it sets length to 0 and memmove
-  // 0 bytes)
-  arrdeln(*alive_cells_render_buffer, 0, arrlenu(*alive_cells_render_buffer));
-
-  // Iterate over alive cells to build alive_cells_render_buffer
-  //
-  for (u32 i = 0; i < hmlen(alive_cells); i++) {
-    arrput(*alive_cells_render_buffer, alive_cells[i].key);
-  }
+  RenderBuffer *const render_buffer =
+      *args->buffer_index ? args->render_buffer_2 : args->render_buffer_1;
+  render_buffer_fill(render_buffer, engine, view);
+  const GolStats stats = gol_cct_stats(engine);
 
   if (mtx_lock(args->buffer_index_mtx) != thrd_success) {
     err->msg = "Could not lock Mutex (" error_print_err_location ").";
@@ -466,6 +973,7 @@ void gol_cct_upddate_render_buffer(GolCctArgs *const args,
   }
   // Toggle index 0<->1
   *args->buffer_index ^= 1;
+  *args->stats = stats;
 
   if (mtx_unlock(args->buffer_index_mtx) != thrd_success) {
     err->msg = "Could not unlock Mutex (" error_print_err_location ").";
@@ -491,8 +999,9 @@ void gol_draw(GolCtx *const self, Error *const err) {
       gol_draw_grid(self);
     }
     gol_draw_cells(self, err);
+    gol_draw_bounds(self);
     gol_draw_hovered_cell(self);
-    gol_draw_dbg(self);
+    gol_draw_dbg(self, err);
 
   } else
 #endif /* ifdef GOL_DEBUG */
@@ -502,27 +1011,39 @@ void gol_draw(GolCtx *const self, Error *const err) {
       gol_draw_grid(self);
     }
     gol_draw_cells(self, err);
+    gol_draw_bounds(self);
     gol_draw_hovered_cell(self);
   }
 }
 
+// Top left corner of a cell on screen. Only the difference to the camera cell
+// is converted to a float, it stays exact however far the camera is
+static Vector2 gol_cell_on_screen(const GolCtx *const self, i64 x, i64 y) {
+  return (Vector2){
+      .x = (f32)(x - self->cam_cell.x) * self->cell_size - self->cam_offset.x +
+           self->g_screen.x,
+      .y = (f32)(y - self->cam_cell.y) * self->cell_size - self->cam_offset.y +
+           self->g_screen.y};
+}
+
 void gol_draw_grid(const GolCtx *const self) {
 
   Vector2 start_pos, end_pos;
 
-  i32 i = 0; // For debug
-
-  // Compute interval between cam_pos and the closest lines from the left/top
-  const Vector2 grid_frac = {.x = -1.0f * self->cam_pos.x / self->cell_size,
-                             .y = -1.0f * self->cam_pos.y / self->cell_size};
+  // First lines within g_screen, on the left/top edge of cam_cell unless the
+  // cell is partly hidden
+  const GolCell first = {.x = self->cam_offset.x > 0.0f,
+                         .y = self->cam_offset.y > 0.0f};
   const Vector2 offset = {
-      .x = (grid_frac.x - floorf(grid_frac.x)) * self->cell_size,
-      .y = (grid_frac.y - floorf(grid_frac.y)) * self->cell_size};
+      .x = (f32)first.x * self->cell_size - self->cam_offset.x,
+      .y = (f32)first.y * self->cell_size - self->cam_offset.y};
+
+  i64 i = 0; // For debug
 
   // Draw Vertical Lines
   //
   // Start by drawing the first leftmost vertical line
-  i = 0; // For debug
+  i = self->cam_cell.x + first.x; // For debug
   for (f32 x = self->g_screen.x + offset.x;
        x <= self->g_screen.x + self->g_screen.width; x += self->cell_size) {
     start_pos.x = x;
@@ -536,7 +1057,7 @@ void gol_draw_grid(const GolCtx *const self) {
     if (self->show_dbg) {
       // x coord on each line
       DrawTextPro(GetFontDefault(),
-                  TextFormat("x: %d", (i32)(truncf(-1.0f * grid_frac.x)) + i),
+                  TextFormat("x: %ld", i),
                   (Vector2){.x = x, .y = self->g_screen.y + 5},
                   (Vector2){.x = 0.0f, .y = 10.0f}, 90.0f, 10.0f, 2.0f, PURPLE);
       i += 1; // Increment
@@ -548,7 +1069,7 @@ void gol_draw_grid(const GolCtx *const self) {
   // Draw Horizontal Lines
   //
   // Start by drawing the first topmost horizontal line
-  i = 0; // For debug
+  i = self->cam_cell.y + first.y; // For debug
   for (f32 y = self->g_screen.y + offset.y;
        y <= self->g_screen.y + self->g_screen.height; y += self->cell_size) {
     start_pos.x = self->g_screen.x;
@@ -562,7 +1083,7 @@ void gol_draw_grid(const GolCtx *const self) {
     if (self->show_dbg) {
       // x coord on each line
       DrawTextPro(GetFontDefault(),
-                  TextFormat("y: %d", (i32)(truncf(-1.0f * grid_frac.y)) + i),
+                  TextFormat("y: %ld", i),
                   (Vector2){.x = self->g_screen.x + 5, .y = y}, (Vector2){0},
                   0.0f, 10.0f, 2.0f, PURPLE);
       i += 1; // Increment
@@ -572,10 +1093,6 @@ void gol_draw_grid(const GolCtx *const self) {
 }
 
 void gol_draw_cells(GolCtx *const self, Error *const err) {
-  const Rectangle cam_window = {.x = self->cam_pos.x,
-                                .y = self->cam_pos.y,
-                                .width = self->g_screen.width,
-                                .height = self->g_screen.height};
   const f32 cell_size_offset =
       self->cell_size * (1.0f - GOL_ALIVE_CELL_SIZE_RATIO);
   const f32 cell_pos_offset = cell_size_offset / 2;
@@ -588,27 +1105,31 @@ void gol_draw_cells(GolCtx *const self, Error *const err) {
     return;
   }
 
-  const Vector2 *const alive_cells_render_buffer =
-      self->buffer_index ? self->alive_cells_render_buffer_1
-                         : self->alive_cells_render_buffer_2;
-
-  for (u32 i = 0; i < arrlen(alive_cells_render_buffer); i++) {
-    const Rectangle cell_rec = {
-        .x = alive_cells_render_buffer[i].x * self->cell_size,
-        .y = alive_cells_render_buffer[i].y * self->cell_size,
-        .width = self->cell_size,
-        .height = self->cell_size};
-    if (CheckCollisionRecs(cell_rec, cam_window)) {
-      Rectangle cell_to_draw = GetCollisionRec(cell_rec, cam_window);
-
-      cell_to_draw.x =
-          cell_to_draw.x - self->cam_pos.x + self->g_screen.x + cell_pos_offset;
-      cell_to_draw.y =
-          cell_to_draw.y - self->cam_pos.y + self->g_screen.y + cell_pos_offset;
-      cell_to_draw.width -= cell_size_offset;
-      cell_to_draw.height -= cell_size_offset;
-
-      DrawRectangleRec(cell_to_draw, BLACK);
+  const RenderBuffer *const render_buffer =
+      self->buffer_index ? &self->render_buffer_1 : &self->render_buffer_2;
+
+  // One colour per run of cells of the same state
+  for (u32 state = 1; state < rule_states(render_buffer->rule); state++) {
+    const Color color = gol_state_color(render_buffer->rule, (u8)state);
+
+    for (u32 i = render_buffer->ends[state - 1]; i < render_buffer->ends[state];
+         i++) {
+      const Vector2 pos = gol_cell_on_screen(self, render_buffer->cells[i].x,
+                                             render_buffer->cells[i].y);
+      const Rectangle cell_rec = {.x = pos.x,
+                                  .y = pos.y,
+                                  .width = self->cell_size,
+                                  .height = self->cell_size};
+      if (CheckCollisionRecs(cell_rec, self->g_screen)) {
+        Rectangle cell_to_draw = GetCollisionRec(cell_rec, self->g_screen);
+
+        cell_to_draw.x += cell_pos_offset;
+        cell_to_draw.y += cell_pos_offset;
+        cell_to_draw.width -= cell_size_offset;
+        cell_to_draw.height -= cell_size_offset;
+
+        DrawRectangleRec(cell_to_draw, color);
+      }
     }
   }
 
@@ -621,28 +1142,59 @@ void gol_draw_cells(GolCtx *const self, Error *const err) {
   }
 }
 
+Color gol_state_color(Rule rule, u8 state) {
+  if (rule.family == rule_wireworld) {
+    switch (state) {
+    case RULE_WIREWORLD_HEAD:
+      return GOL_WIREWORLD_HEAD_COLOR;
+    case RULE_WIREWORLD_TAIL:
+      return GOL_WIREWORLD_TAIL_COLOR;
+    default:
+      return GOL_WIREWORLD_CONDUCTOR_COLOR;
+    }
+  }
+
+  // Dying states of Generations rules fade out
+  return Fade(GOL_ALIVE_COLOR,
+              1.0f - (f32)(state - 1) / (f32)(rule_states(rule) - 1));
+}
+
+// Edges of a bounded universe
+void gol_draw_bounds(const GolCtx *const self) {
+  if (!self->options.bounded) {
+    return;
+  }
+
+  const Vector2 origin = gol_cell_on_screen(self, 0, 0);
+  const Rectangle bounds = {
+      .x = origin.x,
+      .y = origin.y,
+      .width = (f32)self->options.width * self->cell_size,
+      .height = (f32)self->options.height * self->cell_size};
+
+  BeginScissorMode((i32)self->g_screen.x, (i32)self->g_screen.y,
+                   (i32)self->g_screen.width, (i32)self->g_screen.height);
+  DrawRectangleLinesEx(bounds, 3.0f, GOL_BOUNDS_COLOR);
+  EndScissorMode();
+}
+
 void gol_draw_hovered_cell(const GolCtx *const self) {
   if (self->mouse_on_g_screen) {
-    const Rectangle cam_window = {.x = self->cam_pos.x,
-                                  .y = self->cam_pos.y,
-                                  .width = self->g_screen.width,
-                                  .height = self->g_screen.height};
-    const Rectangle cell_rec = {.x = self->mouse_cell_coord.x * self->cell_size,
-                                .y = self->mouse_cell_coord.y * self->cell_size,
+    const Vector2 pos = gol_cell_on_screen(self, self->mouse_cell_coord.x,
+                                           self->mouse_cell_coord.y);
+    const Rectangle cell_rec = {.x = pos.x,
+                                .y = pos.y,
                                 .width = self->cell_size,
                                 .height = self->cell_size};
-    if (CheckCollisionRecs(cell_rec, cam_window)) {
-      Rectangle cell_to_draw = GetCollisionRec(cell_rec, cam_window);
-
-      cell_to_draw.x = cell_to_draw.x - self->cam_pos.x + self->g_screen.x;
-      cell_to_draw.y = cell_to_draw.y - self->cam_pos.y + self->g_screen.y;
+    if (CheckCollisionRecs(cell_rec, self->g_screen)) {
+      const Rectangle cell_to_draw = GetCollisionRec(cell_rec, self->g_screen);
 
       DrawRectangleLinesEx(cell_to_draw, 5.0f, GOL_HOVER_COLOR);
     }
   }
 }
 
-void gol_draw_dbg(const GolCtx *const self) {
+void gol_draw_dbg(GolCtx *const self, Error *const err) {
   const Vector2 mouse_pos = GetMousePosition();
   const Vector2 mouse_pos_rel_g = {
       .x = mouse_pos.x - self->g_screen.x,
@@ -651,8 +1203,7 @@ void gol_draw_dbg(const GolCtx *const self) {
 
   // Draw Point at Origin
   //
-  const Vector2 origin_on_screen = {.x = self->g_screen.x - self->cam_pos.x,
-                                    .y = self->g_screen.y - self->cam_pos.y};
+  const Vector2 origin_on_screen = gol_cell_on_screen(self, 0, 0);
   if (CheckCollisionPointRec(origin_on_screen, self->g_screen)) {
     DrawCircle((i32)origin_on_screen.x, (i32)origin_on_screen.y, 15.0f,
                GOL_DEBUG_COLOR);
@@ -667,9 +1218,9 @@ void gol_draw_dbg(const GolCtx *const self) {
   // Draw mouse coordinates relative to g_screen
   //
   if (self->mouse_on_g_screen) {
-    DrawText(TextFormat("gs(%d, %d)\ng(%d, %d)", (i32)mouse_pos_rel_g.x,
-                        (i32)mouse_pos_rel_g.y, (i32)self->mouse_cell_coord.x,
-                        (i32)self->mouse_cell_coord.y),
+    DrawText(TextFormat("gs(%d, %d)\ng(%ld, %ld)", (i32)mouse_pos_rel_g.x,
+                        (i32)mouse_pos_rel_g.y, self->mouse_cell_coord.x,
+                        self->mouse_cell_coord.y),
              (i32)mouse_pos.x + 20,
              (i32)(mouse_pos.y + GOL_DEBUG_FONT_SIZE + 5.0f),
              GOL_DEBUG_FONT_SIZE, GOL_DEBUG_COLOR);
@@ -713,15 +1264,75 @@ void gol_draw_dbg(const GolCtx *const self) {
            GOL_DEBUG_COLOR);
 
   const Rectangle cam_coord_rec = layout_get();
-  DrawText(TextFormat("Camera: \n\tx: %f\n\ty: %f", self->cam_pos.x,
-                      self->cam_pos.y),
+  DrawText(TextFormat("Camera (cell + px): \n\tx: %ld + %f\n\ty: %ld + %f",
+                      self->cam_cell.x, self->cam_offset.x, self->cam_cell.y,
+                      self->cam_offset.y),
            (i32)cam_coord_rec.x, (i32)cam_coord_rec.y, GOL_DEBUG_FONT_SIZE,
            GOL_DEBUG_COLOR);
 
+  // The CCT owns the engine, it publishes its figures with the render buffer
+  if (mtx_lock(&self->buffer_index_mtx) != thrd_success) {
+    err->msg = "Could not lock Mutex (" error_print_err_location ").";
+    err->status = true;
+    err->code = error_generic;
+    TraceLog(LOG_FATAL, "%s", err->msg);
+    return;
+  }
+  const GolStats stats = self->stats;
+  if (mtx_unlock(&self->buffer_index_mtx) != thrd_success) {
+    err->msg = "Could not unlock Mutex (" error_print_err_location ").";
+    err->status = true;
+    err->code = error_generic;
+    TraceLog(LOG_FATAL, "%s", err->msg);
+    return;
+  }
+
+  char rule_str[RULE_STR_SIZE];
+  rule_format(stats.rule, rule_str);
+  const EngineAuto *const automatic = &stats.automatic;
+  const EngineEscape *const escape = &stats.escape;
+
   const Rectangle cell_nb_rec = layout_get();
-  DrawText(TextFormat("Cycle: %lu, Number of cells: %d, Compute time: %lf ms",
-                      self->cycle_nb, hmlen(self->alive_cells),
-                      self->cycle_compute_time * 1e3),
+  DrawText(TextFormat("Cycle: %lu, Number of cells: %lu, Tile pool: %lu/%lu "
+                      "(%lu KB), Compute time: %lf ms, Engine: %s, Rule: "
+                      "%s\nKernel: %s, %.1lf "
+                      "Mcells/s, Threads: %u, Active tiles: %lu/%lu\nStep: "
+                      "2^%u, HashLife nodes: %lu, Steps left: %lu\nCycle "
+                      "period: %lu, from: %lu, Autopause: %s\nStep arena: "
+                      "%lu KB, %lu allocations, %.3lf ms allocating\n"
+                      "Auto engine: %s, %.1lf cells/tile over %lu tiles, "
+                      "Switches: %lu, last %s -> %s at %lu (%.3lf ms)\n"
+                      "Tile rows: %s, %lu/%lu KB resident, %lu slabs "
+                      "evicted\nIslands: %lu, %lu merges, %lu splits\n"
+                      "Escapes: %s, %lu gliders, %lu LWSS, %lu MWSS, %lu "
+                      "HWSS, %lu others, last at %lu",
+                      self->cycle_nb, stats.population, stats.pool_count,
+                      stats.pool_capacity, stats.pool_bytes / 1024,
+                      self->cycle_compute_time * 1e3,
+                      engine_kind_name(stats.kind), rule_str,
+                      kernel_name(stats.kernel), stats.kernel_rate,
+                      pool_thread_nb(&self->pool), stats.active_nb,
+                      stats.tile_nb, self->step_exp, stats.node_nb,
+                      self->steps_left, stats.period, stats.cycle_start,
+                      self->autopause ? "on" : "off", stats.arena_used / 1024,
+                      stats.arena_alloc_nb, stats.arena_time * 1e3,
+                      automatic->enabled ? "on" : "off", automatic->fill,
+                      automatic->tile_nb, automatic->switch_nb,
+                      engine_kind_name(automatic->from),
+                      engine_kind_name(stats.kind),
+                      automatic->switch_generation,
+                      automatic->migration_time * 1e3,
+                      stats.store ? self->options.store_dir : "memory",
+                      stats.bits_resident / 1024, stats.bits_bytes / 1024,
+                      stats.bits_evicted_nb, stats.island_nb, stats.merge_nb,
+                      stats.split_nb,
+                      escape->enabled ? "on" : "off",
+                      escape->ship_nb[engine_ship_glider],
+                      escape->ship_nb[engine_ship_lwss],
+                      escape->ship_nb[engine_ship_mwss],
+                      escape->ship_nb[engine_ship_hwss],
+                      escape->ship_nb[engine_ship_other],
+                      escape->last_generation),
            (i32)cell_nb_rec.x, (i32)cell_nb_rec.y, GOL_DEBUG_FONT_SIZE,
            GOL_DEBUG_COLOR);
 
@@ -731,10 +1342,6 @@ void gol_draw_dbg(const GolCtx *const self) {
 }
 
 int gol_deinit(GolCtx *const self, Error *const err) {
-  if (self->alive_cells) {
-    hmfree(self->alive_cells);
-  }
-
   FifoMsg msg = {.state = gol_cct_quit};
 
   fifo_enqueue_msg(&self->cct_fifo, msg, -1, err);
@@ -749,17 +1356,16 @@ int gol_deinit(GolCtx *const self, Error *const err) {
     TraceLog(LOG_FATAL, "Error joining thread...", err->msg);
   }
 
+  // Freed once the thread is done with it
+  engine_free(&self->engine);
+  pool_destroy(&self->pool);
+
   mtx_destroy(&self->buffer_index_mtx);
 
   fifo_destroy(&self->cct_fifo, err);
 
-  if (self->alive_cells_render_buffer_1) {
-    arrfree(self->alive_cells_render_buffer_1);
-  }
-
-  if (self->alive_cells_render_buffer_2) {
-    arrfree(self->alive_cells_render_buffer_2);
-  }
+  render_buffer_free(&self->render_buffer_1);
+  render_buffer_free(&self->render_buffer_2);
 
   if (self->cmd) {
     sdsfree(self->cmd);
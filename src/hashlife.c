@@ -0,0 +1,579 @@
+#include "hashlife.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+#define HASHLIFE_NONE UINT32_MAX
+#define HASHLIFE_DEAD 0  // Level 0 node of a dead cell
+#define HASHLIFE_ALIVE 1 // Level 0 node of an alive cell
+#define HASHLIFE_FREE UINT8_MAX // Level of a reclaimed node
+#define HASHLIFE_INITIAL_BUCKETS (1 << 16)
+#define HASHLIFE_INITIAL_LEVEL 3
+
+// Store
+//
+
+static inline u64 hashlife_hash(HlNodeId nw, HlNodeId ne, HlNodeId sw,
+                                HlNodeId se) {
+  const u64 h = (((u64)nw << 32) | ne) * 0x9E3779B97F4A7C15ull ^
+                (((u64)sw << 32) | se) * 0xC2B2AE3D27D4EB4Full;
+  return h ^ (h >> 29);
+}
+
+static void hashlife_chain(HashLife *const self, HlNodeId id) {
+  const HlNode *const node = &self->nodes[id];
+  const u64 bucket = hashlife_hash(node->nw, node->ne, node->sw, node->se) &
+                     (self->bucket_nb - 1);
+  self->nodes[id].next = self->buckets[bucket];
+  self->buckets[bucket] = id;
+}
+
+// Rebuilds every hash chain, growing the table to bucket_nb
+static void hashlife_rehash(HashLife *const self, u64 bucket_nb) {
+  free(self->buckets);
+  self->buckets = malloc(bucket_nb * sizeof(HlNodeId));
+  assert(self->buckets && "Not enough memory, this is the end...");
+  memset(self->buckets, 0xFF, bucket_nb * sizeof(HlNodeId));
+  self->bucket_nb = bucket_nb;
+
+  for (HlNodeId id = 0; id < arrlenu(self->nodes); id++) {
+    const u8 level = self->nodes[id].level;
+    if (level && level != HASHLIFE_FREE) {
+      hashlife_chain(self, id);
+    }
+  }
+}
+
+static void hashlife_init(HashLife *const self) {
+  if (self->nodes) {
+    return;
+  }
+
+  *self = (HashLife){.free_list = HASHLIFE_NONE,
+                     .gc_threshold = HASHLIFE_GC_THRESHOLD,
+                     .step_exp = self->step_exp,
+                     .rule = self->rule};
+
+  const HlNode dead = {.next = HASHLIFE_NONE, .result = HASHLIFE_NONE};
+  const HlNode alive = {
+      .next = HASHLIFE_NONE,
+      .result = HASHLIFE_NONE,
+      .population = 1,
+      .hash = 1};
+  arrput(self->nodes, dead);
+  arrput(self->nodes, alive);
+  self->node_nb = 2;
+
+  hashlife_rehash(self, HASHLIFE_INITIAL_BUCKETS);
+
+  for (u32 i = 0; i <= HASHLIFE_MAX_LEVEL; i++) {
+    self->empty[i] = HASHLIFE_NONE;
+  }
+  self->empty[0] = HASHLIFE_DEAD;
+}
+
+// Content hash of a square made of 4 level - 1 squares
+static u64 hashlife_content_hash(u64 nw, u64 ne, u64 sw, u64 se, u8 level) {
+  const u64 k = 0x9E3779B97F4A7C15ull;
+  return cellset_zobrist((((nw * k + ne) * k + sw) * k + se) * k + level);
+}
+
+// Returns the canonical node made of the 4 given children
+static HlNodeId hashlife_node(HashLife *const self, HlNodeId nw, HlNodeId ne,
+                              HlNodeId sw, HlNodeId se) {
+  const u64 bucket = hashlife_hash(nw, ne, sw, se) & (self->bucket_nb - 1);
+
+  for (HlNodeId id = self->buckets[bucket]; id != HASHLIFE_NONE;
+       id = self->nodes[id].next) {
+    const HlNode *const node = &self->nodes[id];
+    if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se) {
+      return id;
+    }
+  }
+
+  const HlNode node = {
+      .nw = nw,
+      .ne = ne,
+      .sw = sw,
+      .se = se,
+      .next = self->buckets[bucket],
+      .result = HASHLIFE_NONE,
+      .population = self->nodes[nw].population + self->nodes[ne].population +
+                    self->nodes[sw].population + self->nodes[se].population,
+      .hash = hashlife_content_hash(
+          self->nodes[nw].hash, self->nodes[ne].hash, self->nodes[sw].hash,
+          self->nodes[se].hash, (u8)(self->nodes[nw].level + 1)),
+      .level = (u8)(self->nodes[nw].level + 1)};
+
+  HlNodeId id;
+  if (self->free_list != HASHLIFE_NONE) {
+    id = self->free_list;
+    self->free_list = self->nodes[id].next;
+    self->nodes[id] = node;
+  } else {
+    assert(arrlenu(self->nodes) < HASHLIFE_NONE && "Node store is full");
+    id = (HlNodeId)arrlenu(self->nodes);
+    arrput(self->nodes, node);
+  }
+  self->buckets[bucket] = id;
+  self->node_nb += 1;
+
+  if (self->node_nb > self->bucket_nb) {
+    hashlife_rehash(self, self->bucket_nb * 2);
+  }
+
+  return id;
+}
+
+static HlNodeId hashlife_empty(HashLife *const self, u8 level) {
+  if (self->empty[level] == HASHLIFE_NONE) {
+    const HlNodeId child = hashlife_empty(self, (u8)(level - 1));
+    self->empty[level] = hashlife_node(self, child, child, child, child);
+  }
+  return self->empty[level];
+}
+
+// Level k-2 node at the centre of a level k node
+static HlNodeId hashlife_centre(HashLife *const self, HlNodeId id) {
+  const HlNode node = self->nodes[id];
+  return hashlife_node(self, self->nodes[node.nw].se, self->nodes[node.ne].sw,
+                       self->nodes[node.sw].ne, self->nodes[node.se].nw);
+}
+
+// Level k-1 node straddling two horizontally adjacent level k-1 nodes
+static HlNodeId hashlife_centre_h(HashLife *const self, HlNodeId w,
+                                  HlNodeId e) {
+  const HlNode west = self->nodes[w];
+  const HlNode east = self->nodes[e];
+  return hashlife_node(self, west.ne, east.nw, west.se, east.sw);
+}
+
+// Level k-1 node straddling two vertically adjacent level k-1 nodes
+static HlNodeId hashlife_centre_v(HashLife *const self, HlNodeId n,
+                                  HlNodeId s) {
+  const HlNode north = self->nodes[n];
+  const HlNode south = self->nodes[s];
+  return hashlife_node(self, north.sw, north.se, south.nw, south.ne);
+}
+
+// Evolution
+//
+
+// Level 2 node: centre 2x2 one generation later
+static HlNodeId hashlife_base(HashLife *const self, HlNodeId id) {
+  const HlNode node = self->nodes[id];
+  const HlNodeId quads[4] = {node.nw, node.ne, node.sw, node.se};
+
+  // Leaf ids are their alive flag
+  u32 grid[4][4];
+  for (u32 q = 0; q < 4; q++) {
+    const HlNode quad = self->nodes[quads[q]];
+    const u32 x = (q & 1) * 2;
+    const u32 y = (q >> 1) * 2;
+    grid[y][x] = quad.nw;
+    grid[y][x + 1] = quad.ne;
+    grid[y + 1][x] = quad.sw;
+    grid[y + 1][x + 1] = quad.se;
+  }
+
+  const Rule rule = rule_resolve(self->rule);
+  HlNodeId next[4];
+  for (u32 i = 0; i < 4; i++) {
+    const u32 x = 1 + (i & 1);
+    const u32 y = 1 + (i >> 1);
+
+    u32 neighbourhood = 0;
+    for (u32 ny = y - 1; ny <= y + 1; ny++) {
+      for (u32 nx = x - 1; nx <= x + 1; nx++) {
+        neighbourhood |= grid[ny][nx] << ((ny - y + 1) * 3 + nx - x + 1);
+      }
+    }
+
+    next[i] = rule_next_neighbourhood(rule, neighbourhood) ? HASHLIFE_ALIVE
+                                                           : HASHLIFE_DEAD;
+  }
+
+  return hashlife_node(self, next[0], next[1], next[2], next[3]);
+}
+
+// Centre half of a level k node, 2^min(step_exp, k-2) generations later
+static HlNodeId hashlife_result(HashLife *const self, HlNodeId id) {
+  if (self->nodes[id].result != HASHLIFE_NONE) {
+    return self->nodes[id].result;
+  }
+
+  const HlNode node = self->nodes[id];
+  HlNodeId result;
+
+  if (!node.population) {
+    result = hashlife_empty(self, (u8)(node.level - 1));
+  } else if (node.level == 2) {
+    result = hashlife_base(self, id);
+  } else {
+    // 9 overlapping level k-1 nodes
+    const HlNodeId sub[3][3] = {
+        {node.nw, hashlife_centre_h(self, node.nw, node.ne), node.ne},
+        {hashlife_centre_v(self, node.nw, node.sw),
+         hashlife_node(self, self->nodes[node.nw].se, self->nodes[node.ne].sw,
+                       self->nodes[node.sw].ne, self->nodes[node.se].nw),
+         hashlife_centre_v(self, node.ne, node.se)},
+        {node.sw, hashlife_centre_h(self, node.sw, node.se), node.se},
+    };
+
+    // Full speed advances 2^(k-3) in both halves, slower steps only in the
+    // second one
+    const bool full_speed = self->step_exp + 2 >= node.level;
+
+    HlNodeId half[3][3];
+    for (u32 y = 0; y < 3; y++) {
+      for (u32 x = 0; x < 3; x++) {
+        half[y][x] = full_speed ? hashlife_result(self, sub[y][x])
+                                : hashlife_centre(self, sub[y][x]);
+      }
+    }
+
+    HlNodeId quads[4];
+    for (u32 q = 0; q < 4; q++) {
+      const u32 x = q & 1;
+      const u32 y = q >> 1;
+      quads[q] = hashlife_result(
+          self, hashlife_node(self, half[y][x], half[y][x + 1],
+                              half[y + 1][x], half[y + 1][x + 1]));
+    }
+
+    result = hashlife_node(self, quads[0], quads[1], quads[2], quads[3]);
+  }
+
+  self->nodes[id].result = result;
+  return result;
+}
+
+// Doubles the universe around its centre
+static void hashlife_expand(HashLife *const self) {
+  const HlNode root = self->nodes[self->root];
+  assert(root.level < HASHLIFE_MAX_LEVEL && "Universe is too large");
+
+  const HlNodeId e = hashlife_empty(self, (u8)(root.level - 1));
+  const HlNodeId nw = hashlife_node(self, e, e, e, root.nw);
+  const HlNodeId ne = hashlife_node(self, e, e, root.ne, e);
+  const HlNodeId sw = hashlife_node(self, e, root.sw, e, e);
+  const HlNodeId se = hashlife_node(self, root.se, e, e, e);
+  self->root = hashlife_node(self, nw, ne, sw, se);
+}
+
+// True if every cell is in the centre quarter (level k-2 node) of the root:
+// whatever grows out of it in 2^(k-3) generations stays in the result
+static bool hashlife_is_centred(const HashLife *const self) {
+  const HlNode *const nodes = self->nodes;
+  const HlNode root = nodes[self->root];
+
+  return root.population == nodes[nodes[root.nw].se].population +
+                                nodes[nodes[root.ne].sw].population +
+                                nodes[nodes[root.sw].ne].population +
+                                nodes[nodes[root.se].nw].population &&
+         nodes[nodes[root.nw].se].population ==
+             nodes[nodes[nodes[root.nw].se].se].population &&
+         nodes[nodes[root.ne].sw].population ==
+             nodes[nodes[nodes[root.ne].sw].sw].population &&
+         nodes[nodes[root.sw].ne].population ==
+             nodes[nodes[nodes[root.sw].ne].ne].population &&
+         nodes[nodes[root.se].nw].population ==
+             nodes[nodes[nodes[root.se].nw].nw].population;
+}
+
+u64 hashlife_step(HashLife *const self) {
+  hashlife_init(self);
+
+  while (self->nodes[self->root].level < self->step_exp + 3 ||
+         !hashlife_is_centred(self)) {
+    // Cells past HASHLIFE_MAX_COORD, out of reach of set_cell & the engines
+    if (self->nodes[self->root].level >= HASHLIFE_MAX_LEVEL - 1) {
+      return 0;
+    }
+    hashlife_expand(self);
+  }
+
+  self->root = hashlife_result(self, self->root);
+
+  if (self->node_nb > self->gc_threshold) {
+    hashlife_gc(self);
+    // Mostly alive nodes: collecting again soon would be wasted time
+    if (self->node_nb > self->gc_threshold / 2) {
+      self->gc_threshold *= 2;
+    }
+  }
+
+  return 1ull << self->step_exp;
+}
+
+void hashlife_set_step_exp(HashLife *const self, u32 step_exp) {
+  assert(step_exp <= HASHLIFE_MAX_STEP_EXP && "Step exponent is too large");
+
+  if (step_exp == self->step_exp) {
+    return;
+  }
+
+  // Level k results are 2^min(step_exp, k-2) generations later: the ones of
+  // small nodes stay valid
+  const u32 kept_level =
+      (step_exp < self->step_exp ? step_exp : self->step_exp) + 2;
+  self->step_exp = step_exp;
+
+  for (HlNodeId id = 0; id < arrlenu(self->nodes); id++) {
+    if (self->nodes[id].level > kept_level) {
+      self->nodes[id].result = HASHLIFE_NONE;
+    }
+  }
+}
+
+void hashlife_set_rule(HashLife *const self, Rule rule) {
+  self->rule = rule;
+  for (HlNodeId id = 0; id < arrlenu(self->nodes); id++) {
+    self->nodes[id].result = HASHLIFE_NONE;
+  }
+}
+
+// Garbage collection
+//
+
+static void hashlife_mark(HashLife *const self, HlNodeId id) {
+  HlNode *const node = &self->nodes[id];
+  if (node->marked || !node->level) {
+    return;
+  }
+  node->marked = true;
+
+  const HlNode children = *node;
+  hashlife_mark(self, children.nw);
+  hashlife_mark(self, children.ne);
+  hashlife_mark(self, children.sw);
+  hashlife_mark(self, children.se);
+}
+
+void hashlife_gc(HashLife *const self) {
+  if (!self->nodes) {
+    return;
+  }
+
+  hashlife_mark(self, self->root);
+  for (u32 i = 0; i <= HASHLIFE_MAX_LEVEL; i++) {
+    if (self->empty[i] != HASHLIFE_NONE) {
+      hashlife_mark(self, self->empty[i]);
+    }
+  }
+
+  // Sweep, leaves are never reclaimed
+  for (HlNodeId id = HASHLIFE_ALIVE + 1; id < arrlenu(self->nodes); id++) {
+    HlNode *const node = &self->nodes[id];
+    if (node->level == HASHLIFE_FREE) {
+      continue;
+    }
+    if (node->marked) {
+      node->marked = false;
+    } else {
+      node->level = HASHLIFE_FREE;
+      node->next = self->free_list;
+      self->free_list = id;
+      self->node_nb -= 1;
+    }
+  }
+
+  // Forget results that have been reclaimed
+  for (HlNodeId id = 0; id < arrlenu(self->nodes); id++) {
+    HlNode *const node = &self->nodes[id];
+    if (node->level != HASHLIFE_FREE && node->result != HASHLIFE_NONE &&
+        self->nodes[node->result].level == HASHLIFE_FREE) {
+      node->result = HASHLIFE_NONE;
+    }
+  }
+
+  hashlife_rehash(self, self->bucket_nb);
+}
+
+// Cells
+//
+
+void hashlife_free(HashLife *const self) {
+  arrfree(self->nodes);
+  free(self->buckets);
+  *self = (HashLife){0};
+}
+
+// Coordinates of the top left cell of the root
+static inline i64 hashlife_origin(const HashLife *const self) {
+  return -(1ll << (self->nodes[self->root].level - 1));
+}
+
+bool hashlife_get_cell(const HashLife *const self, i64 x, i64 y) {
+  if (!self->nodes) {
+    return false;
+  }
+
+  const i64 origin = hashlife_origin(self);
+  i64 cx = x - origin;
+  i64 cy = y - origin;
+  HlNodeId id = self->root;
+
+  if (cx < 0 || cy < 0 || cx >= -2 * origin || cy >= -2 * origin) {
+    return false;
+  }
+
+  while (self->nodes[id].level && self->nodes[id].population) {
+    const HlNode node = self->nodes[id];
+    const i64 half = 1ll << (node.level - 1);
+    const bool east = cx >= half;
+    const bool south = cy >= half;
+    id = south ? (east ? node.se : node.sw) : (east ? node.ne : node.nw);
+    cx -= east * half;
+    cy -= south * half;
+  }
+
+  return id == HASHLIFE_ALIVE;
+}
+
+static HlNodeId hashlife_set(HashLife *const self, HlNodeId id, i64 x, i64 y,
+                             bool alive) {
+  const HlNode node = self->nodes[id];
+  if (!node.level) {
+    return alive ? HASHLIFE_ALIVE : HASHLIFE_DEAD;
+  }
+
+  const i64 half = 1ll << (node.level - 1);
+  const bool east = x >= half;
+  const bool south = y >= half;
+  x -= east * half;
+  y -= south * half;
+
+  if (south) {
+    return east ? hashlife_node(self, node.nw, node.ne, node.sw,
+                                hashlife_set(self, node.se, x, y, alive))
+                : hashlife_node(self, node.nw, node.ne,
+                                hashlife_set(self, node.sw, x, y, alive),
+                                node.se);
+  }
+  return east ? hashlife_node(self, node.nw,
+                              hashlife_set(self, node.ne, x, y, alive),
+                              node.sw, node.se)
+              : hashlife_node(self, hashlife_set(self, node.nw, x, y, alive),
+                              node.ne, node.sw, node.se);
+}
+
+void hashlife_set_cell(HashLife *const self, i64 x, i64 y, bool alive) {
+  assert(x >= -HASHLIFE_MAX_COORD && x < HASHLIFE_MAX_COORD &&
+         y >= -HASHLIFE_MAX_COORD && y < HASHLIFE_MAX_COORD &&
+         "Cell out of the universe");
+  hashlife_init(self);
+
+  if (!self->root) {
+    self->root = hashlife_empty(self, HASHLIFE_INITIAL_LEVEL);
+  }
+
+  while (x < hashlife_origin(self) || y < hashlife_origin(self) ||
+         x >= -hashlife_origin(self) || y >= -hashlife_origin(self)) {
+    hashlife_expand(self);
+  }
+
+  const i64 origin = hashlife_origin(self);
+  self->root = hashlife_set(self, self->root, x - origin, y - origin, alive);
+}
+
+u64 hashlife_population(const HashLife *const self) {
+  return self->nodes ? self->nodes[self->root].population : 0;
+}
+
+u64 hashlife_universe_hash(const HashLife *const self) {
+  if (!self->nodes || !self->root) {
+    return 0;
+  }
+
+  // Shrink the square centred on (0, 0) while its centre holds every cell, so
+  // roots expanded more or less hash the same
+  const HlNode *const nodes = self->nodes;
+  const HlNode root = nodes[self->root];
+  HlNodeId q[4] = {root.nw, root.ne, root.sw, root.se};
+  while (nodes[q[0]].level) {
+    const HlNodeId inner[4] = {nodes[q[0]].se, nodes[q[1]].sw, nodes[q[2]].ne,
+                               nodes[q[3]].nw};
+    if (nodes[inner[0]].population + nodes[inner[1]].population +
+            nodes[inner[2]].population + nodes[inner[3]].population !=
+        root.population) {
+      break;
+    }
+    memcpy(q, inner, sizeof(q));
+  }
+
+  return hashlife_content_hash(nodes[q[0]].hash, nodes[q[1]].hash,
+                               nodes[q[2]].hash, nodes[q[3]].hash,
+                               (u8)(nodes[q[0]].level + 1));
+}
+
+static void hashlife_foreach(const HashLife *const self, HlNodeId id, i64 x,
+                             i64 y, CellRect64 rect, HashLifeCellFn fn,
+                             void *const ctx) {
+  const HlNode node = self->nodes[id];
+  const i64 size = 1ll << node.level;
+
+  if (!node.population || x > rect.max_x || y > rect.max_y ||
+      x + size <= rect.min_x || y + size <= rect.min_y) {
+    return;
+  }
+
+  if (!node.level) {
+    fn(ctx, x, y);
+    return;
+  }
+
+  const i64 half = size / 2;
+  hashlife_foreach(self, node.nw, x, y, rect, fn, ctx);
+  hashlife_foreach(self, node.ne, x + half, y, rect, fn, ctx);
+  hashlife_foreach(self, node.sw, x, y + half, rect, fn, ctx);
+  hashlife_foreach(self, node.se, x + half, y + half, rect, fn, ctx);
+}
+
+void hashlife_foreach_cell(const HashLife *const self, CellRect64 rect,
+                           HashLifeCellFn fn, void *const ctx) {
+  if (!self->nodes) {
+    return;
+  }
+
+  const i64 origin = hashlife_origin(self);
+  hashlife_foreach(self, self->root, origin, origin, rect, fn, ctx);
+}
+
+static u64 hashlife_count(const HashLife *const self, HlNodeId id, i64 x,
+                          i64 y, CellRect64 rect) {
+  const HlNode node = self->nodes[id];
+  const i64 last_x = x + (1ll << node.level) - 1;
+  const i64 last_y = y + (1ll << node.level) - 1;
+
+  if (!node.population || x > rect.max_x || y > rect.max_y ||
+      last_x < rect.min_x || last_y < rect.min_y) {
+    return 0;
+  }
+  // Nodes inside rect count as a whole, so do cells
+  if (x >= rect.min_x && y >= rect.min_y && last_x <= rect.max_x &&
+      last_y <= rect.max_y) {
+    return node.population;
+  }
+
+  const i64 half = 1ll << (node.level - 1);
+  return hashlife_count(self, node.nw, x, y, rect) +
+         hashlife_count(self, node.ne, x + half, y, rect) +
+         hashlife_count(self, node.sw, x, y + half, rect) +
+         hashlife_count(self, node.se, x + half, y + half, rect);
+}
+
+u64 hashlife_population_in(const HashLife *const self, CellRect64 rect) {
+  if (!self->nodes) {
+    return 0;
+  }
+
+  const i64 origin = hashlife_origin(self);
+  return hashlife_count(self, self->root, origin, origin, rect);
+}
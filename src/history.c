@@ -0,0 +1,57 @@
+#include "history.h"
+#include <assert.h>
+#include <stdlib.h>
+
+void history_free(History *const self) {
+  free(self->entries);
+  cellset_free(&self->index);
+  *self = (History){0};
+}
+
+void history_clear(History *const self) {
+  // Edits clear the history for every cell, keep it cheap when already empty
+  if (!self->count && !self->period) {
+    return;
+  }
+  cellset_clear(&self->index);
+  self->next = 0;
+  self->count = 0;
+  self->period = 0;
+  self->cycle_start = 0;
+}
+
+bool history_push(History *const self, u64 hash, u64 population,
+                  u64 generation) {
+  if (!self->entries) {
+    self->entries = malloc(HISTORY_SIZE * sizeof(HistoryEntry));
+    assert(self->entries && "Not enough memory, this is the end...");
+  }
+
+  // Forget the oldest entry, unless its hash was seen again since
+  if (self->count == HISTORY_SIZE) {
+    const u32 *const oldest =
+        cellset_get(&self->index, self->entries[self->next].hash);
+    if (oldest && *oldest == self->next) {
+      cellset_erase(&self->index, self->entries[self->next].hash);
+    }
+  } else {
+    self->count += 1;
+  }
+
+  // The first repetition starts the cycle: the generation before it would
+  // have repeated one generation earlier
+  const u32 *const seen = cellset_get(&self->index, hash);
+  const bool found = !self->period && seen &&
+                     self->entries[*seen].population == population;
+  if (found) {
+    self->period = generation - self->entries[*seen].generation;
+    self->cycle_start = self->entries[*seen].generation;
+  }
+
+  self->entries[self->next] = (HistoryEntry){
+      .hash = hash, .population = population, .generation = generation};
+  *cellset_insert(&self->index, hash, self->next) = self->next;
+  self->next = (self->next + 1) % HISTORY_SIZE;
+
+  return found;
+}
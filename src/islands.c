@@ -0,0 +1,394 @@
+#include "islands.h"
+#include <stdlib.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+// Whether less than ISLANDS_GAP empty rows or columns separate a from b
+static inline bool islands_meet(CellRect a, CellRect b) {
+  return (i64)b.min_x - a.max_x <= ISLANDS_GAP &&
+         (i64)a.min_x - b.max_x <= ISLANDS_GAP &&
+         (i64)b.min_y - a.max_y <= ISLANDS_GAP &&
+         (i64)a.min_y - b.max_y <= ISLANDS_GAP;
+}
+
+static inline CellRect islands_union(CellRect a, CellRect b) {
+  return (CellRect){.min_x = a.min_x < b.min_x ? a.min_x : b.min_x,
+                    .min_y = a.min_y < b.min_y ? a.min_y : b.min_y,
+                    .max_x = a.max_x > b.max_x ? a.max_x : b.max_x,
+                    .max_y = a.max_y > b.max_y ? a.max_y : b.max_y};
+}
+
+static inline bool islands_intersect(CellRect a, CellRect b) {
+  return a.min_x <= b.max_x && b.min_x <= a.max_x && a.min_y <= b.max_y &&
+         b.min_y <= a.max_y;
+}
+
+// Index of the island whose box holds (x, y), the island count if none
+static u64 islands_find(const IslandMap *const self, i32 x, i32 y) {
+  u64 i = 0;
+  while (i < arrlenu(self->islands) &&
+         !cellrect_contains(self->islands[i].box, x, y)) {
+    i++;
+  }
+  return i;
+}
+
+static void islands_absorb_cell(void *const ctx, i32 x, i32 y) {
+  celllist_set_cell((CellList *)ctx, x, y, true);
+}
+
+// Moves the cells of src to dst & frees src, the larger list keeps its cells
+static void islands_absorb(IslandMap *const self, Island *const dst,
+                           Island *const src) {
+  if (src->cells.population > dst->cells.population) {
+    const Island island = *dst;
+    *dst = *src;
+    *src = island;
+  }
+  celllist_foreach_cell(&src->cells, CELLRECT_ALL, &islands_absorb_cell,
+                        &dst->cells);
+  dst->box = islands_union(dst->box, src->box);
+  celllist_free(&src->cells);
+  self->merge_nb += 1;
+}
+
+// Merges the islands that meet the island index into it
+static void islands_join(IslandMap *const self, u64 index) {
+  for (u64 i = 0; i < arrlenu(self->islands);) {
+    if (i == index ||
+        !islands_meet(self->islands[index].box, self->islands[i].box)) {
+      i++;
+      continue;
+    }
+
+    islands_absorb(self, &self->islands[index], &self->islands[i]);
+    arrdelswap(self->islands, i);
+    if (index == arrlenu(self->islands)) {
+      index = i; // Was the last island
+    }
+    i = 0; // The box grew
+  }
+}
+
+static int islands_compare(const void *const a, const void *const b) {
+  const i32 a_x = ((const Island *)a)->box.min_x;
+  const i32 b_x = ((const Island *)b)->box.min_x;
+  return (a_x > b_x) - (a_x < b_x);
+}
+
+// Merges the islands that meet. Sorted by the left of their box, an island
+// is only compared to the next ones up to ISLANDS_GAP past its right. A merge
+// keeps the left of the box, so the islands stay sorted
+static void islands_merge(IslandMap *const self) {
+  qsort(self->islands, arrlenu(self->islands), sizeof(Island),
+        &islands_compare);
+
+  for (u64 i = 0; i < arrlenu(self->islands); i++) {
+    for (u64 j = i + 1; j < arrlenu(self->islands) &&
+                        (i64)self->islands[j].box.min_x -
+                                self->islands[i].box.max_x <=
+                            ISLANDS_GAP;) {
+      if (islands_meet(self->islands[i].box, self->islands[j].box)) {
+        islands_absorb(self, &self->islands[i], &self->islands[j]);
+        arrdel(self->islands, j);
+        j = i + 1; // The box grew
+      } else {
+        j++;
+      }
+    }
+  }
+}
+
+// Union-find over cells
+static u32 islands_root(u32 *const parent, u32 i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+u32 islands_label(const CellKey *const keys, u32 key_nb, u32 *const labels,
+                  Arena *const arena) {
+  CellSet lookup = {0};
+  cellset_reserve(&lookup, key_nb);
+  for (u32 i = 0; i < key_nb; i++) {
+    cellset_insert_new(&lookup, keys[i], i);
+  }
+
+  // Each cell joined to the ones above & left of it within ISLANDS_GAP, in
+  // any order. Roots are the first cell of their component
+  u32 *const parent = arena_alloc(arena, key_nb * sizeof(u32));
+  for (u32 i = 0; i < key_nb; i++) {
+    parent[i] = i;
+  }
+  for (u32 i = 0; i < key_nb; i++) {
+    const i32 x = cellset_key_x(keys[i]);
+    const i32 y = cellset_key_y(keys[i]);
+    for (i32 dy = -ISLANDS_GAP; dy <= 0; dy++) {
+      for (i32 dx = -ISLANDS_GAP; dx <= (dy ? ISLANDS_GAP : -1); dx++) {
+        const i64 nx = (i64)x + dx;
+        const i64 ny = (i64)y + dy;
+        const u32 *const j =
+            cellset_within(nx, ny)
+                ? cellset_get(&lookup, cellset_key((i32)nx, (i32)ny))
+                : NULL;
+        if (j) {
+          const u32 a = islands_root(parent, i);
+          const u32 b = islands_root(parent, *j);
+          parent[a > b ? a : b] = a < b ? a : b;
+        }
+      }
+    }
+  }
+  cellset_free(&lookup);
+
+  u32 label_nb = 0;
+  for (u32 i = 0; i < key_nb; i++) {
+    const u32 root = islands_root(parent, i);
+    labels[i] = root == i ? label_nb++ : labels[root];
+  }
+  return label_nb;
+}
+
+typedef struct IslandsCollect {
+  CellKey *keys;
+  u64 count;
+} IslandsCollect;
+
+static void islands_collect_cell(void *const ctx, i32 x, i32 y) {
+  IslandsCollect *const collect = (IslandsCollect *)ctx;
+  collect->keys[collect->count++] = cellset_key(x, y);
+}
+
+// Splits the island index into its connected components, components whose
+// boxes meet staying together. Scratch comes from arena
+static void islands_split(IslandMap *const self, u64 index,
+                          Arena *const arena) {
+  const u32 cell_nb = (u32)self->islands[index].cells.population;
+  if (cell_nb < 2) {
+    return;
+  }
+
+  IslandsCollect collect = {
+      .keys = arena_alloc(arena, cell_nb * sizeof(CellKey))};
+  celllist_foreach_cell(&self->islands[index].cells, CELLRECT_ALL,
+                        &islands_collect_cell, &collect);
+  u32 *const labels = arena_alloc(arena, cell_nb * sizeof(u32));
+  const u32 label_nb = islands_label(collect.keys, cell_nb, labels, arena);
+  if (label_nb < 2) {
+    return;
+  }
+
+  // Components whose boxes meet are one island, until no boxes meet. owner
+  // leads from a merged component to the one it was merged into
+  CellRect *const box = arena_alloc(arena, label_nb * sizeof(CellRect));
+  u32 *const owner = arena_alloc(arena, label_nb * sizeof(u32));
+  u32 *const roots = arena_alloc(arena, label_nb * sizeof(u32));
+  for (u32 l = 0; l < label_nb; l++) {
+    box[l] = (CellRect){.min_x = INT32_MAX,
+                        .min_y = INT32_MAX,
+                        .max_x = INT32_MIN,
+                        .max_y = INT32_MIN};
+    owner[l] = l;
+    roots[l] = l;
+  }
+  for (u32 i = 0; i < cell_nb; i++) {
+    const i32 x = cellset_key_x(collect.keys[i]);
+    const i32 y = cellset_key_y(collect.keys[i]);
+    box[labels[i]] = islands_union(
+        box[labels[i]],
+        (CellRect){.min_x = x, .min_y = y, .max_x = x, .max_y = y});
+  }
+
+  u32 root_nb = label_nb;
+  for (bool merged = true; merged;) {
+    merged = false;
+    for (u32 a = 0; a < root_nb; a++) {
+      for (u32 b = a + 1; b < root_nb;) {
+        if (islands_meet(box[roots[a]], box[roots[b]])) {
+          owner[roots[b]] = roots[a];
+          box[roots[a]] = islands_union(box[roots[a]], box[roots[b]]);
+          roots[b] = roots[--root_nb];
+          merged = true;
+        } else {
+          b++;
+        }
+      }
+    }
+  }
+  if (root_nb < 2) {
+    return;
+  }
+
+  Island *const parts = arena_alloc(arena, root_nb * sizeof(Island));
+  u32 *const part = arena_alloc(arena, label_nb * sizeof(u32)); // Of labels
+  for (u32 g = 0; g < root_nb; g++) {
+    parts[g] = (Island){.cells = {.rule = self->rule}, .box = box[roots[g]]};
+    part[roots[g]] = g;
+  }
+  for (u32 l = 0; l < label_nb; l++) {
+    u32 root = l;
+    while (owner[root] != root) {
+      root = owner[root];
+    }
+    part[l] = part[root];
+  }
+  for (u32 i = 0; i < cell_nb; i++) {
+    celllist_set_cell(&parts[part[labels[i]]].cells,
+                      cellset_key_x(collect.keys[i]),
+                      cellset_key_y(collect.keys[i]), true);
+  }
+
+  celllist_free(&self->islands[index].cells);
+  self->islands[index] = parts[0];
+  for (u32 g = 1; g < root_nb; g++) {
+    arrput(self->islands, parts[g]);
+  }
+  self->split_nb += root_nb - 1;
+}
+
+void islands_free(IslandMap *const self) {
+  for (u64 i = 0; i < arrlenu(self->islands); i++) {
+    celllist_free(&self->islands[i].cells);
+  }
+  arrfree(self->islands);
+  for (u64 i = 0; i < arrlenu(self->arenas); i++) {
+    arena_free(&self->arenas[i]);
+  }
+  arrfree(self->arenas);
+  *self = (IslandMap){0};
+}
+
+void islands_set_rule(IslandMap *const self, Rule rule) {
+  self->rule = rule;
+  for (u64 i = 0; i < arrlenu(self->islands); i++) {
+    self->islands[i].cells.rule = rule;
+  }
+}
+
+bool islands_get_cell(const IslandMap *const self, i32 x, i32 y) {
+  const u64 i = islands_find(self, x, y);
+  return i < arrlenu(self->islands) &&
+         celllist_get_cell(&self->islands[i].cells, x, y);
+}
+
+void islands_set_cell(IslandMap *const self, i32 x, i32 y, bool alive) {
+  const u64 i = islands_find(self, x, y);
+  if (i < arrlenu(self->islands)) {
+    celllist_set_cell(&self->islands[i].cells, x, y, alive);
+    return;
+  }
+  if (!alive) {
+    return;
+  }
+
+  const Island island = {
+      .cells = {.rule = self->rule},
+      .box = {.min_x = x, .min_y = y, .max_x = x, .max_y = y}};
+  arrput(self->islands, island);
+  celllist_set_cell(&arrlast(self->islands).cells, x, y, true);
+  islands_join(self, arrlenu(self->islands) - 1);
+}
+
+void islands_add_cells(IslandMap *const self, const CellKey *const keys,
+                       u32 key_nb, Arena *const arena) {
+  if (!key_nb) {
+    return;
+  }
+
+  u32 *const labels = arena_alloc(arena, key_nb * sizeof(u32));
+  const u32 label_nb = islands_label(keys, key_nb, labels, arena);
+
+  const u64 first = arrlenu(self->islands);
+  const Island empty = {.cells = {.rule = self->rule},
+                        .box = {.min_x = INT32_MAX,
+                                .min_y = INT32_MAX,
+                                .max_x = INT32_MIN,
+                                .max_y = INT32_MIN}};
+  for (u32 l = 0; l < label_nb; l++) {
+    arrput(self->islands, empty);
+  }
+  for (u32 i = 0; i < key_nb; i++) {
+    Island *const island = &self->islands[first + labels[i]];
+    const i32 x = cellset_key_x(keys[i]);
+    const i32 y = cellset_key_y(keys[i]);
+    celllist_set_cell(&island->cells, x, y, true);
+    island->box = islands_union(
+        island->box,
+        (CellRect){.min_x = x, .min_y = y, .max_x = x, .max_y = y});
+  }
+
+  // Components whose boxes meet, or meeting islands already there, weren't
+  // merged by the universe
+  const u64 merge_nb = self->merge_nb;
+  islands_merge(self);
+  self->merge_nb = merge_nb;
+}
+
+static void islands_step_island(void *const ctx, u32 worker, u32 task) {
+  IslandMap *const self = (IslandMap *)ctx;
+  Island *const island = &self->islands[task];
+  celllist_step(&island->cells, &self->arenas[worker]);
+  celllist_bounds(&island->cells, &island->box);
+}
+
+void islands_step(IslandMap *const self, ThreadPool *const pool) {
+  while (arrlenu(self->arenas) < pool_thread_nb(pool)) {
+    arrput(self->arenas, (Arena){0});
+  }
+
+  // Islands only write their own cells & box, they can be stepped in any
+  // order
+  pool_run(pool, (u32)arrlenu(self->islands), &islands_step_island, self);
+
+  for (u64 i = arrlenu(self->islands); i-- > 0;) {
+    if (!self->islands[i].cells.population) {
+      celllist_free(&self->islands[i].cells);
+      arrdelswap(self->islands, i);
+    }
+  }
+  islands_merge(self);
+
+  self->step_nb += 1;
+  if (self->step_nb % ISLANDS_SPLIT_INTERVAL == 0) {
+    // Parts split off are appended, past island_nb
+    const u64 island_nb = arrlenu(self->islands);
+    for (u64 i = 0; i < island_nb; i++) {
+      islands_split(self, i, &self->arenas[0]);
+    }
+  }
+
+  for (u64 i = 0; i < arrlenu(self->arenas); i++) {
+    arena_reset(&self->arenas[i]);
+  }
+}
+
+u64 islands_population(const IslandMap *const self) {
+  u64 population = 0;
+  for (u64 i = 0; i < arrlenu(self->islands); i++) {
+    population += self->islands[i].cells.population;
+  }
+  return population;
+}
+
+u64 islands_hash(const IslandMap *const self) {
+  u64 hash = 0;
+  for (u64 i = 0; i < arrlenu(self->islands); i++) {
+    hash ^= self->islands[i].cells.hash;
+  }
+  return hash;
+}
+
+void islands_foreach_cell(const IslandMap *const self, CellRect rect,
+                          IslandCellFn fn, void *const ctx) {
+  for (u64 i = 0; i < arrlenu(self->islands); i++) {
+    if (islands_intersect(self->islands[i].box, rect)) {
+      celllist_foreach_cell(&self->islands[i].cells, rect, fn, ctx);
+    }
+  }
+}
@@ -0,0 +1,461 @@
+#include "kernel.h"
+#include "tile.h"
+#include <assert.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_X86
+#endif
+
+typedef void (*KernelTileFn)(Rule rule, const u64 *mid, const u64 *left,
+                             const u64 *right, u64 *out);
+
+// Kernel body shared by every width & rule: V is either u64 or a GCC vector of
+// u64, each lane computes one row. Unaligned loads/stores go through memcpy,
+// which the compiler turns into plain vector moves.
+//
+// Horizontal sums of the rows above and below are 2 bit planes (a, b: bit 0
+// & bit 1), own row only adds west & east (m). Adding the three gives the
+// neighbour count planes: ones, twos, and k1 | k2 | k3 for 4 or more. Exactly
+// one of k1, k2 & k3 is set for 4 to 7 neighbours, k1 & k2 for 8.
+//
+// SETUP runs once per call, NEXT(V, next) computes the next generation from
+// the count planes & the cells (c[1]).
+#define KERNEL_DEFINE(name, attr, V, SETUP, NEXT)                              \
+  attr static void name(Rule rule, const u64 *const mid,                      \
+                        const u64 *const left, const u64 *const right,        \
+                        u64 *const out) {                                      \
+    SETUP(V)                                                                   \
+    for (u32 r = 0; r < TILE_SIZE; r += sizeof(V) / sizeof(u64)) {             \
+      V c[3], w[3], e[3];                                                      \
+      for (u32 i = 0; i < 3; i++) {                                            \
+        V l, rr;                                                               \
+        memcpy(&c[i], &mid[r + i], sizeof(V));                                 \
+        memcpy(&l, &left[r + i], sizeof(V));                                   \
+        memcpy(&rr, &right[r + i], sizeof(V));                                 \
+        w[i] = (c[i] << 1) | (l >> TILE_MASK);                                 \
+        e[i] = (c[i] >> 1) | (rr << TILE_MASK);                                \
+      }                                                                        \
+                                                                               \
+      const V a0 = w[0] ^ c[0] ^ e[0];                                         \
+      const V a1 = (w[0] & c[0]) | (e[0] & (w[0] ^ c[0]));                     \
+      const V b0 = w[2] ^ c[2] ^ e[2];                                         \
+      const V b1 = (w[2] & c[2]) | (e[2] & (w[2] ^ c[2]));                     \
+      const V m0 = w[1] ^ e[1];                                                \
+      const V m1 = w[1] & e[1];                                                \
+                                                                               \
+      const V ones = a0 ^ m0 ^ b0;                                             \
+      const V carry = (a0 & m0) | (b0 & (a0 ^ m0));                            \
+      const V p = a1 ^ m1;                                                     \
+      const V q = b1 ^ carry;                                                  \
+      const V twos = p ^ q;                                                    \
+      const V k1 = a1 & m1;                                                    \
+      const V k2 = b1 & carry;                                                 \
+      const V k3 = p & q;                                                      \
+                                                                               \
+      NEXT(V, next)                                                            \
+      memcpy(&out[r], &next, sizeof(V));                                       \
+    }                                                                          \
+  }
+
+// Conway's Life, hard-wired: 3 neighbours, or 2 neighbours and alive
+#define KERNEL_CONWAY_SETUP(V) (void)rule;
+#define KERNEL_CONWAY_NEXT(V, next)                                            \
+  const V next = twos & ~(k1 | k2 | k3) & (ones | c[1]);
+
+// Any rule: the birth & survival masks are broadcast to all-0 or all-1 leaves
+// once, then each cell picks its leaf through a multiplexer tree indexed by
+// the count planes, without a branch.
+#define KERNEL_MUX(s, a, b) ((a) ^ (((a) ^ (b)) & (s))) // s ? b : a
+#define KERNEL_RULE_SETUP(V)                                                   \
+  V born[9], flip[9];                                                          \
+  for (u32 n = 0; n < 9; n++) {                                                \
+    born[n] = (V){0} - (u64)(rule.birth >> n & 1);                             \
+    flip[n] = born[n] ^ ((V){0} - (u64)(rule.survival >> n & 1));              \
+  }
+#define KERNEL_RULE_NEXT(V, next)                                              \
+  V leaves[9], pairs[4];                                                       \
+  for (u32 n = 0; n < 9; n++) {                                                \
+    leaves[n] = born[n] ^ (flip[n] & c[1]);                                    \
+  }                                                                            \
+  for (u32 n = 0; n < 4; n++) {                                                \
+    pairs[n] = KERNEL_MUX(ones, leaves[2 * n], leaves[2 * n + 1]);             \
+  }                                                                            \
+  const V fours = (k1 ^ k2) | k3;                                              \
+  const V eights = k1 & k2;                                                    \
+  const V low = KERNEL_MUX(twos, pairs[0], pairs[1]);                          \
+  const V high = KERNEL_MUX(twos, pairs[2], pairs[3]);                         \
+  const V next = KERNEL_MUX(eights, KERNEL_MUX(fours, low, high), leaves[8]);
+
+// Isotropic rules: the 9 cells of the neighbourhood are 9 bit planes, the
+// table of the rule a multiplexer tree of 512 leaves indexed by them (see
+// rule.h for the bit order). The 4 leaves under each node of the first 2 planes
+// are one of the 16 functions of those planes, computed once per row: 128
+// leaves are picked by their table bits, then 127 multiplexers gather the 7
+// other planes, 16 leaves at a time to stay in registers.
+#define KERNEL_TABLE_SETUP(V)                                                  \
+  u8 codes[RULE_NEIGHBOURHOODS / 4];                                           \
+  for (u32 n = 0; n < RULE_NEIGHBOURHOODS / 4; n++) {                          \
+    codes[n] = (u8)(rule.table[n / 16] >> (n % 16 * 4) & 15);                  \
+  }
+#define KERNEL_TABLE_NEXT(V, next)                                             \
+  (void)ones, (void)twos, (void)k1, (void)k2, (void)k3; /* No count */         \
+  const V planes[9] = {w[0], c[0], e[0], w[1], c[1], e[1], w[2], c[2], e[2]}; \
+  const V terms[4] = {~(planes[0] | planes[1]), planes[0] & ~planes[1],        \
+                      ~planes[0] & planes[1], planes[0] & planes[1]};          \
+  V functions[16], groups[8];                                                  \
+  functions[0] = (V){0};                                                       \
+  for (u32 f = 1; f < 16; f++) {                                               \
+    functions[f] = functions[f & (f - 1)] | terms[__builtin_ctz(f)];           \
+  }                                                                            \
+  for (u32 g = 0; g < 8; g++) {                                                \
+    V nodes[16];                                                               \
+    for (u32 n = 0; n < 16; n++) {                                             \
+      nodes[n] = functions[codes[g * 16 + n]];                                 \
+    }                                                                          \
+    for (u32 plane = 2, width = 8; plane < 6; plane++, width /= 2) {           \
+      for (u32 n = 0; n < width; n++) {                                        \
+        nodes[n] = KERNEL_MUX(planes[plane], nodes[2 * n], nodes[2 * n + 1]);  \
+      }                                                                        \
+    }                                                                          \
+    groups[g] = nodes[0];                                                      \
+  }                                                                            \
+  for (u32 plane = 6, width = 4; plane < 9; plane++, width /= 2) {             \
+    for (u32 n = 0; n < width; n++) {                                          \
+      groups[n] = KERNEL_MUX(planes[plane], groups[2 * n], groups[2 * n + 1]); \
+    }                                                                          \
+  }                                                                            \
+  const V next = groups[0];
+
+KERNEL_DEFINE(kernel_tile_scalar, , u64, KERNEL_CONWAY_SETUP,
+              KERNEL_CONWAY_NEXT)
+KERNEL_DEFINE(kernel_rule_scalar, , u64, KERNEL_RULE_SETUP, KERNEL_RULE_NEXT)
+// Vectorizing the scalar tree over its nodes only adds shuffles
+KERNEL_DEFINE(kernel_table_scalar,
+              __attribute__((optimize("no-tree-vectorize"))), u64,
+              KERNEL_TABLE_SETUP, KERNEL_TABLE_NEXT)
+
+#ifdef KERNEL_X86
+typedef u64 KernelVec128 __attribute__((vector_size(16)));
+typedef u64 KernelVec256 __attribute__((vector_size(32)));
+typedef u64 KernelVec512 __attribute__((vector_size(64)));
+
+#define KERNEL_DEFINE_X86(suffix, isa, V)                                      \
+  KERNEL_DEFINE(kernel_tile_##suffix, __attribute__((target(isa))), V,         \
+                KERNEL_CONWAY_SETUP, KERNEL_CONWAY_NEXT)                       \
+  KERNEL_DEFINE(kernel_rule_##suffix, __attribute__((target(isa))), V,         \
+                KERNEL_RULE_SETUP, KERNEL_RULE_NEXT)                           \
+  KERNEL_DEFINE(kernel_table_##suffix, __attribute__((target(isa))), V,        \
+                KERNEL_TABLE_SETUP, KERNEL_TABLE_NEXT)
+
+KERNEL_DEFINE_X86(sse2, "sse2", KernelVec128)
+KERNEL_DEFINE_X86(avx2, "avx2", KernelVec256)
+KERNEL_DEFINE_X86(avx512, "avx512f", KernelVec512)
+#endif
+
+typedef void (*KernelStateTileFn)(Rule rule, const u8 *heads, const u8 *cells,
+                                  u8 *out);
+
+// 8 bytes of 0 or 1 to 8 bits, byte i to bit i: the multiply adds each byte
+// to the top byte at its own bit, without carries
+static inline u64 kernel_pack_bytes(u64 bytes) {
+  return bytes * 0x0102040810204080ull >> 56;
+}
+
+// 8 bits to 8 bytes of 0 or 1: bit i is copied to every byte and only kept
+// at bit i of byte i, then moved to bit 0 by a carry from the low 7 bits
+static inline u64 kernel_spread_bits(u64 bits) {
+  const u64 kept = bits * 0x0101010101010101ull & 0x8040201008040201ull;
+  return (kept + 0x7f7f7f7f7f7f7f7full) >> 7 & 0x0101010101010101ull;
+}
+
+// Multi-state kernel body: plain loops over the 64 cells of a row, which the
+// compiler vectorizes for the target of each variant (one byte per cell, so
+// 16 to 64 cells per instruction). Births & survivals only compare the counts
+// for the neighbour counts the rule uses, rather than a per cell lookup or
+// branch. Isotropic rules pack the state 1 flags in bit rows for the bit-sliced
+// kernel of the same width, table, and spread its births & survivals back.
+#define KERNEL_STATE_DEFINE(name, attr, table)                                 \
+  attr static void name(Rule rule, const u8 *const heads,                     \
+                        const u8 *const cells, u8 *const out) {                \
+    const u8 states = (u8)rule_states(rule);                                   \
+    const u8 dying = states > 2 ? 2 : 0; /* State of a dying alive cell */     \
+    u64 alive[TILE_SIZE];                                                      \
+    if (rule.isotropic) {                                                      \
+      u64 mid[TILE_HALO_SIZE], left[TILE_HALO_SIZE], right[TILE_HALO_SIZE];    \
+      for (u32 r = 0; r < TILE_HALO_SIZE; r++) {                               \
+        const u8 *const row = &heads[r * TILE_HALO_SIZE];                      \
+        mid[r] = 0;                                                            \
+        for (u32 x = 0; x < TILE_SIZE; x += 8) {                               \
+          u64 bytes;                                                           \
+          memcpy(&bytes, &row[x + 1], sizeof(bytes));                          \
+          mid[r] |= kernel_pack_bytes(bytes) << x;                             \
+        }                                                                      \
+        left[r] = (u64)row[0] << TILE_MASK;                                    \
+        right[r] = row[TILE_SIZE + 1];                                         \
+      }                                                                        \
+      table(rule, mid, left, right, alive);                                    \
+    }                                                                          \
+                                                                               \
+    for (u32 r = 0; r < TILE_SIZE; r++) {                                      \
+      const u8 *const above = &heads[r * TILE_HALO_SIZE];                      \
+      const u8 *const mid = above + TILE_HALO_SIZE;                            \
+      const u8 *const below = mid + TILE_HALO_SIZE;                            \
+      const u8 *const cell = &cells[r * TILE_SIZE];                            \
+      u8 *const next = &out[r * TILE_SIZE];                                    \
+                                                                               \
+      u8 birth[TILE_SIZE] = {0}, survival[TILE_SIZE] = {0};                    \
+      if (rule.isotropic) {                                                    \
+        /* Each cell was looked up with its own state 1 flag */                \
+        for (u32 x = 0; x < TILE_SIZE; x += 8) {                               \
+          const u64 bytes = kernel_spread_bits(alive[r] >> x & 0xff);          \
+          memcpy(&birth[x], &bytes, sizeof(bytes));                            \
+          memcpy(&survival[x], &bytes, sizeof(bytes));                         \
+        }                                                                      \
+      } else {                                                                 \
+        u8 column[TILE_HALO_SIZE], count[TILE_SIZE];                           \
+        for (u32 x = 0; x < TILE_HALO_SIZE; x++) {                             \
+          column[x] = (u8)(above[x] + mid[x] + below[x]);                      \
+        }                                                                      \
+        for (u32 x = 0; x < TILE_SIZE; x++) {                                  \
+          count[x] =                                                           \
+              (u8)(column[x] + column[x + 1] + column[x + 2] - mid[x + 1]);    \
+        }                                                                      \
+                                                                               \
+        if (rule.family == rule_wireworld) {                                   \
+          for (u32 x = 0; x < TILE_SIZE; x++) {                                \
+            const u8 s = cell[x];                                              \
+            const bool fire = count[x] == 1 || count[x] == 2;                  \
+            next[x] = s == RULE_WIREWORLD_HEAD   ? RULE_WIREWORLD_TAIL         \
+                      : s == RULE_WIREWORLD_TAIL ? RULE_WIREWORLD_CONDUCTOR    \
+                      : s == RULE_WIREWORLD_CONDUCTOR && fire                  \
+                          ? RULE_WIREWORLD_HEAD                                \
+                          : s;                                                 \
+          }                                                                    \
+          continue;                                                            \
+        }                                                                      \
+                                                                               \
+        for (u32 mask = rule.birth; mask; mask &= mask - 1) {                  \
+          const u8 n = (u8)__builtin_ctz(mask);                                \
+          for (u32 x = 0; x < TILE_SIZE; x++) {                                \
+            birth[x] |= count[x] == n;                                         \
+          }                                                                    \
+        }                                                                      \
+        for (u32 mask = rule.survival; mask; mask &= mask - 1) {               \
+          const u8 n = (u8)__builtin_ctz(mask);                                \
+          for (u32 x = 0; x < TILE_SIZE; x++) {                                \
+            survival[x] |= count[x] == n;                                      \
+          }                                                                    \
+        }                                                                      \
+      }                                                                        \
+      for (u32 x = 0; x < TILE_SIZE; x++) {                                    \
+        const u8 s = cell[x];                                                  \
+        const u8 decay = (u8)(s + 1 < states ? s + 1 : 0);                     \
+        next[x] = s == 0   ? birth[x]                                          \
+                  : s == 1 ? (survival[x] ? 1 : dying)                         \
+                           : decay;                                            \
+      }                                                                        \
+    }                                                                          \
+  }
+
+// Larger than Life kernel body: sliding window sums, O(1) per cell whatever
+// the range. column[x] is the sum of the 2R + 1 rows of the window, updated
+// with the row entering & the one leaving it. A prefix sum of column turns
+// each count in a difference
+#define KERNEL_RANGE_DEFINE(name, attr)                                        \
+  attr static void name(Rule rule, const u8 *const heads,                     \
+                        const u8 *const cells, u8 *const out) {                \
+    const u32 range = rule.range;                                              \
+    const u32 side = 2 * range + 1;                                            \
+    const u32 width = TILE_SIZE + 2 * range;                                   \
+    const u8 states = (u8)rule_states(rule);                                   \
+    const u8 dying = states > 2 ? 2 : 0;                                       \
+    const u16 middle = rule.middle;                                            \
+    u16 column[TILE_SIZE + 2 * RULE_MAX_RANGE];                                \
+    u16 prefix[TILE_SIZE + 2 * RULE_MAX_RANGE + 1];                            \
+                                                                               \
+    for (u32 x = 0; x < width; x++) {                                          \
+      column[x] = 0;                                                           \
+    }                                                                          \
+    for (u32 j = 0; j < side; j++) {                                           \
+      for (u32 x = 0; x < width; x++) {                                        \
+        column[x] = (u16)(column[x] + heads[j * width + x]);                   \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    for (u32 r = 0; r < TILE_SIZE; r++) {                                      \
+      const u8 *const mid = &heads[(r + range) * width + range];               \
+      const u8 *const cell = &cells[r * TILE_SIZE];                            \
+      u8 *const next = &out[r * TILE_SIZE];                                    \
+                                                                               \
+      prefix[0] = 0;                                                           \
+      for (u32 x = 0; x < width; x++) {                                        \
+        prefix[x + 1] = (u16)(prefix[x] + column[x]);                          \
+      }                                                                        \
+      for (u32 x = 0; x < TILE_SIZE; x++) {                                    \
+        const u16 count = (u16)(prefix[x + side] - prefix[x] -                 \
+                                (middle ? 0 : mid[x]));                        \
+        const u8 s = cell[x];                                                  \
+        const u8 decay = (u8)(s + 1 < states ? s + 1 : 0);                     \
+        const bool born = count >= rule.birth_min && count <= rule.birth_max;  \
+        const bool kept =                                                      \
+            count >= rule.survival_min && count <= rule.survival_max;          \
+        next[x] = s == 0   ? (u8)born                                          \
+                  : s == 1 ? (kept ? 1 : dying)                                \
+                           : decay;                                            \
+      }                                                                        \
+                                                                               \
+      if (r + 1 < TILE_SIZE) {                                                 \
+        const u8 *const enter = &heads[(r + side) * width];                    \
+        const u8 *const leave = &heads[r * width];                             \
+        for (u32 x = 0; x < width; x++) {                                      \
+          column[x] = (u16)(column[x] + enter[x] - leave[x]);                  \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+  }
+
+KERNEL_STATE_DEFINE(kernel_state_scalar,
+                    __attribute__((optimize("no-tree-vectorize"))),
+                    kernel_table_scalar)
+KERNEL_RANGE_DEFINE(kernel_range_scalar,
+                    __attribute__((optimize("no-tree-vectorize"))))
+#ifdef KERNEL_X86
+KERNEL_STATE_DEFINE(kernel_state_sse2, __attribute__((target("sse2"))),
+                    kernel_table_sse2)
+KERNEL_STATE_DEFINE(kernel_state_avx2, __attribute__((target("avx2"))),
+                    kernel_table_avx2)
+KERNEL_STATE_DEFINE(kernel_state_avx512,
+                    __attribute__((target("avx512f,avx512bw"))),
+                    kernel_table_avx512)
+KERNEL_RANGE_DEFINE(kernel_range_sse2, __attribute__((target("sse2"))))
+KERNEL_RANGE_DEFINE(kernel_range_avx2, __attribute__((target("avx2"))))
+KERNEL_RANGE_DEFINE(kernel_range_avx512,
+                    __attribute__((target("avx512f,avx512bw"))))
+#endif
+
+static const char *const kernel_names[kernel_kind_count] = {
+    [kernel_scalar] = "scalar",
+    [kernel_sse2] = "sse2",
+    [kernel_avx2] = "avx2",
+    [kernel_avx512] = "avx512",
+};
+
+static const KernelTileFn kernel_fns[kernel_kind_count] = {
+    [kernel_scalar] = &kernel_tile_scalar,
+#ifdef KERNEL_X86
+    [kernel_sse2] = &kernel_tile_sse2,
+    [kernel_avx2] = &kernel_tile_avx2,
+    [kernel_avx512] = &kernel_tile_avx512,
+#endif
+};
+
+static const KernelTileFn kernel_rule_fns[kernel_kind_count] = {
+    [kernel_scalar] = &kernel_rule_scalar,
+#ifdef KERNEL_X86
+    [kernel_sse2] = &kernel_rule_sse2,
+    [kernel_avx2] = &kernel_rule_avx2,
+    [kernel_avx512] = &kernel_rule_avx512,
+#endif
+};
+
+static const KernelTileFn kernel_table_fns[kernel_kind_count] = {
+    [kernel_scalar] = &kernel_table_scalar,
+#ifdef KERNEL_X86
+    [kernel_sse2] = &kernel_table_sse2,
+    [kernel_avx2] = &kernel_table_avx2,
+    [kernel_avx512] = &kernel_table_avx512,
+#endif
+};
+
+static const KernelStateTileFn kernel_state_fns[kernel_kind_count] = {
+    [kernel_scalar] = &kernel_state_scalar,
+#ifdef KERNEL_X86
+    [kernel_sse2] = &kernel_state_sse2,
+    [kernel_avx2] = &kernel_state_avx2,
+    [kernel_avx512] = &kernel_state_avx512,
+#endif
+};
+
+static const KernelStateTileFn kernel_range_fns[kernel_kind_count] = {
+    [kernel_scalar] = &kernel_range_scalar,
+#ifdef KERNEL_X86
+    [kernel_sse2] = &kernel_range_sse2,
+    [kernel_avx2] = &kernel_range_avx2,
+    [kernel_avx512] = &kernel_range_avx512,
+#endif
+};
+
+static bool kernel_supported_kinds[kernel_kind_count] = {
+    [kernel_scalar] = true,
+};
+static KernelKind kernel_current = kernel_scalar;
+
+void kernel_init(void) {
+#ifdef KERNEL_X86
+  __builtin_cpu_init();
+  kernel_supported_kinds[kernel_sse2] = __builtin_cpu_supports("sse2");
+  kernel_supported_kinds[kernel_avx2] = __builtin_cpu_supports("avx2");
+  // Byte operations of the multi-state kernel need BW
+  kernel_supported_kinds[kernel_avx512] = __builtin_cpu_supports("avx512f") &&
+                                          __builtin_cpu_supports("avx512bw");
+#endif
+
+  kernel_current = kernel_best();
+}
+
+bool kernel_supported(KernelKind kind) {
+  assert(kind < kernel_kind_count && "Unknown kernel kind");
+  return kernel_supported_kinds[kind];
+}
+
+KernelKind kernel_best(void) {
+  for (u32 i = kernel_kind_count; i-- > 0;) {
+    if (kernel_supported_kinds[i]) {
+      return (KernelKind)i;
+    }
+  }
+  return kernel_scalar;
+}
+
+bool kernel_select(KernelKind kind) {
+  if (!kernel_supported(kind)) {
+    return false;
+  }
+  kernel_current = kind;
+  return true;
+}
+
+KernelKind kernel_selected(void) { return kernel_current; }
+
+const char *kernel_name(KernelKind kind) {
+  assert(kind < kernel_kind_count && "Unknown kernel kind");
+  return kernel_names[kind];
+}
+
+bool kernel_from_name(const char *const name, KernelKind *const kind) {
+  for (u32 i = 0; i < kernel_kind_count; i++) {
+    if (!strcmp(name, kernel_names[i])) {
+      *kind = (KernelKind)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void kernel_tile(Rule rule, const u64 *const mid, const u64 *const left,
+                 const u64 *const right, u64 *const out) {
+  // Conway's Life keeps its hard-wired kernel
+  const KernelTileFn *const fns = rule.isotropic         ? kernel_table_fns
+                                  : rule_is_conway(rule) ? kernel_fns
+                                                         : kernel_rule_fns;
+  fns[kernel_current](rule_resolve(rule), mid, left, right, out);
+}
+
+void kernel_state_tile(Rule rule, const u8 *const heads, const u8 *const cells,
+                       u8 *const out) {
+  const KernelStateTileFn *const fns = rule.family == rule_larger_than_life
+                                           ? kernel_range_fns
+                                           : kernel_state_fns;
+  fns[kernel_current](rule_resolve(rule), heads, cells, out);
+}
@@ -0,0 +1,73 @@
+#include "morton.h"
+#include <assert.h>
+
+// Bits of the same coordinate as bit, below it
+static inline u64 morton_below(u32 bit) {
+  return (bit & 1 ? MORTON_Y_BITS : MORTON_X_BITS) & ((1ull << bit) - 1);
+}
+
+u64 morton_bigmin(u64 code, u64 min, u64 max) {
+  u64 bigmin = 0;
+
+  // From the top bit down, min & max close in on the part of the rectangle
+  // past code
+  for (u32 bit = 64; bit-- > 0;) {
+    const u64 mask = 1ull << bit;
+    const u32 bits = (u32)((code & mask) != 0) << 2 |
+                     (u32)((min & mask) != 0) << 1 | (u32)((max & mask) != 0);
+
+    switch (bits) {
+    case 0b000:
+    case 0b111:
+      break;
+    case 0b001: // Past code in the upper half, or below in the lower one
+      bigmin = (min | mask) & ~morton_below(bit);
+      max = (max & ~mask) | morton_below(bit);
+      break;
+    case 0b011: // The whole rectangle is past code
+      return min;
+    case 0b100: // The whole rectangle is before code
+      return bigmin;
+    case 0b101: // Only the upper half can be past code
+      min = (min | mask) & ~morton_below(bit);
+      break;
+    default:
+      assert(0 && "min has to be below max");
+    }
+  }
+
+  return bigmin;
+}
+
+// Index of the first of the sorted codes[begin, n) >= code
+static u64 morton_lower_bound(const u64 *const codes, u64 begin, u64 n,
+                              u64 code) {
+  while (begin < n) {
+    const u64 mid = begin + (n - begin) / 2;
+    if (codes[mid] < code) {
+      begin = mid + 1;
+    } else {
+      n = mid;
+    }
+  }
+  return begin;
+}
+
+void morton_foreach(const u64 *const codes, u64 n, CellRect rect,
+                    MortonFn fn, void *ctx) {
+  const u64 min = morton_encode(rect.min_x, rect.min_y);
+  const u64 max = morton_encode(rect.max_x, rect.max_y);
+
+  u64 i = morton_lower_bound(codes, 0, n, min);
+  while (i < n && codes[i] <= max) {
+    const i32 x = morton_x(codes[i]);
+    const i32 y = morton_y(codes[i]);
+    if (cellrect_contains(rect, x, y)) {
+      fn(ctx, x, y);
+      i += 1;
+    } else {
+      i = morton_lower_bound(codes, i + 1, n,
+                             morton_bigmin(codes[i], min, max));
+    }
+  }
+}
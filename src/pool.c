@@ -0,0 +1,216 @@
+#include "pool.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+u32 pool_hardware_threads(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+  const long thread_nb = sysconf(_SC_NPROCESSORS_ONLN);
+  if (thread_nb > 0) {
+    return thread_nb < POOL_MAX_THREADS ? (u32)thread_nb : POOL_MAX_THREADS;
+  }
+#endif
+  return 1;
+}
+
+// Task scheduling
+//
+
+// Takes the next task of the worker's own range
+static bool pool_pop(PoolWorker *const worker, u32 *const task) {
+  mtx_lock(&worker->mtx);
+  const bool found = worker->begin < worker->end;
+  if (found) {
+    *task = worker->begin++;
+  }
+  mtx_unlock(&worker->mtx);
+  return found;
+}
+
+// Moves the back half of another worker's range to this one and takes its
+// first task. Victims are visited in a fixed order from the next worker on
+static bool pool_steal(PoolWorker *const worker, u32 *const task) {
+  ThreadPool *const pool = worker->pool;
+
+  for (u32 i = 1; i < pool->thread_nb; i++) {
+    PoolWorker *const victim =
+        &pool->workers[(worker->index + i) % pool->thread_nb];
+
+    mtx_lock(&victim->mtx);
+    const u32 left = victim->end - victim->begin;
+    const u32 end = victim->end;
+    if (left) {
+      victim->end -= (left + 1) / 2;
+    }
+    const u32 begin = victim->end;
+    mtx_unlock(&victim->mtx);
+
+    if (left) {
+      mtx_lock(&worker->mtx);
+      worker->begin = begin + 1;
+      worker->end = end;
+      mtx_unlock(&worker->mtx);
+      *task = begin;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Tasks never create tasks: once every range is empty the job is over
+static void pool_work(PoolWorker *const worker) {
+  ThreadPool *const pool = worker->pool;
+  u32 task;
+
+  while (pool_pop(worker, &task) || pool_steal(worker, &task)) {
+    pool->fn(pool->ctx, worker->index, task);
+  }
+}
+
+static i32 pool_thread(void *arg) {
+  PoolWorker *const worker = (PoolWorker *)arg;
+  ThreadPool *const pool = worker->pool;
+  u64 job = 0;
+
+  mtx_lock(&pool->mtx);
+  while (true) {
+    while (!pool->quit && pool->job == job) {
+      cnd_wait(&pool->start, &pool->mtx);
+    }
+    if (pool->quit) {
+      break;
+    }
+    job = pool->job;
+    mtx_unlock(&pool->mtx);
+
+    pool_work(worker);
+
+    mtx_lock(&pool->mtx);
+    pool->busy -= 1;
+    if (!pool->busy) {
+      cnd_signal(&pool->done);
+    }
+  }
+  mtx_unlock(&pool->mtx);
+
+  return 0;
+}
+
+// Pool
+//
+
+void pool_create(ThreadPool *const self, u32 thread_nb, Error *const err) {
+  assert(err && "err can't be NULL, error handling is important!");
+
+  *self = (ThreadPool){0};
+  if (err->status) {
+    return;
+  }
+
+  if (!thread_nb) {
+    thread_nb = pool_hardware_threads();
+  }
+  assert(thread_nb <= POOL_MAX_THREADS && "Too many threads");
+
+  // No thread is running until they are all created
+  self->thread_nb = 1;
+  self->workers =
+      aligned_alloc(POOL_CACHE_LINE, thread_nb * sizeof(PoolWorker));
+  self->threads = malloc(thread_nb * sizeof(thrd_t));
+  assert(self->workers && self->threads &&
+         "Not enough memory, this is the end...");
+
+  if (mtx_init(&self->mtx, mtx_plain) == thrd_error ||
+      cnd_init(&self->start) == thrd_error ||
+      cnd_init(&self->done) == thrd_error) {
+    err->msg = "Could not initialize pool sync (" error_print_err_location ").";
+    err->status = true;
+    err->code = error_generic;
+    return;
+  }
+
+  for (u32 i = 0; i < thread_nb; i++) {
+    self->workers[i] = (PoolWorker){.index = i, .pool = self};
+    if (mtx_init(&self->workers[i].mtx, mtx_plain) == thrd_error) {
+      err->msg = "Could not initialize Mutex (" error_print_err_location ").";
+      err->status = true;
+      err->code = error_generic;
+      return;
+    }
+  }
+
+  // Worker 0 is the thread calling pool_run. Only the threads created so far
+  // are joined on destroy
+  for (u32 i = 1; i < thread_nb; i++) {
+    if (thrd_create(&self->threads[i], &pool_thread, &self->workers[i]) !=
+        thrd_success) {
+      err->msg = "Could not create thread (" error_print_err_location ").";
+      err->status = true;
+      err->code = error_generic;
+      return;
+    }
+    self->thread_nb = i + 1;
+  }
+}
+
+void pool_destroy(ThreadPool *const self) {
+  if (!self->workers) {
+    return;
+  }
+
+  mtx_lock(&self->mtx);
+  self->quit = true;
+  cnd_broadcast(&self->start);
+  mtx_unlock(&self->mtx);
+
+  for (u32 i = 1; i < self->thread_nb; i++) {
+    thrd_join(self->threads[i], NULL);
+  }
+  for (u32 i = 0; i < self->thread_nb; i++) {
+    mtx_destroy(&self->workers[i].mtx);
+  }
+
+  cnd_destroy(&self->start);
+  cnd_destroy(&self->done);
+  mtx_destroy(&self->mtx);
+  free(self->workers);
+  free(self->threads);
+  *self = (ThreadPool){0};
+}
+
+void pool_run(ThreadPool *const self, u32 task_nb, PoolTaskFn fn,
+              void *const ctx) {
+  if (!self || self->thread_nb <= 1 || task_nb <= 1) {
+    for (u32 task = 0; task < task_nb; task++) {
+      fn(ctx, 0, task);
+    }
+    return;
+  }
+
+  // Workers are idle between jobs, ranges can be set without their locks
+  for (u32 i = 0; i < self->thread_nb; i++) {
+    self->workers[i].begin = (u32)((u64)task_nb * i / self->thread_nb);
+    self->workers[i].end = (u32)((u64)task_nb * (i + 1) / self->thread_nb);
+  }
+
+  mtx_lock(&self->mtx);
+  self->fn = fn;
+  self->ctx = ctx;
+  self->busy = self->thread_nb - 1;
+  self->job += 1;
+  cnd_broadcast(&self->start);
+  mtx_unlock(&self->mtx);
+
+  pool_work(&self->workers[0]);
+
+  mtx_lock(&self->mtx);
+  while (self->busy) {
+    cnd_wait(&self->done, &self->mtx);
+  }
+  mtx_unlock(&self->mtx);
+}
+
+u32 pool_thread_nb(const ThreadPool *const self) {
+  return self ? self->thread_nb : 1;
+}
@@ -0,0 +1,40 @@
+#include "radix.h"
+#include <string.h>
+
+void radix_sort(u64 *keys, u64 *tmp, u64 n) {
+  if (!n) {
+    return;
+  }
+
+  u64 counts[sizeof(u64)][256] = {0};
+  for (u64 i = 0; i < n; i++) {
+    for (u32 b = 0; b < sizeof(u64); b++) {
+      counts[b][keys[i] >> (8 * b) & 0xFF] += 1;
+    }
+  }
+
+  u64 *src = keys, *dst = tmp;
+  for (u32 b = 0; b < sizeof(u64); b++) {
+    if (counts[b][src[0] >> (8 * b) & 0xFF] == n) {
+      continue;
+    }
+
+    u64 offsets[256];
+    u64 offset = 0;
+    for (u32 d = 0; d < 256; d++) {
+      offsets[d] = offset;
+      offset += counts[b][d];
+    }
+    for (u64 i = 0; i < n; i++) {
+      dst[offsets[src[i] >> (8 * b) & 0xFF]++] = src[i];
+    }
+
+    u64 *const swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != keys) {
+    memcpy(keys, src, n * sizeof(u64));
+  }
+}
@@ -0,0 +1,62 @@
+#include "render.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+void render_buffer_free(RenderBuffer *const self) {
+  arrfree(self->cells);
+  *self = (RenderBuffer){0};
+}
+
+static void render_push_alive_cell(void *const ctx, i64 x, i64 y) {
+  RenderCell **const cells = (RenderCell **)ctx;
+  const RenderCell cell = {.x = x, .y = y};
+  arrput(*cells, cell);
+}
+
+static void render_count_cell(void *const ctx, i64 x, i64 y, u8 state) {
+  (void)x;
+  (void)y;
+  ((u32 *)ctx)[state] += 1;
+}
+
+// ends[state] is the next index of state until the buffer is full, then the
+// end of its run
+static void render_push_cell(void *const ctx, i64 x, i64 y, u8 state) {
+  RenderBuffer *const self = (RenderBuffer *)ctx;
+  const RenderCell cell = {.x = x, .y = y};
+  self->cells[self->ends[state]++] = cell;
+}
+
+void render_buffer_fill(RenderBuffer *const self, const Engine *const engine,
+                        CellRect64 view) {
+  self->rule = engine->rule;
+
+  if (rule_states(engine->rule) == 2) {
+    // Every cell is in state 1
+    if (self->cells) {
+      arrdeln(self->cells, 0, arrlenu(self->cells));
+    }
+    engine_foreach_cell(engine, view, &render_push_alive_cell, &self->cells);
+    self->ends[0] = 0;
+    self->ends[1] = (u32)arrlenu(self->cells);
+    return;
+  }
+
+  // Count the cells of each state in view, start each run where the previous
+  // one ends, then iterate over them again to fill the runs
+  //
+  u32 counts[RULE_MAX_STATES + 1] = {0};
+  engine_foreach_state(engine, view, &render_count_cell, counts);
+
+  u32 total = 0;
+  for (u32 state = 0; state <= RULE_MAX_STATES; state++) {
+    self->ends[state] = total;
+    total += counts[state];
+  }
+  arrsetlen(self->cells, total);
+  engine_foreach_state(engine, view, &render_push_cell, self);
+}
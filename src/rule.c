@@ -0,0 +1,421 @@
+#include "rule.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct RuleName {
+  const char *name;
+  Rule rule;
+} RuleName;
+
+static const RuleName rule_names[] = {
+    {"life", {.birth = 1 << 3, .survival = 1 << 2 | 1 << 3}},
+    {"highlife", {.birth = 1 << 3 | 1 << 6, .survival = 1 << 2 | 1 << 3}},
+    {"daynight",
+     {.birth = 1 << 3 | 1 << 6 | 1 << 7 | 1 << 8,
+      .survival = 1 << 3 | 1 << 4 | 1 << 6 | 1 << 7 | 1 << 8}},
+    {"seeds", {.birth = 1 << 2, .survival = 0}},
+    {"brain", {.family = rule_generations, .birth = 1 << 2, .states = 3}},
+    {"starwars",
+     {.family = rule_generations,
+      .birth = 1 << 2,
+      .survival = 1 << 3 | 1 << 4 | 1 << 5,
+      .states = 4}},
+    {"wireworld", {.family = rule_wireworld}},
+    {"bosco",
+     {.family = rule_larger_than_life,
+      .range = 5,
+      .middle = true,
+      .birth_min = 34,
+      .birth_max = 45,
+      .survival_min = 34,
+      .survival_max = 58}},
+    {"majority",
+     {.family = rule_larger_than_life,
+      .range = 4,
+      .middle = true,
+      .birth_min = 41,
+      .birth_max = 81,
+      .survival_min = 41,
+      .survival_max = 81}},
+};
+
+// Hensel notation
+//
+
+// The 8 neighbours of a cell as a ring, clockwise from north: bit 0 N, 1 NE,
+// 2 E, 3 SE, 4 S, 5 SW, 6 W, 7 NW. Rotating the ring by 2 turns the
+// neighbourhood by 90 degrees, mirroring it maps bit i to bit (8 - i) % 8.
+
+#define RULE_RINGS 256
+
+// Bit of each ring neighbour in a neighbourhood (see rule.h)
+static const u8 rule_ring_bits[8] = {1, 2, 5, 8, 7, 6, 3, 0};
+
+// Letters of the shapes of each count up to 4, in canonical order, and one
+// ring of each shape. Count n above 4 uses the letters of 8 - n for the
+// complement rings. 0 & 8 have a single shape, without letter
+static const char rule_hensel_letters[] = "cekainyqjrtwz";
+static const u8 rule_hensel_shape_nb[5] = {1, 2, 6, 10, 13};
+static const u8 rule_hensel_rings[5][13] = {
+    {0x00},
+    {0x02, 0x01},
+    {0x0a, 0x05, 0x09, 0x03, 0x11, 0x22},
+    {0x2a, 0x15, 0x25, 0x07, 0x83, 0x0b, 0x29, 0x23, 0x43, 0x13},
+    {0xaa, 0x55, 0x4b, 0x0f, 0x1b, 0x8b, 0x2b, 0x27, 0x53, 0x17, 0x39, 0x63,
+     0x33},
+};
+
+static inline bool rule_rings_has(const u64 *const rings, u32 ring) {
+  return rings[ring >> 6] >> (ring & 63) & 1;
+}
+
+static inline u32 rule_hensel_shapes(u32 n) {
+  return rule_hensel_shape_nb[n <= 4 ? n : 8 - n];
+}
+
+// Ring of the shape of count n with the given letter index
+static u8 rule_hensel_ring(u32 n, u32 letter) {
+  return n <= 4 ? rule_hensel_rings[n][letter]
+                : (u8)~rule_hensel_rings[8 - n][letter];
+}
+
+// Sets the rings of the 8 rotations & reflections of ring
+static void rule_rings_add_shape(u64 *const rings, u8 ring) {
+  for (u32 turn = 0; turn < 8; turn += 2) {
+    const u8 turned = (u8)(ring << turn | ring >> (8 - turn));
+    u8 mirrored = 0;
+    for (u32 i = 0; i < 8; i++) {
+      mirrored |= (u8)((turned >> i & 1) << ((8 - i) & 7));
+    }
+    rings[turned >> 6] |= 1ull << (turned & 63);
+    rings[mirrored >> 6] |= 1ull << (mirrored & 63);
+  }
+}
+
+// Parses the counts of a B or S part, up to '/' or the end. A count is followed
+// by the letters of the shapes it is restricted to, by '-' and the letters of
+// the shapes it excludes, or by nothing for every shape. rings gets the rings
+// of the part, hensel is set if there was any letter
+static const char *rule_parse_counts(const char *str, u64 *const rings,
+                                     bool *const hensel) {
+  memset(rings, 0, RULE_RINGS / 8);
+  while (*str && *str != '/') {
+    if (*str < '0' || *str > '8') {
+      return NULL;
+    }
+    const u32 n = (u32)(*str++ - '0');
+    const bool exclude = *str == '-';
+    str += exclude;
+
+    const u32 shape_nb = rule_hensel_shapes(n);
+    u32 letters = 0;
+    for (const char *letter;
+         *str && (letter = strchr(rule_hensel_letters,
+                                  tolower((unsigned char)*str)));
+         str++) {
+      const u32 index = (u32)(letter - rule_hensel_letters);
+      if (shape_nb == 1 || index >= shape_nb || letters >> index & 1) {
+        return NULL;
+      }
+      letters |= 1u << index;
+    }
+    if (exclude && !letters) {
+      return NULL;
+    }
+    *hensel |= letters != 0;
+
+    if (!letters || exclude) {
+      letters ^= (1u << shape_nb) - 1;
+    }
+    for (u32 index = 0; index < shape_nb; index++) {
+      if (letters >> index & 1) {
+        rule_rings_add_shape(rings, rule_hensel_ring(n, index));
+      }
+    }
+  }
+  return str;
+}
+
+// Bit n of the mask is set if the rings have a ring of n neighbours
+static u16 rule_rings_mask(const u64 *const rings) {
+  u16 mask = 0;
+  for (u32 ring = 0; ring < RULE_RINGS; ring++) {
+    if (rule_rings_has(rings, ring)) {
+      mask |= (u16)(1 << __builtin_popcount(ring));
+    }
+  }
+  return mask;
+}
+
+// True if the rings have every ring of the counts in mask and no other
+static bool rule_rings_totalistic(const u64 *const rings, u16 mask) {
+  for (u32 ring = 0; ring < RULE_RINGS; ring++) {
+    if (rule_rings_has(rings, ring) !=
+        (mask >> __builtin_popcount(ring) & 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Fills the table of an isotropic rule from the rings of its B & S parts
+static void rule_fill_table(Rule *const rule, const u64 *const birth,
+                            const u64 *const survival) {
+  memset(rule->table, 0, sizeof(rule->table));
+  for (u32 n = 0; n < RULE_NEIGHBOURHOODS; n++) {
+    u32 ring = 0;
+    for (u32 i = 0; i < 8; i++) {
+      ring |= (n >> rule_ring_bits[i] & 1) << i;
+    }
+    if (rule_rings_has(n & RULE_NEIGHBOURHOOD_CELL ? survival : birth, ring)) {
+      rule->table[n >> 6] |= 1ull << (n & 63);
+    }
+  }
+}
+
+// Writes the B or S part of an isotropic rule, alive picks the neighbourhoods
+// of alive cells in the table
+static char *rule_format_hensel(const Rule *const rule, bool alive,
+                                char *str) {
+  for (u32 n = 0; n <= 8; n++) {
+    const u32 shape_nb = rule_hensel_shapes(n);
+    u32 letters = 0;
+    for (u32 index = 0; index < shape_nb; index++) {
+      u32 neighbourhood = alive ? RULE_NEIGHBOURHOOD_CELL : 0;
+      const u8 ring = rule_hensel_ring(n, index);
+      for (u32 i = 0; i < 8; i++) {
+        neighbourhood |= (u32)(ring >> i & 1) << rule_ring_bits[i];
+      }
+      letters |= (u32)(rule->table[neighbourhood >> 6] >>
+                           (neighbourhood & 63) &
+                       1)
+                 << index;
+    }
+    if (!letters) {
+      continue;
+    }
+
+    *str++ = (char)('0' + n);
+    const u32 shown = (u32)__builtin_popcount(letters);
+    if (shown == shape_nb) {
+      continue;
+    }
+    if (shown > shape_nb - shown) {
+      *str++ = '-';
+      letters ^= (1u << shape_nb) - 1;
+    }
+    for (u32 index = 0; index < shape_nb; index++) {
+      if (letters >> index & 1) {
+        *str++ = rule_hensel_letters[index];
+      }
+    }
+  }
+  return str;
+}
+
+// Parsing
+//
+
+// Parses the number of states of a C part, up to '/' or the end
+static const char *rule_parse_states(const char *str, u8 *const states) {
+  if (!isdigit((unsigned char)*str)) {
+    return NULL;
+  }
+  char *end;
+  const unsigned long parsed = strtoul(str, &end, 10);
+  if ((*end && *end != '/') || parsed < 2 || parsed > RULE_MAX_STATES) {
+    return NULL;
+  }
+  *states = (u8)parsed;
+  return end;
+}
+
+// Parses a number up to max, returns NULL if there is none
+static const char *rule_parse_number(const char *str, u32 max,
+                                     u32 *const value) {
+  if (!isdigit((unsigned char)*str)) {
+    return NULL;
+  }
+  char *end;
+  const unsigned long parsed = strtoul(str, &end, 10);
+  if (parsed > max) {
+    return NULL;
+  }
+  *value = (u32)parsed;
+  return end;
+}
+
+// Parses the "min..max" counts of a Larger than Life S or B part
+static const char *rule_parse_range(const char *str, u16 *const min,
+                                    u16 *const max) {
+  u32 low, high;
+  str = rule_parse_number(str, UINT16_MAX, &low);
+  if (!str || strncmp(str, "..", 2) ||
+      !(str = rule_parse_number(str + 2, UINT16_MAX, &high)) || low > high) {
+    return NULL;
+  }
+  *min = (u16)low;
+  *max = (u16)high;
+  return str;
+}
+
+// Parses the comma separated R, C, M, S, B & N parts of a Larger than Life
+// rule, in any order
+static bool rule_parse_larger_than_life(const char *str, Rule *const rule) {
+  static const char letters[] = "RCMSBN";
+  Rule parsed = {.family = rule_larger_than_life};
+  bool seen[6] = {false, false, false, false, false, false};
+  while (*str) {
+    const char *const letter = strchr(letters, toupper((unsigned char)*str));
+    if (!letter || !*letter || seen[letter - letters]) {
+      return false;
+    }
+    seen[letter - letters] = true;
+
+    u32 value = 0;
+    switch (*letter) {
+    case 'R':
+      str = rule_parse_number(str + 1, RULE_MAX_RANGE, &value);
+      parsed.range = (u8)value;
+      break;
+    case 'C':
+      str = rule_parse_number(str + 1, RULE_MAX_STATES, &value);
+      parsed.states = (u8)value;
+      break;
+    case 'M':
+      str = rule_parse_number(str + 1, 1, &value);
+      parsed.middle = value;
+      break;
+    case 'S':
+      str = rule_parse_range(str + 1, &parsed.survival_min,
+                             &parsed.survival_max);
+      break;
+    case 'B':
+      str = rule_parse_range(str + 1, &parsed.birth_min, &parsed.birth_max);
+      break;
+    default:
+      // Only the Moore neighbourhood
+      str = toupper((unsigned char)str[1]) == 'M' ? str + 2 : NULL;
+    }
+    if (!str || (*str && *str != ',') || (*str == ',' && !*++str)) {
+      return false;
+    }
+  }
+
+  const u32 side = 2u * parsed.range + 1;
+  if (!seen[0] || !seen[3] || !seen[4] || !parsed.range ||
+      parsed.states == 1 || !parsed.birth_min ||
+      parsed.birth_max >= side * side + parsed.middle ||
+      parsed.survival_max >= side * side + parsed.middle) {
+    return false;
+  }
+
+  *rule = parsed;
+  return true;
+}
+
+bool rule_parse(const char *str, Rule *const rule) {
+  for (u32 i = 0; i < sizeof(rule_names) / sizeof(rule_names[0]); i++) {
+    if (!strcmp(str, rule_names[i].name)) {
+      *rule = rule_names[i].rule;
+      return true;
+    }
+  }
+
+  if (toupper((unsigned char)*str) == 'R') {
+    return rule_parse_larger_than_life(str, rule);
+  }
+
+  // B & S parts and an optional C part, each starting with its letter
+  static const char letters[] = "BSC";
+  Rule parsed = {0};
+  bool seen[3] = {false, false, false};
+  u64 birth[RULE_RINGS / 64], survival[RULE_RINGS / 64];
+  while (*str) {
+    const char *const letter = strchr(letters, toupper((unsigned char)*str));
+    if (!letter || !*letter || seen[letter - letters]) {
+      return false;
+    }
+    seen[letter - letters] = true;
+
+    switch (*letter) {
+    case 'B':
+      str = rule_parse_counts(str + 1, birth, &parsed.isotropic);
+      parsed.birth = str ? rule_rings_mask(birth) : 0;
+      break;
+    case 'S':
+      str = rule_parse_counts(str + 1, survival, &parsed.isotropic);
+      parsed.survival = str ? rule_rings_mask(survival) : 0;
+      break;
+    default:
+      str = rule_parse_states(str + 1, &parsed.states);
+    }
+    if (!str || (*str == '/' && !*++str)) {
+      return false;
+    }
+  }
+
+  if (!seen[0] || !seen[1] || parsed.birth & 1 ||
+      (!parsed.birth && !parsed.survival)) {
+    return false;
+  }
+  // Letters that add up to whole counts are a totalistic rule. Otherwise the
+  // masks only give the counts in use, the table replaces them
+  parsed.isotropic &= !rule_rings_totalistic(birth, parsed.birth) ||
+                      !rule_rings_totalistic(survival, parsed.survival);
+  if (parsed.isotropic) {
+    rule_fill_table(&parsed, birth, survival);
+    parsed.birth = parsed.survival = 0;
+  }
+  // 2 states is the Life-like rule
+  if (parsed.states > 2) {
+    parsed.family = rule_generations;
+  } else {
+    parsed.states = 0;
+  }
+
+  *rule = parsed;
+  return true;
+}
+
+void rule_format(Rule rule, char *str) {
+  rule = rule_resolve(rule);
+
+  if (rule.family == rule_wireworld) {
+    strcpy(str, "wireworld");
+    return;
+  }
+  if (rule.family == rule_larger_than_life) {
+    sprintf(str, "R%u,C%u,M%u,S%u..%u,B%u..%u,NM", rule.range, rule.states,
+            rule.middle, rule.survival_min, rule.survival_max, rule.birth_min,
+            rule.birth_max);
+    return;
+  }
+
+  *str++ = 'B';
+  if (rule.isotropic) {
+    str = rule_format_hensel(&rule, false, str);
+  }
+  for (u32 n = 0; n < 9; n++) {
+    if (rule.birth >> n & 1) {
+      *str++ = (char)('0' + n);
+    }
+  }
+  *str++ = '/';
+  *str++ = 'S';
+  if (rule.isotropic) {
+    str = rule_format_hensel(&rule, true, str);
+  }
+  for (u32 n = 0; n < 9; n++) {
+    if (rule.survival >> n & 1) {
+      *str++ = (char)('0' + n);
+    }
+  }
+  *str = '\0';
+
+  if (rule.family == rule_generations) {
+    sprintf(str, "/C%u", rule.states);
+  }
+}
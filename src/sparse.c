@@ -0,0 +1,306 @@
+#include "sparse.h"
+#include "timer.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+// Flags a neighbourhood whose key is in SparseShard.candidates
+#define SPARSE_CANDIDATE (1u << 9)
+
+// A step rebuilds the alive cells of a shard unless there are more than
+// SPARSE_REBUILD of them per flip: copying survivors then costs less than the
+// tombstones erasing deaths would leave
+#define SPARSE_REBUILD 4
+
+static inline u32 sparse_region_shard(i32 region_x, i32 region_y) {
+  return (u32)((cellset_key(region_x, region_y) * 0x9E3779B97F4A7C15ull) >>
+               (64 - SPARSE_SHARD_BITS));
+}
+
+static inline u32 sparse_shard(i32 x, i32 y) {
+  return sparse_region_shard(x >> SPARSE_REGION_SHIFT,
+                             y >> SPARSE_REGION_SHIFT);
+}
+
+// Whether the 3x3 cells around (x, y) are all in its region
+static inline bool sparse_inner(i32 x, i32 y) {
+  const u32 mask = SPARSE_REGION_SIZE - 1;
+  return (((u32)x - 1) & mask) < mask - 1 && (((u32)y - 1) & mask) < mask - 1;
+}
+
+static void sparse_add_candidate(SparseShard *const shard, CellKey key,
+                                 u32 *const neighbourhood) {
+  if (!(*neighbourhood & SPARSE_CANDIDATE)) {
+    *neighbourhood |= SPARSE_CANDIDATE;
+    arrput(shard->candidates, key);
+  }
+}
+
+// A neighbour of (x, y) flips, side is its bit in the neighbourhood.
+// Neighbourhoods are only dropped once evaluated empty, so the candidate flag
+// can't be lost
+static inline void sparse_flip_side(SparseShard *const shard, i32 x, i32 y,
+                                    u32 side) {
+  const CellKey key = cellset_key(x, y);
+  u32 *const neighbourhood = cellset_insert(&shard->neighbourhoods, key, 0);
+  *neighbourhood ^= side;
+  sparse_add_candidate(shard, key, neighbourhood);
+}
+
+// Births & deaths of key on the neighbourhoods shard index holds: the cell
+// itself flags itself alive, others their side of it. The plane ends at the
+// 32-bit edge, cells past it have no neighbourhood so they are never born
+static void sparse_flip_neighbourhoods(SparseShard *const shard, u32 index,
+                                       CellKey key) {
+  const i32 cell_x = cellset_key_x(key);
+  const i32 cell_y = cellset_key_y(key);
+  const bool inner = sparse_inner(cell_x, cell_y);
+
+  for (i64 y = (i64)cell_y - 1; y <= (i64)cell_y + 1; y++) {
+    for (i64 x = (i64)cell_x - 1; x <= (i64)cell_x + 1; x++) {
+      if (inner || (cellset_within(x, y) &&
+                    sparse_shard((i32)x, (i32)y) == index)) {
+        sparse_flip_side(shard, (i32)x, (i32)y,
+                         1u << ((cell_y - y + 1) * 3 + cell_x - x + 1));
+      }
+    }
+  }
+}
+
+static void sparse_toggle(SparseShard *const shard, CellKey key) {
+  if (!cellset_erase(&shard->cells, key)) {
+    cellset_insert(&shard->cells, key, 0);
+  }
+}
+
+// Builds the next generation of shard into SparseShard.cells_next, then swaps
+// the sets. Survivors are copied in slot order, which walks both tables front
+// to back
+static void sparse_rebuild(SparseShard *const shard) {
+  CellKey *const flips = shard->flips;
+  const u64 flip_nb = arrlenu(flips);
+
+  // Deaths are flagged by their value, births moved to the front of flips
+  u64 birth_nb = 0;
+  for (u64 i = 0; i < flip_nb; i++) {
+    u32 *const alive = cellset_get(&shard->cells, flips[i]);
+    if (alive) {
+      *alive = 1;
+    } else {
+      const CellKey birth = flips[i];
+      flips[i] = flips[birth_nb];
+      flips[birth_nb++] = birth;
+    }
+  }
+
+  // The spare set keeps its slots from one rebuild to the next, unless it
+  // would be mostly empty
+  const u64 count = shard->cells.count - (flip_nb - birth_nb) + birth_nb;
+  CellSet *const next = &shard->cells_next;
+  if (next->capacity / 4 > count) {
+    cellset_free(next);
+  }
+  cellset_clear(next);
+  cellset_reserve(next, count);
+
+  for (u64 i = cellset_next(&shard->cells, 0); i < shard->cells.capacity;
+       i = cellset_next(&shard->cells, i + 1)) {
+    if (!shard->cells.values[i]) {
+      cellset_insert_new(next, shard->cells.keys[i], 0);
+    }
+  }
+  for (u64 i = 0; i < birth_nb; i++) {
+    cellset_insert_new(next, flips[i], 0);
+  }
+
+  const CellSet cells = shard->cells;
+  shard->cells = *next;
+  *next = cells;
+}
+
+// Posts a flip on the edge of its region to the other shards of the regions
+// it touches
+static void sparse_post(SparseShard *const shard, u32 index, CellKey key) {
+  const i32 x = cellset_key_x(key);
+  const i32 y = cellset_key_y(key);
+  // Regions past the 32-bit edge only get cells they ignore
+  const i32 region_x[2] = {(i32)(((i64)x - 1) >> SPARSE_REGION_SHIFT),
+                           (i32)(((i64)x + 1) >> SPARSE_REGION_SHIFT)};
+  const i32 region_y[2] = {(i32)(((i64)y - 1) >> SPARSE_REGION_SHIFT),
+                           (i32)(((i64)y + 1) >> SPARSE_REGION_SHIFT)};
+
+  u32 posted = 1u << index; // A bit per shard
+  for (u32 j = 0; j < 2; j++) {
+    for (u32 i = 0; i < 2; i++) {
+      const u32 to = sparse_region_shard(region_x[i], region_y[j]);
+      if (!(posted & 1u << to)) {
+        posted |= 1u << to;
+        arrput(shard->outbox[to], key);
+      }
+    }
+  }
+}
+
+// Evaluate phase, only reads & writes the shard task
+static void sparse_evaluate_shard(void *const ctx, u32 worker, u32 task) {
+  (void)worker;
+  SparseMap *const self = (SparseMap *)ctx;
+  SparseShard *const shard = &self->shards[task];
+  const Rule rule = rule_resolve(self->rule);
+
+  while (arrlenu(shard->candidates)) {
+    const CellKey key = arrpop(shard->candidates);
+    u32 *const neighbourhood = cellset_get(&shard->neighbourhoods, key);
+    *neighbourhood &= ~SPARSE_CANDIDATE;
+
+    // B0 rules are rejected, cells without alive neighbours stay dead
+    if (!*neighbourhood) {
+      cellset_erase(&shard->neighbourhoods, key);
+    } else if (rule_next_neighbourhood(rule, *neighbourhood) !=
+               (bool)(*neighbourhood & RULE_NEIGHBOURHOOD_CELL)) {
+      arrput(shard->flips, key);
+      if (!sparse_inner(cellset_key_x(key), cellset_key_y(key))) {
+        sparse_post(shard, task, key);
+      }
+    }
+  }
+}
+
+// Apply phase, writes the shard task & empties the outboxes to it: they are
+// only read by it
+static void sparse_apply_shard(void *const ctx, u32 worker, u32 task) {
+  (void)worker;
+  SparseMap *const self = (SparseMap *)ctx;
+  SparseShard *const shard = &self->shards[task];
+
+  const u64 flip_nb = arrlenu(shard->flips);
+  if (shard->cells.count <= flip_nb * SPARSE_REBUILD) {
+    sparse_rebuild(shard);
+  } else {
+    for (u64 i = 0; i < flip_nb; i++) {
+      sparse_toggle(shard, shard->flips[i]);
+    }
+  }
+
+  while (arrlenu(shard->flips)) {
+    const CellKey key = arrpop(shard->flips);
+    shard->hash ^= cellset_zobrist(key);
+    sparse_flip_neighbourhoods(shard, task, key);
+  }
+  for (u32 from = 0; from < SPARSE_SHARDS; from++) {
+    CellKey *const outbox = self->shards[from].outbox[task];
+    for (u64 i = 0; i < arrlenu(outbox); i++) {
+      sparse_flip_neighbourhoods(shard, task, outbox[i]);
+    }
+    if (outbox) {
+      arrdeln(outbox, 0, arrlenu(outbox));
+    }
+  }
+}
+
+void sparse_free(SparseMap *const self) {
+  for (u32 s = 0; s < SPARSE_SHARDS; s++) {
+    SparseShard *const shard = &self->shards[s];
+    cellset_free(&shard->cells);
+    cellset_free(&shard->cells_next);
+    cellset_free(&shard->neighbourhoods);
+    arrfree(shard->candidates);
+    arrfree(shard->flips);
+    for (u32 to = 0; to < SPARSE_SHARDS; to++) {
+      arrfree(shard->outbox[to]);
+    }
+  }
+  *self = (SparseMap){0};
+}
+
+void sparse_set_rule(SparseMap *const self, Rule rule) {
+  self->rule = rule;
+  for (u32 s = 0; s < SPARSE_SHARDS; s++) {
+    SparseShard *const shard = &self->shards[s];
+    for (u64 i = cellset_next(&shard->neighbourhoods, 0);
+         i < shard->neighbourhoods.capacity;
+         i = cellset_next(&shard->neighbourhoods, i + 1)) {
+      sparse_add_candidate(shard, shard->neighbourhoods.keys[i],
+                           &shard->neighbourhoods.values[i]);
+    }
+  }
+}
+
+bool sparse_get_cell(const SparseMap *const self, i32 x, i32 y) {
+  return cellset_contains(&self->shards[sparse_shard(x, y)].cells,
+                          cellset_key(x, y));
+}
+
+void sparse_set_cell(SparseMap *const self, i32 x, i32 y, bool alive) {
+  SparseShard *const shard = &self->shards[sparse_shard(x, y)];
+  const CellKey key = cellset_key(x, y);
+  if (alive == cellset_contains(&shard->cells, key)) {
+    return;
+  }
+
+  sparse_toggle(shard, key);
+  shard->hash ^= cellset_zobrist(key);
+  for (i64 ny = (i64)y - 1; ny <= (i64)y + 1; ny++) {
+    for (i64 nx = (i64)x - 1; nx <= (i64)x + 1; nx++) {
+      if (cellset_within(nx, ny)) {
+        sparse_flip_side(&self->shards[sparse_shard((i32)nx, (i32)ny)],
+                         (i32)nx, (i32)ny,
+                         1u << ((y - ny + 1) * 3 + x - nx + 1));
+      }
+    }
+  }
+}
+
+void sparse_step(SparseMap *const self, ThreadPool *const pool) {
+  const f64 time_start = timer_now();
+
+  u64 candidate_nb = 0;
+  for (u32 s = 0; s < SPARSE_SHARDS; s++) {
+    candidate_nb += arrlenu(self->shards[s].candidates);
+  }
+  // Waking the pool up costs more than a few candidates
+  ThreadPool *const step_pool =
+      candidate_nb >= SPARSE_PARALLEL_CANDIDATES ? pool : NULL;
+
+  // Every candidate sees the current generation: flips are applied once every
+  // shard found its own
+  pool_run(step_pool, SPARSE_SHARDS, &sparse_evaluate_shard, self);
+  pool_run(step_pool, SPARSE_SHARDS, &sparse_apply_shard, self);
+
+  self->compute_time = timer_now() - time_start;
+  self->cells_computed = candidate_nb;
+}
+
+u64 sparse_population(const SparseMap *const self) {
+  u64 population = 0;
+  for (u32 s = 0; s < SPARSE_SHARDS; s++) {
+    population += self->shards[s].cells.count;
+  }
+  return population;
+}
+
+u64 sparse_hash(const SparseMap *const self) {
+  u64 hash = 0;
+  for (u32 s = 0; s < SPARSE_SHARDS; s++) {
+    hash ^= self->shards[s].hash;
+  }
+  return hash;
+}
+
+void sparse_foreach_cell(const SparseMap *const self, CellRect rect,
+                         SparseCellFn fn, void *const ctx) {
+  for (u32 s = 0; s < SPARSE_SHARDS; s++) {
+    const CellSet *const cells = &self->shards[s].cells;
+    for (u64 i = cellset_next(cells, 0); i < cells->capacity;
+         i = cellset_next(cells, i + 1)) {
+      const i32 x = cellset_key_x(cells->keys[i]);
+      const i32 y = cellset_key_y(cells->keys[i]);
+      if (cellrect_contains(rect, x, y)) {
+        fn(ctx, x, y);
+      }
+    }
+  }
+}
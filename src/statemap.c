@@ -0,0 +1,449 @@
+#include "statemap.h"
+#include "kernel.h"
+#include "morton.h"
+#include "radix.h"
+#include "tilepool.h"
+#include "timer.h"
+#include <string.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+static StateTile *statemap_get(const StateMap *const self, i32 x, i32 y) {
+  const u32 *const index = cellset_get(&self->index, cellset_key(x, y));
+  return index ? self->tiles[*index] : NULL;
+}
+
+// Returns the index of tile (x, y), appending an empty one if needed
+static u32 statemap_ensure(StateMap *const self, i32 x, i32 y) {
+  const u32 tile_nb = (u32)arrlenu(self->tiles);
+  const u32 index = *cellset_insert(&self->index, cellset_key(x, y), tile_nb);
+
+  if (index == tile_nb) {
+    // Both generations are empty
+    StateTile *const tile =
+        tilepool_alloc(&self->tile_pool, sizeof(StateTile));
+    tile->x = x;
+    tile->y = y;
+    tile->settled = true;
+    arrput(self->tiles, tile);
+    self->zorder_stale = true;
+  }
+
+  return index;
+}
+
+// Quiescent cells don't change unless a neighbour is in state 1
+static inline bool statemap_quiescent(Rule rule, u8 state) {
+  return !state ||
+         (rule.family == rule_wireworld && state == RULE_WIREWORLD_CONDUCTOR);
+}
+
+// Population & transient cells of a row. Plain reductions the compiler
+// vectorizes
+static inline void statemap_row_count(Rule rule, const u8 *const row,
+                                      u32 *const population,
+                                      u32 *const transient) {
+  u8 empty = 0, conductors = 0;
+  for (u32 x = 0; x < TILE_SIZE; x++) {
+    empty = (u8)(empty + (row[x] == 0));
+  }
+  if (rule.family == rule_wireworld) {
+    for (u32 x = 0; x < TILE_SIZE; x++) {
+      conductors = (u8)(conductors + (row[x] == RULE_WIREWORLD_CONDUCTOR));
+    }
+  }
+  *population += TILE_SIZE - empty;
+  *transient += TILE_SIZE - empty - (u32)conductors;
+}
+
+// Borders of the cells in state 1, see TileBorders. Cells up to margin (the
+// range of the rule) cells from an edge face the neighbours on that side
+static TileBorders statemap_borders(const u8 cells[TILE_SIZE][TILE_SIZE],
+                                    u32 margin) {
+  u64 rows = 0, west = 0, east = 0;
+  for (u32 r = 0; r < TILE_SIZE; r++) {
+    u8 any = 0, west_any = 0, east_any = 0;
+    for (u32 x = 0; x < TILE_SIZE; x++) {
+      any |= cells[r][x] == 1;
+    }
+    for (u32 x = 0; any && x < margin; x++) {
+      west_any |= cells[r][x] == 1;
+      east_any |= cells[r][TILE_MASK - x] == 1;
+    }
+    rows |= (u64)any << r;
+    west |= (u64)west_any << r;
+    east |= (u64)east_any << r;
+  }
+
+  // Rows up to margin from the top & bottom edges
+  const u64 near = margin < TILE_SIZE ? (1ull << margin) - 1 : ~0ull;
+  const u64 far = near << (TILE_SIZE - margin);
+  return (TileBorders)((u64)!!(west & near) | (u64)!!(rows & near) << 1 |
+                       (u64)!!(east & near) << 2 | (u64)!!west << 3 |
+                       (u64)!!rows << 4 | (u64)!!east << 5 |
+                       (u64)!!(west & far) << 6 | (u64)!!(rows & far) << 7 |
+                       (u64)!!(east & far) << 8);
+}
+
+// Borders cell (x, y) of a tile is part of, see statemap_borders
+static TileBorders statemap_cell_borders(u32 x, u32 y, u32 margin) {
+  const u32 columns =
+      2 | (x < margin) | (u32)(x >= TILE_SIZE - margin) << 2;
+  const u32 rows = 2 | (y < margin) | (u32)(y >= TILE_SIZE - margin) << 2;
+  TileBorders borders = 0;
+  for (u32 j = 0; j < 3; j++) {
+    borders |= rows >> j & 1 ? (TileBorders)(columns << (j * 3)) : 0;
+  }
+  return borders;
+}
+
+// Zobrist hashing by rows like the TileMap: the 8 words of a row are folded
+// with odd multipliers, then mixed once. Only changed rows are rehashed, empty
+// rows hash to 0
+static inline u64 statemap_row_hash(u64 tile_key, u32 r, const u8 *const row) {
+  u64 words[TILE_SIZE / 8];
+  memcpy(words, row, TILE_SIZE);
+
+  u64 fold = 0;
+  for (u32 i = 0; i < TILE_SIZE / 8; i++) {
+    fold += words[i] * (0x9E3779B97F4A7C15ull * (2 * i + 1));
+  }
+  return fold ? cellset_zobrist(fold ^ (tile_key + r * 0x9E3779B97F4A7C15ull))
+              : 0;
+}
+
+void statemap_free(StateMap *const self) {
+  cellset_free(&self->index);
+  arrfree(self->tiles);
+  tilepool_free(&self->tile_pool);
+  arrfree(self->zorder);
+  *self = (StateMap){0};
+}
+
+void statemap_set_rule(StateMap *const self, Rule rule) {
+  // Quiescent states depend on the rule, transient counts have to be redone.
+  // Borders depend on the range, they are needed before the next step
+  const bool range_changed = rule_range(rule) != rule_range(self->rule);
+  self->rule = rule;
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    StateTile *const tile = self->tiles[i];
+    tile->edited = true;
+    if (range_changed) {
+      tile->heads[self->phase] =
+          statemap_borders(tile->cells[self->phase], rule_range(rule));
+    }
+  }
+}
+
+u8 statemap_get_state(const StateMap *const self, i32 x, i32 y) {
+  const StateTile *const tile =
+      statemap_get(self, x >> TILE_SHIFT, y >> TILE_SHIFT);
+
+  return tile ? tile->cells[self->phase][y & TILE_MASK][x & TILE_MASK] : 0;
+}
+
+void statemap_set_state(StateMap *const self, i32 x, i32 y, u8 state) {
+  StateTile *tile = statemap_get(self, x >> TILE_SHIFT, y >> TILE_SHIFT);
+
+  if (!tile) {
+    if (!state) {
+      return;
+    }
+    const u32 index = statemap_ensure(self, x >> TILE_SHIFT, y >> TILE_SHIFT);
+    tile = self->tiles[index];
+  }
+
+  const u32 cur = self->phase;
+  u8 *const cell = &tile->cells[cur][y & TILE_MASK][x & TILE_MASK];
+  if (*cell == state) {
+    return;
+  }
+
+  const u8 *const row = tile->cells[cur][y & TILE_MASK];
+  const u64 tile_key = cellset_zobrist(cellset_key(tile->x, tile->y));
+  u64 row_hash = statemap_row_hash(tile_key, y & TILE_MASK, row);
+  const Rule rule = rule_resolve(self->rule);
+  tile->population[cur] -= *cell != 0;
+  tile->transient[cur] -= !statemap_quiescent(rule, *cell);
+  self->population -= *cell != 0;
+
+  *cell = state;
+  row_hash ^= statemap_row_hash(tile_key, y & TILE_MASK, row);
+  tile->population[cur] += state != 0;
+  tile->transient[cur] += !statemap_quiescent(rule, state);
+  self->population += state != 0;
+  tile->hash[cur] ^= row_hash;
+  self->hash ^= row_hash;
+
+  // cells[phase ^ 1] isn't a copy anymore, the tile has to be computed. Heads
+  // removed from a border are only cleared then, a tile is computed for nothing
+  // at worst
+  if (state == 1) {
+    tile->heads[cur] |= statemap_cell_borders(x & TILE_MASK, y & TILE_MASK,
+                                              rule_range(self->rule));
+  }
+  tile->edited = true;
+  tile->settled = false;
+}
+
+// Flags of the state 1 cells of row r of 3 adjacent tiles, TILE_SIZE + 2 *
+// margin bytes centred on mid
+static void statemap_halo_row(const StateTile *const left,
+                              const StateTile *const mid,
+                              const StateTile *const right, u32 cur, u32 r,
+                              u32 margin, u8 *const out) {
+  for (u32 x = 0; x < margin; x++) {
+    out[x] = left && left->cells[cur][r][TILE_SIZE - margin + x] == 1;
+    out[margin + TILE_SIZE + x] = right && right->cells[cur][r][x] == 1;
+  }
+  if (mid) {
+    for (u32 x = 0; x < TILE_SIZE; x++) {
+      out[margin + x] = mid->cells[cur][r][x] == 1;
+    }
+  } else {
+    memset(&out[margin], 0, TILE_SIZE);
+  }
+}
+
+// Pool task: next generation of active tile self->active[i]
+static void statemap_step_tile(void *const ctx, u32 worker, u32 i) {
+  (void)worker;
+  StateMap *const self = (StateMap *)ctx;
+  const u32 cur = self->phase;
+  const u32 nxt = cur ^ 1;
+  const Rule rule = rule_resolve(self->rule);
+  const u32 margin = rule_range(rule);
+  const u32 width = TILE_SIZE + 2 * margin;
+  u8 heads[(TILE_SIZE + 2 * RULE_MAX_RANGE) * (TILE_SIZE + 2 * RULE_MAX_RANGE)];
+
+  StateTile *const tile = self->tiles[self->active[i]];
+  const i32 x = tile->x;
+  const i32 y = tile->y;
+
+  const StateTile *const n = statemap_get(self, x, y - 1);
+  const StateTile *const s = statemap_get(self, x, y + 1);
+  const StateTile *const w = statemap_get(self, x - 1, y);
+  const StateTile *const e = statemap_get(self, x + 1, y);
+  const StateTile *const nw = statemap_get(self, x - 1, y - 1);
+  const StateTile *const ne = statemap_get(self, x + 1, y - 1);
+  const StateTile *const sw = statemap_get(self, x - 1, y + 1);
+  const StateTile *const se = statemap_get(self, x + 1, y + 1);
+
+  for (u32 r = 0; r < margin; r++) {
+    statemap_halo_row(nw, n, ne, cur, TILE_SIZE - margin + r, margin,
+                      &heads[r * width]);
+    statemap_halo_row(sw, s, se, cur, r, margin,
+                      &heads[(margin + TILE_SIZE + r) * width]);
+  }
+  for (u32 r = 0; r < TILE_SIZE; r++) {
+    statemap_halo_row(w, tile, e, cur, r, margin,
+                      &heads[(margin + r) * width]);
+  }
+
+  kernel_state_tile(rule, heads, &tile->cells[cur][0][0],
+                    &tile->cells[nxt][0][0]);
+
+  // Rows with changes update the hash
+  const u64 tile_key = cellset_zobrist(cellset_key(x, y));
+  u64 hash = tile->hash[cur];
+  u32 population = 0, transient = 0;
+  for (u32 r = 0; r < TILE_SIZE; r++) {
+    const u8 *const row = tile->cells[nxt][r];
+    if (memcmp(row, tile->cells[cur][r], TILE_SIZE)) {
+      hash ^= statemap_row_hash(tile_key, r, tile->cells[cur][r]) ^
+              statemap_row_hash(tile_key, r, row);
+    }
+    statemap_row_count(rule, row, &population, &transient);
+  }
+
+  tile->edited = false;
+  tile->settled = false;
+  tile->population[nxt] = population;
+  tile->transient[nxt] = transient;
+  tile->hash[nxt] = hash;
+  tile->heads[nxt] = statemap_borders(tile->cells[nxt], margin);
+}
+
+// State 1 cells of the neighbours facing tile (x, y)
+static bool statemap_is_faced(const StateMap *const self, i32 x, i32 y) {
+  for (i32 j = 0; j < 9; j++) {
+    const StateTile *const neighbour =
+        statemap_get(self, x + j % 3 - 1, y + j / 3 - 1);
+    if (j != 4 && neighbour && (neighbour->heads[self->phase] >> (8 - j) & 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void statemap_step(StateMap *const self, ThreadPool *const pool,
+                   Arena *const arena) {
+  const u32 cur = self->phase;
+  const u32 nxt = cur ^ 1;
+
+  // Allocate the empty tiles next to state 1 cells, where births may happen.
+  // Wireworld heads only act on conductors, which live in existing tiles
+  //
+  const u32 tile_nb = (u32)arrlenu(self->tiles);
+  for (u32 i = 0; self->rule.family != rule_wireworld && i < tile_nb; i++) {
+    const i32 x = self->tiles[i]->x;
+    const i32 y = self->tiles[i]->y;
+    const TileBorders heads = self->tiles[i]->heads[cur];
+
+    for (i32 j = 0; heads && j < 9; j++) {
+      if (j != 4 && heads >> j & 1 &&
+          tile_within(x + j % 3 - 1, y + j / 3 - 1)) {
+        statemap_ensure(self, x + j % 3 - 1, y + j / 3 - 1);
+      }
+    }
+  }
+
+  // Tiles with transient cells & the neighbours their state 1 cells face are
+  // active
+  //
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    StateTile *const tile = self->tiles[i];
+    tile->active |= tile->transient[cur] || tile->edited;
+
+    const TileBorders heads = tile->heads[cur];
+    for (i32 j = 0; heads && j < 9; j++) {
+      StateTile *const neighbour =
+          j != 4 && heads >> j & 1
+              ? statemap_get(self, tile->x + j % 3 - 1, tile->y + j / 3 - 1)
+              : NULL;
+      if (neighbour) {
+        neighbour->active = true;
+      }
+    }
+  }
+
+  // Inactive tiles' next generation is the current one, copied once
+  self->active = arena_alloc(arena, arrlenu(self->tiles) * sizeof(u32));
+  u32 active_nb = 0;
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    StateTile *const tile = self->tiles[i];
+    if (tile->active) {
+      tile->active = false;
+      self->active[active_nb++] = i;
+      continue;
+    }
+
+    if (!tile->settled) {
+      memcpy(tile->cells[nxt], tile->cells[cur], sizeof(tile->cells[cur]));
+      tile->settled = true;
+    }
+    tile->population[nxt] = tile->population[cur];
+    tile->transient[nxt] = tile->transient[cur];
+    tile->heads[nxt] = tile->heads[cur];
+    tile->hash[nxt] = tile->hash[cur];
+  }
+
+  // Compute the next generation of active tiles, tiles only write their own
+  // next generation so they can be computed in any order
+  //
+  const f64 time_start = timer_now();
+
+  pool_run(pool, active_nb, &statemap_step_tile, self);
+
+  self->compute_time = timer_now() - time_start;
+  self->active_nb = active_nb;
+  self->cells_computed = self->active_nb * TILE_SIZE * TILE_SIZE;
+  self->phase = nxt;
+
+  self->population = 0;
+  self->hash = 0;
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    self->population += self->tiles[i]->population[nxt];
+    self->hash ^= self->tiles[i]->hash[nxt];
+  }
+
+  // Drop computed tiles that became empty & that no state 1 cell faces. Only
+  // computed tiles can have become useless
+  //
+  for (u32 i = active_nb; i-- > 0;) {
+    const u32 index = self->active[i];
+    StateTile *const tile = self->tiles[index];
+    if (tile->population[nxt] || statemap_is_faced(self, tile->x, tile->y)) {
+      continue;
+    }
+
+    // Indices are increasing: the last tile moved to index isn't a candidate
+    // that is still to come
+    cellset_erase(&self->index, cellset_key(tile->x, tile->y));
+    tilepool_release(&self->tile_pool, tile);
+    arrdelswap(self->tiles, index);
+    if (index < arrlenu(self->tiles)) {
+      *cellset_get(&self->index, cellset_key(self->tiles[index]->x,
+                                             self->tiles[index]->y)) = index;
+    }
+    self->zorder_stale = true;
+  }
+
+  if (self->zorder_stale) {
+    const u64 tile_nb = arrlenu(self->tiles);
+    arrsetlen(self->zorder, tile_nb);
+    for (u64 i = 0; i < tile_nb; i++) {
+      self->zorder[i] = morton_encode(self->tiles[i]->x, self->tiles[i]->y);
+    }
+    radix_sort(self->zorder, arena_alloc(arena, tile_nb * sizeof(u64)),
+               tile_nb);
+    self->zorder_stale = false;
+  }
+}
+
+typedef struct StateForeachCtx {
+  const StateMap *self;
+  CellRect rect;
+  StateCellFn fn;
+  void *ctx;
+} StateForeachCtx;
+
+// Calls foreach->fn for the non-empty cells of tile (x, y) within
+// foreach->rect
+static void statemap_foreach_tile(void *const ctx, i32 x, i32 y) {
+  const StateForeachCtx *const foreach = (const StateForeachCtx *)ctx;
+  const StateTile *const tile = statemap_get(foreach->self, x, y);
+  const u32 cur = foreach->self->phase;
+  if (!tile->population[cur]) {
+    return;
+  }
+  x *= TILE_SIZE;
+  y *= TILE_SIZE;
+
+  for (u32 r = 0; r < TILE_SIZE; r++) {
+    const u8 *const row = tile->cells[cur][r];
+    for (u32 c = 0; c < TILE_SIZE; c++) {
+      if (row[c] &&
+          cellrect_contains(foreach->rect, x + (i32)c, y + (i32)r)) {
+        foreach->fn(foreach->ctx, x + (i32)c, y + (i32)r, row[c]);
+      }
+    }
+  }
+}
+
+void statemap_foreach_cell(const StateMap *const self, CellRect rect,
+                           StateCellFn fn, void *ctx) {
+  StateForeachCtx foreach = {.self = self, .rect = rect, .fn = fn, .ctx = ctx};
+  const CellRect tiles = {.min_x = rect.min_x >> TILE_SHIFT,
+                          .min_y = rect.min_y >> TILE_SHIFT,
+                          .max_x = rect.max_x >> TILE_SHIFT,
+                          .max_y = rect.max_y >> TILE_SHIFT};
+
+  if (!self->zorder_stale) {
+    morton_foreach(self->zorder, arrlenu(self->zorder), tiles,
+                   &statemap_foreach_tile, &foreach);
+    return;
+  }
+
+  // Tiles were added since the last step, go through all of them
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    const StateTile *const tile = self->tiles[i];
+    if (cellrect_contains(tiles, tile->x, tile->y)) {
+      statemap_foreach_tile(&foreach, tile->x, tile->y);
+    }
+  }
+}
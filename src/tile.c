@@ -0,0 +1,387 @@
+#include "tile.h"
+#include "kernel.h"
+#include "morton.h"
+#include "radix.h"
+#include "tilepool.h"
+#include "timer.h"
+#include <assert.h>
+#include <string.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+static Tile *tilemap_get(const TileMap *const self, i32 x, i32 y) {
+  const u32 *const index = cellset_get(&self->index, cellset_key(x, y));
+  return index ? self->tiles[*index] : NULL;
+}
+
+// Returns the index of tile (x, y), appending an empty one if needed
+static u32 tilemap_ensure(TileMap *const self, i32 x, i32 y) {
+  const u32 tile_nb = (u32)arrlenu(self->tiles);
+  const u32 index = *cellset_insert(&self->index, cellset_key(x, y), tile_nb);
+
+  if (index == tile_nb) {
+    Tile *const tile = tilepool_alloc(&self->tile_pool, sizeof(Tile));
+    tile->x = x;
+    tile->y = y;
+    tile->bits = tilepool_alloc(&self->bits_pool, 2 * sizeof(tile->bits[0]));
+    arrput(self->tiles, tile);
+    self->zorder_stale = true;
+  }
+
+  return index;
+}
+
+static TileBorders tilemap_borders(const u64 *const rows) {
+  const u64 top = rows[0];
+  const u64 bottom = rows[TILE_MASK];
+
+  u64 west = 0, east = 0, any = 0;
+  for (u32 r = 0; r < TILE_SIZE; r++) {
+    west |= rows[r] & 1;
+    east |= rows[r] >> TILE_MASK;
+    any |= rows[r];
+  }
+
+  return (TileBorders)((top & 1) | (u64)(top != 0) << 1 |
+                       (top >> TILE_MASK) << 2 | west << 3 |
+                       (u64)(any != 0) << 4 | east << 5 |
+                       (bottom & 1) << 6 | (u64)(bottom != 0) << 7 |
+                       (bottom >> TILE_MASK) << 8);
+}
+
+// Zobrist hashing by rows rather than cells: a row of a tile is hashed with
+// its bits, empty rows hash to 0. Births & deaths only rehash the rows they
+// change, one mix per row instead of one per cell
+static inline u64 tilemap_tile_key(i32 x, i32 y) {
+  return cellset_zobrist(cellset_key(x, y));
+}
+
+static inline u64 tilemap_row_hash(u64 tile_key, u32 r, u64 row) {
+  return row ? cellset_zobrist(row ^ (tile_key + r * 0x9E3779B97F4A7C15ull))
+             : 0;
+}
+
+void tilemap_free(TileMap *const self) {
+  cellset_free(&self->index);
+  arrfree(self->tiles);
+  tilepool_free(&self->tile_pool);
+  tilepool_free(&self->bits_pool);
+  arrfree(self->zorder);
+  *self = (TileMap){0};
+}
+
+void tilemap_map(TileMap *const self, const char *const dir, u64 budget,
+                 Error *const err) {
+  assert(!arrlenu(self->tiles) && "Only empty maps are mapped");
+  tilepool_map(&self->bits_pool, dir, budget, err);
+}
+
+bool tilemap_get_cell(const TileMap *const self, i32 x, i32 y) {
+  const Tile *const tile =
+      tilemap_get(self, x >> TILE_SHIFT, y >> TILE_SHIFT);
+
+  return tile &&
+         (tile->bits[self->phase][y & TILE_MASK] >> (x & TILE_MASK)) & 1;
+}
+
+void tilemap_set_cell(TileMap *const self, i32 x, i32 y, bool alive) {
+  Tile *tile = tilemap_get(self, x >> TILE_SHIFT, y >> TILE_SHIFT);
+
+  if (!tile) {
+    if (!alive) {
+      return;
+    }
+    const u32 index = tilemap_ensure(self, x >> TILE_SHIFT, y >> TILE_SHIFT);
+    tile = self->tiles[index];
+  }
+
+  const u32 cur = self->phase;
+  tilepool_touch(&self->bits_pool, tile->bits);
+  u64 *const row = &tile->bits[cur][y & TILE_MASK];
+  const u64 bit = 1ull << (x & TILE_MASK);
+
+  if (alive == !(*row & bit)) {
+    const u64 tile_key = tilemap_tile_key(tile->x, tile->y);
+    const u64 row_hash = tilemap_row_hash(tile_key, y & TILE_MASK, *row) ^
+                         tilemap_row_hash(tile_key, y & TILE_MASK, *row ^ bit);
+    *row ^= bit;
+    tile->population[cur] += alive ? 1 : (u32)-1;
+    self->population += alive ? 1 : (u64)-1;
+    tile->hash[cur] ^= row_hash;
+    self->hash ^= row_hash;
+
+    // The tile & its neighbours have to be computed next step, the tile the
+    // step after too
+    tile->changed[cur] = TILE_BORDERS_ALL;
+    tile->edited = true;
+    tile->borders[cur] = tilemap_borders(tile->bits[cur]);
+  }
+}
+
+// Pool task: next generation of active tile self->active[i]
+static void tilemap_step_tile(void *const ctx, u32 worker, u32 i) {
+  (void)worker;
+  TileMap *const self = (TileMap *)ctx;
+  const u32 cur = self->phase;
+  const u32 nxt = cur ^ 1;
+  u64 mid[TILE_HALO_SIZE], left[TILE_HALO_SIZE], right[TILE_HALO_SIZE];
+  u64 next[TILE_SIZE];
+
+  Tile *const tile = self->tiles[self->active[i]];
+  const i32 x = tile->x;
+  const i32 y = tile->y;
+
+  const Tile *const n = tilemap_get(self, x, y - 1);
+  const Tile *const s = tilemap_get(self, x, y + 1);
+  const Tile *const w = tilemap_get(self, x - 1, y);
+  const Tile *const e = tilemap_get(self, x + 1, y);
+  const Tile *const nw = tilemap_get(self, x - 1, y - 1);
+  const Tile *const ne = tilemap_get(self, x + 1, y - 1);
+  const Tile *const sw = tilemap_get(self, x - 1, y + 1);
+  const Tile *const se = tilemap_get(self, x + 1, y + 1);
+
+  mid[0] = n ? n->bits[cur][TILE_MASK] : 0;
+  left[0] = nw ? nw->bits[cur][TILE_MASK] : 0;
+  right[0] = ne ? ne->bits[cur][TILE_MASK] : 0;
+
+  memcpy(&mid[1], tile->bits[cur], sizeof(tile->bits[cur]));
+  if (w) {
+    memcpy(&left[1], w->bits[cur], sizeof(w->bits[cur]));
+  } else {
+    memset(&left[1], 0, sizeof(tile->bits[cur]));
+  }
+  if (e) {
+    memcpy(&right[1], e->bits[cur], sizeof(e->bits[cur]));
+  } else {
+    memset(&right[1], 0, sizeof(tile->bits[cur]));
+  }
+
+  mid[TILE_HALO_SIZE - 1] = s ? s->bits[cur][0] : 0;
+  left[TILE_HALO_SIZE - 1] = sw ? sw->bits[cur][0] : 0;
+  right[TILE_HALO_SIZE - 1] = se ? se->bits[cur][0] : 0;
+
+  kernel_tile(self->rule, mid, left, right, next);
+
+  // bits[nxt] still holds the generation before the current one. Rows with
+  // births or deaths update the hash
+  const u64 tile_key = tilemap_tile_key(x, y);
+  u64 hash = tile->hash[cur];
+  u32 population = 0;
+  for (u32 r = 0; r < TILE_SIZE; r++) {
+    const u64 alive = next[r];
+    if (alive != tile->bits[cur][r]) {
+      hash ^= tilemap_row_hash(tile_key, r, tile->bits[cur][r]) ^
+              tilemap_row_hash(tile_key, r, alive);
+    }
+    next[r] ^= tile->bits[nxt][r];
+    tile->bits[nxt][r] = alive;
+    population += (u32)__builtin_popcountll(alive);
+  }
+
+  tile->changed[nxt] =
+      tilemap_borders(next) | (tile->edited ? TILE_BORDERS_CENTRE : 0);
+  tile->edited = false;
+  tile->population[nxt] = population;
+  tile->hash[nxt] = hash;
+  tile->borders[nxt] = tilemap_borders(tile->bits[nxt]);
+}
+
+// Borders of the neighbours facing tile (x, y), in either generation
+static bool tilemap_is_faced(const TileMap *const self, i32 x, i32 y) {
+  for (i32 j = 0; j < 9; j++) {
+    const Tile *const neighbour =
+        tilemap_get(self, x + j % 3 - 1, y + j / 3 - 1);
+    if (j != 4 && neighbour &&
+        ((neighbour->borders[0] | neighbour->borders[1]) >> (8 - j) & 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The rows of tile (x, y) & its neighbours are read to compute it
+static void tilemap_touch_around(TileMap *const self, i32 x, i32 y) {
+  for (i32 j = 0; j < 9; j++) {
+    const Tile *const tile = tilemap_get(self, x + j % 3 - 1, y + j / 3 - 1);
+    if (tile) {
+      tilepool_touch(&self->bits_pool, tile->bits);
+    }
+  }
+}
+
+// Every tile keeps the tiles its borders face in either generation, so tiles
+// where births may happen always exist
+void tilemap_step(TileMap *const self, ThreadPool *const pool,
+                  Arena *const arena) {
+  const u32 cur = self->phase;
+  const u32 nxt = cur ^ 1;
+
+  // Allocate the empty tiles next to live borders, where births may happen.
+  // Borders of unchanged tiles are the ones they had 2 generations ago, their
+  // neighbours already exist
+  //
+  const u32 tile_nb = (u32)arrlenu(self->tiles);
+  for (u32 i = 0; i < tile_nb; i++) {
+    if (!self->tiles[i]->changed[cur]) {
+      continue;
+    }
+    const i32 x = self->tiles[i]->x;
+    const i32 y = self->tiles[i]->y;
+    const TileBorders borders = self->tiles[i]->borders[cur];
+
+    for (i32 j = 0; j < 9; j++) {
+      if (j != 4 && borders >> j & 1 &&
+          tile_within(x + j % 3 - 1, y + j / 3 - 1)) {
+        tilemap_ensure(self, x + j % 3 - 1, y + j / 3 - 1);
+      }
+    }
+  }
+
+  // Changed tiles & the neighbours their changed borders face are active
+  //
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    const Tile *const tile = self->tiles[i];
+    const TileBorders changed = tile->changed[cur];
+    for (i32 j = 0; changed && j < 9; j++) {
+      Tile *const neighbour =
+          changed >> j & 1
+              ? tilemap_get(self, tile->x + j % 3 - 1, tile->y + j / 3 - 1)
+              : NULL;
+      if (neighbour) {
+        neighbour->active = true;
+      }
+    }
+  }
+
+  // Inactive tiles already hold their next generation
+  self->active = arena_alloc(arena, arrlenu(self->tiles) * sizeof(u32));
+  u32 active_nb = 0;
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    Tile *const tile = self->tiles[i];
+    if (tile->active) {
+      tile->active = false;
+      self->active[active_nb++] = i;
+      if (self->bits_pool.base) {
+        tilemap_touch_around(self, tile->x, tile->y);
+      }
+    } else {
+      tile->changed[nxt] = 0;
+    }
+  }
+
+  // Compute the next generation of active tiles, tiles only write their own
+  // next generation so they can be computed in any order
+  //
+  const f64 time_start = timer_now();
+
+  pool_run(pool, active_nb, &tilemap_step_tile, self);
+
+  self->compute_time = timer_now() - time_start;
+  self->active_nb = active_nb;
+  self->cells_computed = self->active_nb * TILE_SIZE * TILE_SIZE;
+  self->phase = nxt;
+
+  // Count the population, skipped tiles hash the generation they hold
+  //
+  self->population = 0;
+  self->hash = 0;
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    self->population += self->tiles[i]->population[nxt];
+    self->hash ^= self->tiles[i]->hash[nxt];
+  }
+
+  // Drop computed tiles that are empty in both generations, stable & that no
+  // neighbour needs. Only computed tiles can have become useless
+  //
+  for (u32 i = active_nb; i-- > 0;) {
+    const u32 index = self->active[i];
+    Tile *const tile = self->tiles[index];
+    if (tile->population[0] || tile->population[1] || tile->changed[nxt] ||
+        tilemap_is_faced(self, tile->x, tile->y)) {
+      continue;
+    }
+
+    // Indices are increasing: the last tile moved to index isn't a candidate
+    // that is still to come
+    cellset_erase(&self->index, cellset_key(tile->x, tile->y));
+    tilepool_release(&self->bits_pool, tile->bits);
+    tilepool_release(&self->tile_pool, tile);
+    arrdelswap(self->tiles, index);
+    if (index < arrlenu(self->tiles)) {
+      *cellset_get(&self->index, cellset_key(self->tiles[index]->x,
+                                             self->tiles[index]->y)) = index;
+    }
+    self->zorder_stale = true;
+  }
+
+  if (self->zorder_stale) {
+    const u64 tile_nb = arrlenu(self->tiles);
+    arrsetlen(self->zorder, tile_nb);
+    for (u64 i = 0; i < tile_nb; i++) {
+      self->zorder[i] = morton_encode(self->tiles[i]->x, self->tiles[i]->y);
+    }
+    radix_sort(self->zorder, arena_alloc(arena, tile_nb * sizeof(u64)),
+               tile_nb);
+    self->zorder_stale = false;
+  }
+
+  tilepool_evict(&self->bits_pool, arena);
+}
+
+typedef struct TileForeachCtx {
+  const TileMap *self;
+  CellRect rect;
+  TileCellFn fn;
+  void *ctx;
+} TileForeachCtx;
+
+// Calls foreach->fn for the cells of tile (x, y) within foreach->rect
+static void tilemap_foreach_tile(void *const ctx, i32 x, i32 y) {
+  const TileForeachCtx *const foreach = (const TileForeachCtx *)ctx;
+  const CellRect rect = foreach->rect;
+  const Tile *const tile = tilemap_get(foreach->self, x, y);
+  x *= TILE_SIZE;
+  y *= TILE_SIZE;
+
+  // Only filter cells of the tiles on the border of rect
+  const bool inside = x >= rect.min_x && y >= rect.min_y &&
+                      x + TILE_MASK <= rect.max_x &&
+                      y + TILE_MASK <= rect.max_y;
+
+  for (u32 r = 0; r < TILE_SIZE; r++) {
+    for (u64 bits = tile->bits[foreach->self->phase][r]; bits;
+         bits &= bits - 1) {
+      const i32 cell_x = x + __builtin_ctzll(bits);
+      if (inside || cellrect_contains(rect, cell_x, y + (i32)r)) {
+        foreach->fn(foreach->ctx, cell_x, y + (i32)r);
+      }
+    }
+  }
+}
+
+void tilemap_foreach_cell(const TileMap *const self, CellRect rect,
+                          TileCellFn fn, void *ctx) {
+  TileForeachCtx foreach = {.self = self, .rect = rect, .fn = fn, .ctx = ctx};
+  const CellRect tiles = {.min_x = rect.min_x >> TILE_SHIFT,
+                          .min_y = rect.min_y >> TILE_SHIFT,
+                          .max_x = rect.max_x >> TILE_SHIFT,
+                          .max_y = rect.max_y >> TILE_SHIFT};
+
+  if (!self->zorder_stale) {
+    morton_foreach(self->zorder, arrlenu(self->zorder), tiles,
+                   &tilemap_foreach_tile, &foreach);
+    return;
+  }
+
+  // Tiles were added since the last step, go through all of them
+  for (u32 i = 0; i < arrlenu(self->tiles); i++) {
+    const Tile *const tile = self->tiles[i];
+    if (cellrect_contains(tiles, tile->x, tile->y)) {
+      tilemap_foreach_tile(&foreach, tile->x, tile->y);
+    }
+  }
+}
@@ -0,0 +1,192 @@
+#define _DEFAULT_SOURCE // mmap flags, madvise, mkstemp & ftruncate
+
+#include "tilepool.h"
+#include "pool.h"
+#include "radix.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef TILEPOOL_HUGE_PAGES
+#define TILEPOOL_SLAB_ALIGN TILEPOOL_SLAB_SIZE
+#else
+#define TILEPOOL_SLAB_ALIGN POOL_CACHE_LINE
+#endif
+
+#define TILEPOOL_STORE_RESERVE                                                 \
+  ((u64)TILEPOOL_STORE_SLAB_SIZE << TILEPOOL_STORE_SLAB_BITS)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+void tilepool_free(TilePool *const self) {
+  if (self->base) {
+    // Slabs are mapped over the reserved addresses
+    munmap(self->base, TILEPOOL_STORE_RESERVE);
+    close(self->fd);
+  } else {
+    for (u64 i = 0; i < arrlenu(self->slabs); i++) {
+      free(self->slabs[i]);
+    }
+  }
+  arrfree(self->slabs);
+  arrfree(self->used);
+  arrfree(self->resident);
+  *self = (TilePool){0};
+}
+
+void tilepool_map(TilePool *const self, const char *const dir, u64 budget,
+                  Error *const err) {
+  assert(!self->base && !arrlenu(self->slabs) && "Only empty pools are mapped");
+
+  char path[4096];
+  const i32 len = snprintf(path, sizeof(path), "%s/gol-tiles-XXXXXX", dir);
+  const i32 fd = len > 0 && (u64)len < sizeof(path) ? mkstemp(path) : -1;
+  if (fd < 0) {
+    err->msg = "Could not create the tile store (" error_print_err_location
+               ").";
+    err->status = true;
+    err->code = error_generic;
+    return;
+  }
+  unlink(path);
+
+  // Addresses only, the slabs are mapped over them as the pool grows
+  void *const base = mmap(NULL, TILEPOOL_STORE_RESERVE, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    err->msg = "Could not reserve the tile store addresses ("
+               error_print_err_location ").";
+    err->status = true;
+    err->code = error_generic;
+    return;
+  }
+
+  self->base = base;
+  self->fd = fd;
+  self->budget = budget;
+}
+
+// Maps the next slab of the store file, whose new bytes read as zeros
+static u8 *tilepool_grow_mapped(TilePool *const self) {
+  const u64 slab_nb = arrlenu(self->slabs);
+  assert(slab_nb < 1u << TILEPOOL_STORE_SLAB_BITS &&
+         "Tile store full, this is the end...");
+
+  const u64 offset = slab_nb * TILEPOOL_STORE_SLAB_SIZE;
+  void *slab = MAP_FAILED;
+  if (!ftruncate(self->fd, (off_t)(offset + TILEPOOL_STORE_SLAB_SIZE))) {
+    slab = mmap(self->base + offset, TILEPOOL_STORE_SLAB_SIZE,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, self->fd,
+                (off_t)offset);
+  }
+  assert(slab != MAP_FAILED && "Not enough disk space, this is the end...");
+
+  arrput(self->used, self->clock);
+  arrput(self->resident, true);
+  self->resident_nb += 1;
+  return slab;
+}
+
+static u8 *tilepool_grow_heap(TilePool *const self) {
+  const u64 slab_size = self->per_slab * self->size;
+  u8 *const slab = aligned_alloc(TILEPOOL_SLAB_ALIGN,
+                                 (slab_size + TILEPOOL_SLAB_ALIGN - 1) &
+                                     ~(u64)(TILEPOOL_SLAB_ALIGN - 1));
+  assert(slab && "Not enough memory, this is the end...");
+#if defined(TILEPOOL_HUGE_PAGES) && defined(MADV_HUGEPAGE)
+  madvise(slab, TILEPOOL_SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+  return slab;
+}
+
+// Threads the tiles of a new slab on the free list
+static void tilepool_grow(TilePool *const self) {
+  u8 *const slab =
+      self->base ? tilepool_grow_mapped(self) : tilepool_grow_heap(self);
+  arrput(self->slabs, slab);
+
+  // First tile of the slab first
+  for (u64 i = self->per_slab; i-- > 0;) {
+    void *const tile = slab + i * self->size;
+    *(void **)tile = self->free;
+    self->free = tile;
+  }
+  self->capacity += self->per_slab;
+}
+
+void *tilepool_alloc(TilePool *const self, u64 size) {
+  assert(size && size % POOL_CACHE_LINE == 0 &&
+         "Tiles have to fill whole cache lines");
+  assert((!self->size || size == self->size) && "Tiles have one size");
+
+  if (!self->size) {
+    const u64 slab_size =
+        self->base ? TILEPOOL_STORE_SLAB_SIZE : TILEPOOL_SLAB_SIZE;
+    assert((!self->base || size <= slab_size) &&
+           "Mapped tiles have to fit in a slab");
+    self->size = size;
+    self->per_slab = size < slab_size ? slab_size / size : 1;
+  }
+  if (!self->free) {
+    tilepool_grow(self);
+  }
+
+  void *const tile = self->free;
+  tilepool_touch(self, tile);
+  self->free = *(void **)tile;
+  self->count += 1;
+  memset(tile, 0, size);
+  return tile;
+}
+
+void tilepool_release(TilePool *const self, void *const tile) {
+  tilepool_touch(self, tile);
+  *(void **)tile = self->free;
+  self->free = tile;
+  self->count -= 1;
+}
+
+void tilepool_evict(TilePool *const self, Arena *const arena) {
+  self->clock += 1;
+  const u64 keep = self->budget >> TILEPOOL_STORE_SLAB_SHIFT;
+  if (!self->base || !self->budget || self->resident_nb <= keep) {
+    return;
+  }
+
+  // Least recently touched first, the clock above the slab index
+  const u64 slab_nb = arrlenu(self->slabs);
+  u64 *const order = arena_alloc(arena, self->resident_nb * sizeof(u64));
+  u64 *const tmp = arena_alloc(arena, self->resident_nb * sizeof(u64));
+  u64 resident_nb = 0;
+  for (u64 i = 0; i < slab_nb; i++) {
+    if (self->resident[i]) {
+      order[resident_nb++] = self->used[i] << TILEPOOL_STORE_SLAB_BITS | i;
+    }
+  }
+  radix_sort(order, tmp, resident_nb);
+
+  // Dirty pages are written back to the file before being dropped. Without
+  // MADV_PAGEOUT, they are only unmapped & left to the page cache
+  for (u64 i = 0; i < resident_nb - keep; i++) {
+    const u64 slab = order[i] & ((1u << TILEPOOL_STORE_SLAB_BITS) - 1);
+    bool evicted = false;
+#ifdef MADV_PAGEOUT
+    evicted = !madvise(self->slabs[slab], TILEPOOL_STORE_SLAB_SIZE,
+                       MADV_PAGEOUT);
+#endif
+    if (!evicted) {
+      madvise(self->slabs[slab], TILEPOOL_STORE_SLAB_SIZE, MADV_DONTNEED);
+    }
+    self->resident[slab] = false;
+  }
+  self->evicted_nb += resident_nb - keep;
+  self->resident_nb = keep;
+}
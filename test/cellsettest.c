@@ -0,0 +1,122 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cellset.h"
+
+#define SIDE 128 // Reference grid is [-SIDE/2, SIDE/2)^2
+#define OPS 1000000
+
+static bool reference[SIDE][SIDE];
+
+int main(void) {
+  CellSet set = {0};
+  u64 count = 0;
+  int failures = 0;
+
+  srand(42);
+
+  // Random inserts & erases, heavy enough to leave tombstones and rehash
+  for (u32 i = 0; i < OPS; i++) {
+    const i32 x = rand() % SIDE - SIDE / 2;
+    const i32 y = rand() % SIDE - SIDE / 2;
+    const CellKey key = cellset_key(x, y);
+    bool *const ref = &reference[x + SIDE / 2][y + SIDE / 2];
+
+    if (rand() % 2) {
+      u32 *const value = cellset_insert(&set, key, (u32)i);
+      if (!*ref) {
+        count += 1;
+        *ref = true;
+        if (*value != (u32)i) {
+          printf("Insert: wrong value for (%d, %d)\n", x, y);
+          failures++;
+        }
+      }
+    } else {
+      const bool found = cellset_erase(&set, key);
+      if (found != *ref) {
+        printf("Erase: (%d, %d) found %d, expected %d\n", x, y, found, *ref);
+        failures++;
+      }
+      count -= *ref;
+      *ref = false;
+    }
+  }
+
+  if (set.count != count) {
+    printf("Count: %lu, expected %lu\n", set.count, count);
+    failures++;
+  }
+
+  for (i32 x = -SIDE / 2; x < SIDE / 2; x++) {
+    for (i32 y = -SIDE / 2; y < SIDE / 2; y++) {
+      if (cellset_contains(&set, cellset_key(x, y)) !=
+          reference[x + SIDE / 2][y + SIDE / 2]) {
+        printf("Contains: (%d, %d) mismatch\n", x, y);
+        failures++;
+      }
+    }
+  }
+
+  u64 iterated = 0;
+  for (u64 i = cellset_next(&set, 0); i < set.capacity;
+       i = cellset_next(&set, i + 1)) {
+    const i32 x = cellset_key_x(set.keys[i]);
+    const i32 y = cellset_key_y(set.keys[i]);
+    if (!reference[x + SIDE / 2][y + SIDE / 2]) {
+      printf("Iterate: (%d, %d) should not be in the set\n", x, y);
+      failures++;
+    }
+    iterated += 1;
+  }
+  if (iterated != count) {
+    printf("Iterate: visited %lu cells, expected %lu\n", iterated, count);
+    failures++;
+  }
+
+  // Building a copy, starting undersized so it grows
+  CellSet copy = {0};
+  for (u64 i = cellset_next(&set, 0); i < set.capacity;
+       i = cellset_next(&set, i + 1)) {
+    cellset_insert_new(&copy, set.keys[i], set.values[i]);
+  }
+  if (copy.count != count) {
+    printf("Insert new: count %lu, expected %lu\n", copy.count, count);
+    failures++;
+  }
+  for (i32 x = -SIDE / 2; x < SIDE / 2; x++) {
+    for (i32 y = -SIDE / 2; y < SIDE / 2; y++) {
+      const u32 *const value = cellset_get(&copy, cellset_key(x, y));
+      if ((value != NULL) != reference[x + SIDE / 2][y + SIDE / 2] ||
+          (value && *value != *cellset_get(&set, cellset_key(x, y)))) {
+        printf("Insert new: (%d, %d) mismatch\n", x, y);
+        failures++;
+      }
+    }
+  }
+  cellset_free(&copy);
+
+  // Bulk operations
+  CellKey *const keys = malloc(SIDE * SIDE * sizeof(CellKey));
+  for (i32 i = 0; i < SIDE * SIDE; i++) {
+    keys[i] = cellset_key(i % SIDE - SIDE / 2, i / SIDE - SIDE / 2);
+  }
+  cellset_insert_bulk(&set, keys, SIDE * SIDE);
+  if (set.count != SIDE * SIDE) {
+    printf("Insert bulk: count %lu, expected %d\n", set.count, SIDE * SIDE);
+    failures++;
+  }
+  const u64 erased = cellset_erase_bulk(&set, keys, SIDE * SIDE);
+  if (erased != SIDE * SIDE || set.count) {
+    printf("Erase bulk: erased %lu, %lu left\n", erased, set.count);
+    failures++;
+  }
+
+  free(keys);
+  cellset_free(&set);
+
+  printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
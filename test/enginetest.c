@@ -0,0 +1,1544 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#define STB_DS_IMPLEMENTATION
+#include "stb_ds.h"
+#pragma GCC diagnostic pop
+
+#include "engine.h"
+#include "kernel.h"
+#include "morton.h"
+#include "radix.h"
+#include "render.h"
+
+#define SOUP_SIZE 200 // Random soup spans [-SOUP_SIZE/2, SOUP_SIZE/2)^2
+#define GENERATIONS 300
+#define SETTLE_GENERATIONS 4000
+#define STEP_N 333 // Not a power of 2, so hashlife needs several step sizes
+#define RECT_GENERATIONS 40
+#define STATE_GRID 600 // Multi-state reference grid, room for 200 generations
+
+// Every engine kind is run side by side with the sparse engine, which is the
+// reference implementation
+//
+
+typedef struct CompareCtx {
+  const Engine *reference;
+  u64 mismatches;
+} CompareCtx;
+
+static void compare_cell(void *const ctx, i64 x, i64 y) {
+  CompareCtx *const compare = (CompareCtx *)ctx;
+  if (!engine_get_cell(compare->reference, x, y)) {
+    compare->mismatches += 1;
+  }
+}
+
+static void count_cell(void *const ctx, i64 x, i64 y) {
+  (void)x;
+  (void)y;
+  *(u64 *)ctx += 1;
+}
+
+// Same population and every cell of engine alive in reference
+static bool engine_equal(const Engine *const engine,
+                         const Engine *const reference) {
+  CompareCtx compare = {.reference = reference};
+  engine_foreach_cell(engine, CELLRECT64_ALL, &compare_cell, &compare);
+  return !compare.mismatches &&
+         engine_population(engine) == engine_population(reference);
+}
+
+static void seed_soup(Engine *const engine, u32 seed) {
+  srand(seed);
+  for (i32 x = -SOUP_SIZE / 2; x < SOUP_SIZE / 2; x++) {
+    for (i32 y = -SOUP_SIZE / 2; y < SOUP_SIZE / 2; y++) {
+      if (rand() % 3 == 0) {
+        engine_set_cell(engine, x, y, true);
+      }
+    }
+  }
+}
+
+// Runs kind side by side with the sparse engine, returns true if they agree
+static bool cross_check(EngineKind kind, ThreadPool *const pool,
+                        const char *const label, u32 seed) {
+  Engine reference = {0};
+  Engine engine = {.pool = pool};
+  engine_set_kind(&engine, kind);
+
+  seed_soup(&reference, seed);
+  seed_soup(&engine, seed);
+
+  // Toggle cells on both sides of tile borders
+  for (i32 i = -70; i < 70; i += 7) {
+    engine_toggle_cell(&reference, i, -i);
+    engine_toggle_cell(&engine, i, -i);
+  }
+
+  u32 generation = 0;
+  for (; generation < GENERATIONS; generation++) {
+    if (!engine_equal(&engine, &reference)) {
+      break;
+    }
+    engine_step(&reference);
+    engine_step(&engine);
+  }
+
+  bool ok = generation == GENERATIONS;
+  printf("%-16s %s after %u generations (%lu cells)\n", label,
+         ok ? "OK" : "FAILED", generation, engine_population(&engine));
+
+  // Migrating back and forth must keep every cell. Hashes updated along the
+  // steps are the ones of the same cells set from scratch
+  const u64 hash = engine_hash(&engine);
+  const u64 reference_hash = engine_hash(&reference);
+  engine_set_kind(&engine, engine_sparse);
+  if (engine_hash(&engine) != reference_hash) {
+    printf("%-16s FAILED sparse hash\n", label);
+    ok = false;
+  }
+  engine_set_kind(&engine, kind);
+  if (!engine_equal(&engine, &reference) || engine_hash(&engine) != hash) {
+    printf("%-16s FAILED migration\n", label);
+    ok = false;
+  }
+
+  engine_free(&reference);
+  engine_free(&engine);
+
+  return ok;
+}
+
+// Once a soup settles most tiles are skipped, toggles in the settled area
+// must wake them up
+static bool check_settled(void) {
+  Engine reference = {0};
+  Engine engine = {0};
+  engine_set_kind(&engine, engine_tiled);
+
+  seed_soup(&reference, 11);
+  seed_soup(&engine, 11);
+
+  bool ok = true;
+  u32 generation = 0;
+  for (; generation < SETTLE_GENERATIONS && ok; generation++) {
+    if (generation % (SETTLE_GENERATIONS / 4) == 0) {
+      for (i32 i = -40; i < 40; i += 3) {
+        engine_toggle_cell(&reference, i, i / 2);
+        engine_toggle_cell(&engine, i, i / 2);
+      }
+    }
+    engine_step(&reference);
+    engine_step(&engine);
+    ok = engine_equal(&engine, &reference);
+  }
+
+  printf("%-16s %s after %u generations (%lu/%lu active tiles)\n",
+         "tiled/settled", ok ? "OK" : "FAILED", generation,
+         engine.tiles.active_nb, (u64)arrlenu(engine.tiles.tiles));
+
+  engine_free(&reference);
+  engine_free(&engine);
+
+  return ok;
+}
+
+// Bytes an allocation of size takes in an arena
+static u64 arena_size(u64 size) {
+  return (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+// Allocations are aligned & packed in the current block, growing appends
+// blocks, a reset merges them into one presized block that the next
+// generation reuses without malloc. Figures of a generation move to last_*
+static bool check_arena(void) {
+  Arena arena = {0};
+  const u64 sizes[] = {1, 63, 64, 65, 200};
+  u64 used = 0;
+  u8 *previous = NULL;
+  bool ok = true;
+  for (u32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    u8 *const ptr = arena_alloc(&arena, sizes[i]);
+    memset(ptr, 0xA5, sizes[i]);
+    ok &= (uintptr_t)ptr % ARENA_ALIGN == 0 &&
+          (!previous || (u64)(ptr - previous) == arena_size(sizes[i - 1]));
+    previous = ptr;
+    used += arena_size(sizes[i]);
+  }
+  ok &= arena.used == used && arena.alloc_nb == 5 &&
+        arena.capacity == ARENA_MIN_BLOCK && !arena.blocks->next;
+
+  // Past the first block: a block as large, then one doubled until it fits
+  memset(arena_alloc(&arena, ARENA_MIN_BLOCK), 0, ARENA_MIN_BLOCK);
+  memset(arena_alloc(&arena, 3 * ARENA_MIN_BLOCK), 0, 3 * ARENA_MIN_BLOCK);
+  used += 4 * ARENA_MIN_BLOCK;
+  const u64 capacity = 6 * ARENA_MIN_BLOCK;
+  ok &= arena.capacity == capacity && arena.blocks->next &&
+        arena.blocks->next->next && !arena.blocks->next->next->next;
+
+  arena_reset(&arena);
+  ok &= arena.blocks && !arena.blocks->next &&
+        arena.blocks->size == capacity && arena.capacity == capacity &&
+        !arena.used && !arena.alloc_nb && arena.time == 0.0 &&
+        arena.last_used == used && arena.last_alloc_nb == 7 &&
+        arena.last_time > 0.0;
+
+  // The whole footprint again, from the start of the merged block
+  const ArenaBlock *const block = arena.blocks;
+  u8 *const first = arena_alloc(&arena, 100);
+  ok &= first == block->data;
+  memset(arena_alloc(&arena, capacity - 128), 0, capacity - 128);
+  arena_reset(&arena);
+  ok &= arena.blocks == block && arena.capacity == capacity &&
+        arena.last_used == capacity && arena.last_time == 0.0;
+
+  arena_free(&arena);
+  ok &= !arena.blocks && !arena.capacity && !arena.last_used;
+
+  printf("%-16s %s\n", "arena", ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// A glider crossing tiles keeps reusing the pool's first slab: the tiles it
+// leaves are released & handed out again ahead of it
+static bool check_tile_pool(EngineKind kind) {
+  Engine engine = {0};
+  engine_set_kind(&engine, kind);
+  const i32 glider[][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  for (u32 i = 0; i < sizeof(glider) / sizeof(glider[0]); i++) {
+    engine_set_cell(&engine, glider[i][0], glider[i][1], true);
+  }
+
+  // 16 tiles diagonally
+  for (u32 generation = 0; generation < 16 * 4 * TILE_SIZE; generation++) {
+    engine_step(&engine);
+  }
+
+  const TilePool *const tile_pool = kind == engine_states
+                                        ? &engine.states.tile_pool
+                                        : &engine.tiles.tile_pool;
+  const bool ok = engine_population(&engine) == 5 && tile_pool->count <= 9 &&
+                  arrlenu(tile_pool->slabs) == 1;
+  printf("%-16s %s (%lu/%lu tiles in use)\n",
+         kind == engine_states ? "states/pool" : "tiled/pool",
+         ok ? "OK" : "FAILED", tile_pool->count, tile_pool->capacity);
+
+  engine_free(&engine);
+  return ok;
+}
+
+// HashLife steps 2^step_exp generations at once, each step is checked against
+// as many sparse steps
+static bool check_step_exp(u32 step_exp, u32 steps) {
+  Engine reference = {0};
+  Engine engine = {0};
+  engine_set_kind(&engine, engine_hashlife);
+  engine_set_step_exp(&engine, step_exp);
+
+  seed_soup(&reference, 7);
+  seed_soup(&engine, 7);
+
+  u64 generation = 0;
+  bool ok = true;
+  for (u32 step = 0; step < steps && ok; step++) {
+    const u64 generations = engine_step(&engine);
+    for (u64 i = 0; i < generations; i++) {
+      engine_step(&reference);
+    }
+    generation += generations;
+    ok = engine_equal(&engine, &reference);
+  }
+
+  char label[32];
+  snprintf(label, sizeof(label), "hashlife/2^%u", step_exp);
+  printf("%-16s %s after %lu generations (%lu cells)\n", label,
+         ok ? "OK" : "FAILED", generation, engine_population(&engine));
+
+  engine_free(&reference);
+  engine_free(&engine);
+
+  return ok;
+}
+
+// A glider stepped by hashlife past 32-bit coordinates is exactly where it
+// should be. Auto mode keeps it on hashlife, the other kinds drop such cells
+static bool check_far(void) {
+  Engine engine = {0};
+  engine_set_kind(&engine, engine_hashlife);
+  engine_set_step_exp(&engine, 40);
+  const i32 glider[][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  for (u32 i = 0; i < sizeof(glider) / sizeof(glider[0]); i++) {
+    engine_set_cell(&engine, glider[i][0], glider[i][1], true);
+  }
+  for (u32 step = 0; step < 3; step++) {
+    engine_step(&engine);
+  }
+  engine_set_step_exp(&engine, 0);
+  engine_set_automatic(&engine, true);
+  for (u32 generation = 0; generation < 2 * ENGINE_AUTO_INTERVAL;
+       generation++) {
+    engine_step(&engine);
+  }
+
+  // A glider moves by a cell diagonally every 4 generations
+  const i64 shift = (i64)(engine.generation / 4);
+  bool ok = engine.kind == engine_hashlife && shift > INT32_MAX &&
+            engine_population(&engine) == 5;
+  for (u32 i = 0; i < sizeof(glider) / sizeof(glider[0]); i++) {
+    ok &= engine_get_cell(&engine, glider[i][0] + shift, glider[i][1] + shift);
+  }
+
+  Engine sparse = {0};
+  engine_set_cell(&sparse, shift, 0, true);
+  ok &= !engine_population(&sparse) && !engine_get_cell(&sparse, shift, 0) &&
+        !engine_kind_contains(engine_sparse, shift, 0) &&
+        engine_kind_contains(engine_hashlife, shift, -shift);
+
+  printf("%-16s %s after %lu generations (glider at %ld)\n", "hashlife/far",
+         ok ? "OK" : "FAILED", engine.generation, shift);
+
+  engine_free(&sparse);
+  engine_free(&engine);
+  return ok;
+}
+
+// Blinkers in opposite corners of the hashlife universe step at the largest
+// step exponent, the root is as large as it can get
+static bool check_rim(void) {
+  const i64 corners[][2] = {{-HASHLIFE_MAX_COORD + 1, -HASHLIFE_MAX_COORD + 1},
+                            {HASHLIFE_MAX_COORD - 2, HASHLIFE_MAX_COORD - 2}};
+  Engine engine = {0};
+  engine_set_kind(&engine, engine_hashlife);
+  engine_set_step_exp(&engine, HASHLIFE_MAX_STEP_EXP);
+  for (u32 i = 0; i < 2; i++) {
+    for (i64 dx = -1; dx <= 1; dx++) {
+      engine_set_cell(&engine, corners[i][0] + dx, corners[i][1], true);
+    }
+  }
+  for (u32 step = 0; step < 3; step++) {
+    engine_step(&engine);
+  }
+
+  // The blinkers have an even number of generations to get back in phase
+  bool ok = engine_population(&engine) == 6 &&
+            engine.generation == 3ull << HASHLIFE_MAX_STEP_EXP;
+  for (u32 i = 0; i < 2; i++) {
+    for (i64 dx = -1; dx <= 1; dx++) {
+      ok &= engine_get_cell(&engine, corners[i][0] + dx, corners[i][1]);
+    }
+  }
+  ok &= engine_kind_contains(engine_hashlife, corners[1][0] + 1, 0) &&
+        !engine_kind_contains(engine_hashlife, corners[1][0] + 2, 0);
+
+  printf("%-16s %s after %lu generations (blinkers at %ld)\n", "hashlife/rim",
+         ok ? "OK" : "FAILED", engine.generation, corners[1][0]);
+
+  engine_free(&engine);
+  return ok;
+}
+
+// Stepping UINT64_MAX generations stops once the glider flies past
+// HASHLIFE_MAX_COORD, without losing it or the step exponent
+static bool check_step_limit(void) {
+  const i32 glider[][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  Engine engine = {0};
+  engine_set_kind(&engine, engine_hashlife);
+  engine_set_step_exp(&engine, 3);
+  for (u32 i = 0; i < sizeof(glider) / sizeof(glider[0]); i++) {
+    engine_set_cell(&engine, glider[i][0], glider[i][1], true);
+  }
+
+  const u64 done = engine_step_n(&engine, UINT64_MAX, 60.0);
+  const u64 again = engine_step_n(&engine, UINT64_MAX, 60.0);
+
+  const i64 shift = (i64)(engine.generation / 4);
+  bool ok = done && !again && engine.generation == done &&
+            shift + 2 >= HASHLIFE_MAX_COORD && engine.life.step_exp == 3 &&
+            engine_population(&engine) == 5;
+  for (u32 i = 0; i < sizeof(glider) / sizeof(glider[0]); i++) {
+    ok &= hashlife_get_cell(&engine.life, glider[i][0] + shift,
+                            glider[i][1] + shift);
+  }
+
+  printf("%-16s %s after %lu generations (glider at %ld)\n", "hashlife/limit",
+         ok ? "OK" : "FAILED", engine.generation, shift);
+
+  engine_free(&engine);
+  return ok;
+}
+
+// A glider flying across INT32_MAX: the plane of a 32-bit kind ends there,
+// automatic switching hands it to hashlife first so it stays exact
+static bool check_edge(EngineKind kind) {
+  const i32 glider[][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  const i64 start = (i64)INT32_MAX - 8;
+  Engine clipped = {0};
+  Engine automatic = {0};
+  engine_set_kind(&clipped, kind);
+  engine_set_kind(&automatic, kind);
+  engine_set_automatic(&automatic, true);
+  for (u32 i = 0; i < sizeof(glider) / sizeof(glider[0]); i++) {
+    engine_set_cell(&clipped, start + glider[i][0], glider[i][1], true);
+    engine_set_cell(&automatic, start + glider[i][0], glider[i][1], true);
+  }
+
+  const u32 generations = 80;
+  for (u32 generation = 0; generation < generations; generation++) {
+    engine_step(&clipped);
+    engine_step(&automatic);
+  }
+
+  // Clipped cells are all within 32 bits
+  u64 count = 0;
+  engine_foreach_cell(&clipped, CELLRECT64_ALL, &count_cell, &count);
+  bool ok = clipped.kind == kind && count == engine_population(&clipped);
+
+  const i64 shift = generations / 4;
+  ok &= automatic.kind == engine_hashlife &&
+        engine_population(&automatic) == 5;
+  for (u32 i = 0; i < sizeof(glider) / sizeof(glider[0]); i++) {
+    ok &= engine_get_cell(&automatic, start + glider[i][0] + shift,
+                          glider[i][1] + shift);
+  }
+
+  char label[32];
+  snprintf(label, sizeof(label), "%s/edge", engine_kind_name(kind));
+  printf("%-16s %s (%lu cells clipped, glider at %ld)\n", label,
+         ok ? "OK" : "FAILED", engine_population(&clipped), start + shift);
+
+  engine_free(&clipped);
+  engine_free(&automatic);
+  return ok;
+}
+
+// engine_step_n computes exactly the requested generations on every engine,
+// then steps go back to normal. An automatic engine switching to hashlife
+// along the way (step_exp isn't 0) doesn't overshoot either
+static bool check_step_n(EngineKind kind) {
+  Engine reference = {0};
+  Engine engine = {0};
+  Engine automatic = {0};
+  engine_set_kind(&engine, kind);
+  engine_set_step_exp(&engine, 3);
+  engine_set_kind(&automatic, kind);
+  engine_set_step_exp(&automatic, 3);
+  engine_set_automatic(&automatic, true);
+
+  seed_soup(&reference, 5);
+  seed_soup(&engine, 5);
+  seed_soup(&automatic, 5);
+
+  bool ok = engine_step_n(&engine, STEP_N, INFINITY) == STEP_N &&
+            engine_step_n(&automatic, STEP_N, INFINITY) == STEP_N;
+  for (u32 i = 0; i < STEP_N; i++) {
+    engine_step(&reference);
+  }
+  ok &= engine_equal(&engine, &reference) &&
+        engine_equal(&automatic, &reference) &&
+        automatic.generation == STEP_N && automatic.kind == engine_hashlife &&
+        automatic.life.step_exp == 3;
+
+  // Out of budget, still one step
+  ok &= engine_step_n(&engine, STEP_N, 0.0) >= 1;
+
+  const u64 generations = engine_step(&engine);
+  ok &= generations == (kind == engine_hashlife ? 8 : 1);
+
+  char label[32];
+  snprintf(label, sizeof(label), "%s/step_n", engine_kind_name(kind));
+  printf("%-16s %s\n", label, ok ? "OK" : "FAILED");
+
+  engine_free(&reference);
+  engine_free(&engine);
+  engine_free(&automatic);
+
+  return ok;
+}
+
+// Cells handed out in a rect are exactly the alive cells of that rect, before
+// and after steps (tiled kinds then walk the rect in Z-order)
+static bool rect_equal(const Engine *const engine, CellRect64 rect) {
+  const i32 reach = SOUP_SIZE / 2 + RECT_GENERATIONS;
+  u64 expected = 0;
+  for (i32 x = -reach; x < reach; x++) {
+    for (i32 y = -reach; y < reach; y++) {
+      expected +=
+          cellrect64_contains(rect, x, y) && engine_get_cell(engine, x, y);
+    }
+  }
+
+  CompareCtx compare = {.reference = engine};
+  u64 count = 0;
+  engine_foreach_cell(engine, rect, &count_cell, &count);
+  engine_foreach_cell(engine, rect, &compare_cell, &compare);
+
+  if (count != expected || compare.mismatches) {
+    printf("%-16s FAILED rect (%ld, %ld)-(%ld, %ld) (%lu cells, %lu "
+           "expected)\n",
+           engine_kind_name(engine->kind), rect.min_x, rect.min_y, rect.max_x,
+           rect.max_y, count, expected);
+    return false;
+  }
+  return true;
+}
+
+static bool check_rect(EngineKind kind) {
+  Engine engine = {0};
+  engine_set_kind(&engine, kind);
+  seed_soup(&engine, 3);
+
+  const CellRect64 rects[] = {
+      {.min_x = -37, .min_y = -5, .max_x = 70, .max_y = 12},
+      {.min_x = -130, .min_y = -2, .max_x = -64, .max_y = 1},
+      {.min_x = 0, .min_y = -128, .max_x = 0, .max_y = 127},
+      {.min_x = 63, .min_y = 63, .max_x = 64, .max_y = 64},
+      {.min_x = -200, .min_y = -200, .max_x = 200, .max_y = 200},
+  };
+
+  bool ok = true;
+  for (u32 i = 0; i < sizeof(rects) / sizeof(rects[0]); i++) {
+    ok &= rect_equal(&engine, rects[i]);
+  }
+  for (u32 generation = 0; generation < RECT_GENERATIONS; generation++) {
+    engine_step(&engine);
+  }
+  for (u32 i = 0; i < sizeof(rects) / sizeof(rects[0]); i++) {
+    ok &= rect_equal(&engine, rects[i]);
+  }
+
+  engine_free(&engine);
+  return ok;
+}
+
+// A row of 10 cells becomes a pentadecathlon (period 15) next to a block
+// (period 1): every engine finds the same cycle. A glider never repeats, even
+// with hashlife jumps
+static bool check_cycle(EngineKind kind) {
+  Engine engine = {0};
+  engine_set_kind(&engine, kind);
+
+  for (i32 x = 0; x < 10; x++) {
+    engine_set_cell(&engine, x, 0, true);
+  }
+  engine_set_cell(&engine, 40, 40, true);
+  engine_set_cell(&engine, 41, 40, true);
+  engine_set_cell(&engine, 40, 41, true);
+  engine_set_cell(&engine, 41, 41, true);
+
+  u64 period, cycle_start, generation = 0;
+  while (!engine_cycle(&engine, &period, &cycle_start) && generation < 1000) {
+    generation += engine_step(&engine);
+  }
+  const u64 start = cycle_start;
+  bool ok = period == 15 && generation == cycle_start + period;
+
+  // Edits start over
+  engine_toggle_cell(&engine, 40, 40);
+  engine_toggle_cell(&engine, 40, 40);
+  ok &= !engine_cycle(&engine, &period, &cycle_start);
+
+  engine_free(&engine);
+  engine_set_kind(&engine, kind);
+  const i32 glider[][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  for (u32 i = 0; i < 5; i++) {
+    engine_set_cell(&engine, glider[i][0], glider[i][1], true);
+  }
+  ok &= engine_step_n(&engine, 1000, INFINITY) == 1000 &&
+        !engine_cycle(&engine, &period, &cycle_start);
+
+  char label[32];
+  snprintf(label, sizeof(label), "%s/cycle", engine_kind_name(kind));
+  printf("%-16s %s (period 15 from generation %lu)\n", label,
+         ok ? "OK" : "FAILED", start);
+
+  engine_free(&engine);
+  return ok;
+}
+
+// Other rules go through the generic kernel, compared to the sparse engine
+static bool check_rule(EngineKind kind, const char *const rule_str,
+                       u32 generations) {
+  Rule rule;
+  if (!rule_parse(rule_str, &rule)) {
+    printf("%-16s FAILED parsing %s\n", engine_kind_name(kind), rule_str);
+    return false;
+  }
+
+  Engine reference = {0};
+  Engine engine = {0};
+  engine_set_kind(&engine, kind);
+  engine_set_rule(&reference, rule);
+  engine_set_rule(&engine, rule);
+
+  seed_soup(&reference, 13);
+  seed_soup(&engine, 13);
+
+  u32 generation = 0;
+  for (; generation < generations; generation++) {
+    if (!engine_equal(&engine, &reference)) {
+      break;
+    }
+    engine_step(&reference);
+    engine_step(&engine);
+  }
+
+  char label[32];
+  snprintf(label, sizeof(label), "%s/%s", engine_kind_name(kind), rule_str);
+  const bool ok = generation == generations;
+  printf("%-16s %s after %u generations (%lu cells)\n", label,
+         ok ? "OK" : "FAILED", generation, engine_population(&engine));
+
+  engine_free(&reference);
+  engine_free(&engine);
+  return ok;
+}
+
+// Isotropic rules commute with turns & mirrors: a soup and its image must
+// still be images of each other generations later
+//
+
+typedef struct ImageCtx {
+  Engine *image;
+  bool mirror; // Mirrored around the y axis rather than turned a quarter
+} ImageCtx;
+
+static void image_cell(void *const ctx, i64 x, i64 y) {
+  const ImageCtx *const image = (const ImageCtx *)ctx;
+  engine_set_cell(image->image, image->mirror ? -x : -y, image->mirror ? y : x,
+                  true);
+}
+
+static bool check_isotropic(EngineKind kind, const char *const rule_str,
+                            bool mirror) {
+  Rule rule;
+  rule_parse(rule_str, &rule);
+  Engine engine = {0};
+  Engine image = {0};
+  engine_set_kind(&engine, kind);
+  engine_set_kind(&image, kind);
+  engine_set_rule(&engine, rule);
+  engine_set_rule(&image, rule);
+
+  seed_soup(&engine, 21);
+  engine_foreach_cell(&engine, CELLRECT64_ALL, &image_cell,
+                      &(ImageCtx){.image = &image, .mirror = mirror});
+  for (u32 generation = 0; generation < 100; generation++) {
+    engine_step(&engine);
+    engine_step(&image);
+  }
+
+  Engine expected = {0};
+  engine_foreach_cell(&engine, CELLRECT64_ALL, &image_cell,
+                      &(ImageCtx){.image = &expected, .mirror = mirror});
+  const bool ok = engine_equal(&image, &expected);
+
+  char label[32];
+  snprintf(label, sizeof(label), "%s/%s", engine_kind_name(kind),
+           mirror ? "mirror" : "turn");
+  printf("%-16s %s after 100 generations (%lu cells)\n", label,
+         ok ? "OK" : "FAILED", engine_population(&image));
+
+  engine_free(&engine);
+  engine_free(&image);
+  engine_free(&expected);
+  return ok;
+}
+
+// Multi-state rules are checked against a plain grid, the states engine being
+// the only one to run them
+//
+
+typedef struct StateGrid {
+  u8 cells[2][STATE_GRID][STATE_GRID]; // Cell (x, y) at [y + STATE_GRID / 2]
+  u32 phase;
+} StateGrid;
+
+static StateGrid grid;
+
+static void grid_step(Rule rule) {
+  const u8 (*const cur)[STATE_GRID] = grid.cells[grid.phase];
+  u8 (*const nxt)[STATE_GRID] = grid.cells[grid.phase ^ 1];
+  const i32 range = (i32)rule_range(rule);
+
+  for (i32 y = 0; y < STATE_GRID; y++) {
+    for (i32 x = 0; x < STATE_GRID; x++) {
+      u32 count = 0, neighbourhood = 0;
+      for (i32 ny = y - range; ny <= y + range; ny++) {
+        for (i32 nx = x - range; nx <= x + range; nx++) {
+          const bool head = nx >= 0 && ny >= 0 && nx < STATE_GRID &&
+                            ny < STATE_GRID && cur[ny][nx] == 1;
+          count += head;
+          if (range == 1) {
+            neighbourhood |= (u32)head << ((ny - y + 1) * 3 + nx - x + 1);
+          }
+        }
+      }
+      const bool middle = rule.family == rule_larger_than_life && rule.middle;
+      count -= !middle && cur[y][x] == 1;
+
+      const u8 state = cur[y][x];
+      if (rule.family == rule_larger_than_life) {
+        const bool born = count >= rule.birth_min && count <= rule.birth_max;
+        const bool kept =
+            count >= rule.survival_min && count <= rule.survival_max;
+        nxt[y][x] = state == 0   ? born
+                    : state == 1 ? (kept ? 1 : rule_states(rule) > 2 ? 2 : 0)
+                    : state + 1u < rule_states(rule) ? (u8)(state + 1)
+                                                     : 0;
+      } else if (rule.family == rule_wireworld) {
+        nxt[y][x] = state == 3 && (count == 1 || count == 2) ? 1
+                    : state == 1                           ? 2
+                    : state == 2                           ? 3
+                                                           : state;
+      } else if (rule.isotropic && state < 2) {
+        const bool alive = rule_next_neighbourhood(rule, neighbourhood);
+        nxt[y][x] = state == 0 ? alive
+                    : alive    ? 1
+                    : rule_states(rule) > 2 ? 2
+                                            : 0;
+      } else if (state == 0) {
+        nxt[y][x] = rule.birth >> count & 1;
+      } else if (state == 1 && rule.survival >> count & 1) {
+        nxt[y][x] = 1;
+      } else {
+        nxt[y][x] = state + 1u < rule_states(rule) ? (u8)(state + 1) : 0;
+      }
+    }
+  }
+  grid.phase ^= 1;
+}
+
+static void compare_state(void *const ctx, i64 x, i64 y, u8 state) {
+  u64 *const mismatches = (u64 *)ctx;
+  *mismatches += grid.cells[grid.phase][y + STATE_GRID / 2]
+                           [x + STATE_GRID / 2] != state;
+}
+
+static bool grid_equal(const Engine *const engine) {
+  u64 mismatches = 0, population = 0;
+  engine_foreach_state(engine, CELLRECT64_ALL, &compare_state, &mismatches);
+  for (u32 y = 0; y < STATE_GRID; y++) {
+    for (u32 x = 0; x < STATE_GRID; x++) {
+      population += grid.cells[grid.phase][y][x] != 0;
+    }
+  }
+  return !mismatches && engine_population(engine) == population;
+}
+
+// Random states in the soup, mostly conductors for Wireworld and denser for
+// Larger than Life
+static bool check_states(const char *const rule_str, ThreadPool *const pool,
+                         const char *const label, u32 generations) {
+  Rule rule;
+  if (!rule_parse(rule_str, &rule)) {
+    printf("%-16s FAILED parsing %s\n", label, rule_str);
+    return false;
+  }
+
+  Engine engine = {.pool = pool};
+  engine_set_rule(&engine, rule);
+  memset(&grid, 0, sizeof(grid));
+
+  srand(17);
+  const u32 states = rule_states(rule);
+  for (i32 y = -SOUP_SIZE / 2; y < SOUP_SIZE / 2; y++) {
+    for (i32 x = -SOUP_SIZE / 2; x < SOUP_SIZE / 2; x++) {
+      const u32 r = (u32)rand() % 8;
+      const u8 state = rule.family == rule_wireworld
+                           ? (u8)(r < 2 ? 0 : r < 7 ? 3 : r - 6)
+                       : rule.family == rule_larger_than_life
+                           ? (u8)(r < 3 ? 1 : r == 3 && states > 2 ? 2 : 0)
+                           : (u8)(r < states ? r : 0);
+      engine_set_state(&engine, x, y, state);
+      grid.cells[0][y + STATE_GRID / 2][x + STATE_GRID / 2] = state;
+    }
+  }
+
+  u32 generation = 0;
+  for (; generation < generations; generation++) {
+    if (!grid_equal(&engine)) {
+      break;
+    }
+    engine_step(&engine);
+    grid_step(rule_resolve(rule));
+  }
+
+  const bool ok = generation == generations;
+  printf("%-16s %s after %u generations (%lu cells)\n", label,
+         ok ? "OK" : "FAILED", generation, engine_population(&engine));
+
+  engine_free(&engine);
+  return ok;
+}
+
+// A Wireworld electron runs around a 6x4 loop of 12 conductors with cut
+// corners, crossing tile borders: period 12, the conductors alone are static
+static bool check_wireworld(void) {
+  Rule rule;
+  rule_parse("wireworld", &rule);
+  Engine engine = {0};
+  engine_set_rule(&engine, rule);
+
+  for (i32 i = 62; i < 66; i++) {
+    engine_set_state(&engine, i, 62, RULE_WIREWORLD_CONDUCTOR);
+    engine_set_state(&engine, i, 65, RULE_WIREWORLD_CONDUCTOR);
+  }
+  for (i32 i = 63; i < 65; i++) {
+    engine_set_state(&engine, 61, i, RULE_WIREWORLD_CONDUCTOR);
+    engine_set_state(&engine, 66, i, RULE_WIREWORLD_CONDUCTOR);
+  }
+  engine_set_state(&engine, 63, 62, RULE_WIREWORLD_HEAD);
+  engine_set_state(&engine, 62, 62, RULE_WIREWORLD_TAIL);
+
+  u64 period, cycle_start, generation = 0;
+  while (!engine_cycle(&engine, &period, &cycle_start) && generation < 100) {
+    generation += engine_step(&engine);
+  }
+  bool ok = period == 12 && engine_population(&engine) == 12 &&
+            engine.kind == engine_states;
+
+  // Removing the electron leaves a still life
+  for (i32 y = 62; y < 66; y++) {
+    for (i32 x = 61; x < 67; x++) {
+      if (engine_get_state(&engine, x, y)) {
+        engine_set_state(&engine, x, y, RULE_WIREWORLD_CONDUCTOR);
+      }
+    }
+  }
+  engine_step(&engine);
+  engine_step(&engine);
+  ok &= engine_cycle(&engine, &period, &cycle_start) && period == 1 &&
+        !engine.states.active_nb;
+
+  printf("%-16s %s\n", "states/clock", ok ? "OK" : "FAILED");
+
+  engine_free(&engine);
+  return ok;
+}
+
+// A Wireworld wire in a render buffer: each state is the run its ends say,
+// cells out of view are left out, and a two-state fill reuses the buffer
+static bool check_render(void) {
+  Rule rule;
+  rule_parse("wireworld", &rule);
+  Engine engine = {0};
+  engine_set_rule(&engine, rule);
+  // Conductor, tail, head & 3 conductors, one more conductor out of view
+  for (i32 x = 0; x < 6; x++) {
+    engine_set_state(&engine, x, 0, RULE_WIREWORLD_CONDUCTOR);
+  }
+  engine_set_state(&engine, 1, 0, RULE_WIREWORLD_TAIL);
+  engine_set_state(&engine, 2, 0, RULE_WIREWORLD_HEAD);
+  engine_set_state(&engine, 10, 0, RULE_WIREWORLD_CONDUCTOR);
+  const CellRect64 view = {.min_x = 0, .min_y = -1, .max_x = 7, .max_y = 1};
+
+  RenderBuffer buffer = {0};
+  bool ok = true;
+  for (u32 fill = 0; fill < 2; fill++) {
+    render_buffer_fill(&buffer, &engine, view);
+    const u32 *const ends = buffer.ends;
+    ok &= ends[0] == 0 && ends[RULE_WIREWORLD_HEAD] == 1 &&
+          ends[RULE_WIREWORLD_TAIL] == 2 &&
+          ends[RULE_WIREWORLD_CONDUCTOR] == 6 && arrlenu(buffer.cells) == 6 &&
+          buffer.cells[0].x == 2 && buffer.cells[1].x == 1;
+    for (u32 i = ends[RULE_WIREWORLD_TAIL]; i < ends[RULE_WIREWORLD_CONDUCTOR];
+         i++) {
+      ok &= buffer.cells[i].y == 0 &&
+            engine_get_state(&engine, buffer.cells[i].x, 0) ==
+                RULE_WIREWORLD_CONDUCTOR;
+    }
+  }
+
+  Engine life = {0};
+  for (i32 i = 0; i < 4; i++) {
+    engine_set_cell(&life, i & 1, i >> 1, true);
+  }
+  render_buffer_fill(&buffer, &life, view);
+  ok &= buffer.ends[0] == 0 && buffer.ends[1] == 4 &&
+        arrlenu(buffer.cells) == 4 && buffer.rule.family == rule_life_like;
+
+  printf("%-16s %s\n", "render/states", ok ? "OK" : "FAILED");
+
+  render_buffer_free(&buffer);
+  engine_free(&life);
+  engine_free(&engine);
+  return ok;
+}
+
+// B/S & Hensel notations round trip, B0 & malformed rules are rejected. Every
+// letter of a count is the whole count
+// Gliders flying apart millions of cells from a soup, edited along the way:
+// the list engine hashes like the sparse one, so hashes must match too
+static bool check_list_spread(void) {
+  Engine reference = {0};
+  Engine engine = {0};
+  engine_set_kind(&engine, engine_list);
+
+  // Glider heading south east, turned towards each corner
+  const i32 glider[5][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  const i32 far = 1 << 22;
+  for (u32 i = 0; i < 4; i++) {
+    const i32 sx = i & 1 ? 1 : -1;
+    const i32 sy = i & 2 ? 1 : -1;
+    for (u32 j = 0; j < 5; j++) {
+      engine_set_cell(&reference, sx * (far + glider[j][0]),
+                      sy * (far + glider[j][1]), true);
+      engine_set_cell(&engine, sx * (far + glider[j][0]),
+                      sy * (far + glider[j][1]), true);
+    }
+  }
+  seed_soup(&reference, 5);
+  seed_soup(&engine, 5);
+
+  bool ok = true;
+  u32 generation = 0;
+  for (; ok && generation < 200; generation++) {
+    ok = engine_equal(&engine, &reference) &&
+         engine_hash(&engine) == engine_hash(&reference);
+    if (generation % 50 == 25) {
+      for (i32 i = -20; i < 20; i += 3) {
+        engine_toggle_cell(&reference, i, i / 2);
+        engine_toggle_cell(&engine, i, i / 2);
+      }
+    }
+    engine_step(&reference);
+    engine_step(&engine);
+  }
+
+  // Only the glider heading north west
+  const CellRect64 rect = {.min_x = INT32_MIN,
+                           .min_y = INT32_MIN,
+                           .max_x = -far / 2,
+                           .max_y = -far / 2};
+  u64 count = 0, expected = 0;
+  engine_foreach_cell(&engine, rect, &count_cell, &count);
+  engine_foreach_cell(&reference, rect, &count_cell, &expected);
+  ok &= count == 5 && expected == 5;
+
+  printf("%-16s %s after %u generations (%lu cells)\n", "list/spread",
+         ok ? "OK" : "FAILED", generation, engine_population(&engine));
+
+  engine_free(&reference);
+  engine_free(&engine);
+  return ok;
+}
+
+// Gliders leaving a soup end up on islands of their own, the soup keeps
+// merging & splitting
+static bool check_islands(ThreadPool *const pool, const char *const label) {
+  Engine reference = {0};
+  Engine engine = {.pool = pool};
+  engine_set_kind(&engine, engine_islands);
+
+  // Glider heading south east, turned towards each corner
+  const i32 glider[5][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  const i32 far = SOUP_SIZE;
+  for (u32 i = 0; i < 4; i++) {
+    const i32 sx = i & 1 ? 1 : -1;
+    const i32 sy = i & 2 ? 1 : -1;
+    for (u32 j = 0; j < 5; j++) {
+      engine_set_cell(&reference, sx * (far + glider[j][0]),
+                      sy * (far + glider[j][1]), true);
+      engine_set_cell(&engine, sx * (far + glider[j][0]),
+                      sy * (far + glider[j][1]), true);
+    }
+  }
+  seed_soup(&reference, 7);
+  seed_soup(&engine, 7);
+
+  bool ok = true;
+  u32 generation = 0;
+  for (; ok && generation < GENERATIONS; generation++) {
+    ok = engine_equal(&engine, &reference) &&
+         engine_hash(&engine) == engine_hash(&reference);
+    engine_step(&reference);
+    engine_step(&engine);
+  }
+
+  // The gliders & the soup at least
+  const IslandMap *const islands = &engine.islands;
+  ok &= arrlenu(islands->islands) >= 5 && islands->merge_nb &&
+        islands->split_nb;
+
+  printf("%-16s %s after %u generations (%lu cells, %lu islands)\n", label,
+         ok ? "OK" : "FAILED", generation, engine_population(&engine),
+         arrlenu(islands->islands));
+
+  engine_free(&reference);
+  engine_free(&engine);
+  return ok;
+}
+
+// A field of gliders & a soup migrated to islands in one go: a glider per
+// island, the soup in as many as its components allow, same cells as sparse
+static bool check_islands_migrate(void) {
+  Engine reference = {0};
+  Engine engine = {0};
+  const i32 glider[5][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  const i32 side = 48;
+  for (i32 gx = 0; gx < side; gx++) {
+    for (i32 gy = 0; gy < side; gy++) {
+      for (u32 j = 0; j < 5; j++) {
+        const i32 x = SOUP_SIZE + gx * 8 + glider[j][0];
+        const i32 y = gy * 8 + glider[j][1];
+        engine_set_cell(&reference, x, y, true);
+        engine_set_cell(&engine, x, y, true);
+      }
+    }
+  }
+  seed_soup(&reference, 11);
+  seed_soup(&engine, 11);
+  engine_set_kind(&engine, engine_islands);
+
+  const IslandMap *const islands = &engine.islands;
+  bool ok = engine_equal(&engine, &reference) &&
+            engine_hash(&engine) == engine_hash(&reference) &&
+            arrlenu(islands->islands) > (u64)(side * side) &&
+            !islands->merge_nb;
+  const u64 island_nb = arrlenu(islands->islands);
+  for (u32 generation = 0; ok && generation < 16; generation++) {
+    engine_step(&reference);
+    engine_step(&engine);
+    ok = engine_equal(&engine, &reference);
+  }
+
+  printf("%-16s %s after migration (%lu cells, %lu islands)\n",
+         "islands/migrate", ok ? "OK" : "FAILED", engine_population(&engine),
+         island_nb);
+
+  engine_free(&reference);
+  engine_free(&engine);
+  return ok;
+}
+
+// A glider & an LWSS flying away from a block are removed, a glider flying
+// towards it is kept
+static bool check_escape(EngineKind kind) {
+  Engine engine = {0};
+  engine_set_kind(&engine, kind);
+  engine_set_escape(&engine, true);
+
+  const i32 block[4][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+  // Heading south east & west
+  const i32 glider[5][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  const i32 lwss[9][2] = {{1, 0}, {4, 0}, {0, 1}, {0, 2}, {4, 2},
+                          {0, 3}, {1, 3}, {2, 3}, {3, 3}};
+  for (u32 i = 0; i < 4; i++) {
+    engine_set_cell(&engine, block[i][0], block[i][1], true);
+  }
+  for (u32 i = 0; i < 5; i++) {
+    engine_set_cell(&engine, 40 + glider[i][0], 40 + glider[i][1], true);
+    engine_set_cell(&engine, 30 - glider[i][0], 30 - glider[i][1], true);
+  }
+  for (u32 i = 0; i < 9; i++) {
+    engine_set_cell(&engine, -60 + lwss[i][0], lwss[i][1], true);
+  }
+
+  // The glider heading north west is 16 cells closer, still apart
+  const u64 generation = engine_step_n(&engine, ENGINE_ESCAPE_INTERVAL, 1e9);
+  const EngineEscape *const escape = &engine.escape;
+  const bool ok = generation == ENGINE_ESCAPE_INTERVAL &&
+                  engine_population(&engine) == 9 &&
+                  engine_get_cell(&engine, 0, 0) &&
+                  escape->ship_nb[engine_ship_glider] == 1 &&
+                  escape->ship_nb[engine_ship_lwss] == 1 &&
+                  escape->ship_nb[engine_ship_mwss] == 0 &&
+                  escape->ship_nb[engine_ship_hwss] == 0 &&
+                  escape->ship_nb[engine_ship_other] == 0;
+
+  char label[32];
+  snprintf(label, sizeof(label), "%s/escape", engine_kind_name(kind));
+  printf("%-16s %s (%lu cells, %lu removed)\n", label, ok ? "OK" : "FAILED",
+         engine_population(&engine), escape->cell_nb);
+
+  engine_free(&engine);
+  return ok;
+}
+
+// Tile rows paged out after every step have to come back from the store file:
+// a budget under a slab keeps none resident
+//
+
+#define STORE_DIR "/tmp"
+
+static bool check_store(void) {
+  Engine reference = {0};
+  Engine engine = {0};
+  engine_set_kind(&engine, engine_tiled);
+  seed_soup(&reference, 13);
+  seed_soup(&engine, 13);
+
+  // Cells set before are migrated to the store
+  Error err = {0};
+  engine_set_store(&engine, STORE_DIR, 1, &err);
+  bool ok = !err.status;
+
+  u32 generation = 0;
+  for (; ok && generation < GENERATIONS; generation++) {
+    ok = engine_equal(&engine, &reference);
+    engine_step(&reference);
+    engine_step(&engine);
+  }
+
+  const TilePool *const bits_pool = &engine.tiles.bits_pool;
+  ok &= bits_pool->base && bits_pool->evicted_nb >= generation &&
+        !bits_pool->resident_nb;
+
+  Error missing = {0};
+  engine_set_store(&engine, STORE_DIR "/gol-missing/tiles", 0, &missing);
+  ok &= missing.status && !strcmp(engine.store_dir, STORE_DIR);
+
+  printf("%-16s %s after %u generations (%lu slab evictions)\n",
+         "tiled/store", ok ? "OK" : "FAILED", generation,
+         bits_pool->evicted_nb);
+
+  engine_free(&reference);
+  engine_free(&engine);
+  return ok;
+}
+
+// Automatic switching must follow the pattern without changing it: a soup
+// goes tiled, a fleet of gliders flying side by side listed, and losing
+// gliders only leaves the list engine below half the threshold
+//
+
+#define AUTO_FLEET 200      // Gliders of the fleet, 1000 cells
+#define AUTO_FLEET_GAP 128 // Columns between two gliders
+
+// The fleet stays within 32-bit coordinates
+static void collect_cell(void *const ctx, i64 x, i64 y) {
+  arrput(*(CellKey **)ctx, cellset_key((i32)x, (i32)y));
+}
+
+// Steps both engines for generations generations, engine in one go
+static bool auto_step(Engine *const engine, Engine *const reference,
+                      u64 generations) {
+  bool ok = true;
+  for (u64 done = 0; ok && done < generations;) {
+    const u64 step = engine_step(engine);
+    for (u64 i = 0; i < step; i++) {
+      engine_step(reference);
+    }
+    done += step;
+    ok = engine_equal(engine, reference);
+  }
+  return ok;
+}
+
+// Kills the gliders from the one numbered gliders on. A glider moves by a
+// cell every 4 generations
+static void auto_drop_gliders(Engine *const engine, Engine *const reference,
+                              i32 gliders) {
+  CellKey *cells = NULL;
+  const i32 shift = (i32)(reference->generation / 4);
+  const CellRect64 rect = {.min_x = gliders * AUTO_FLEET_GAP + shift -
+                                    AUTO_FLEET_GAP / 2,
+                           .min_y = INT32_MIN,
+                           .max_x = INT32_MAX,
+                           .max_y = INT32_MAX};
+  engine_foreach_cell(reference, rect, &collect_cell, &cells);
+  for (u64 i = 0; i < arrlenu(cells); i++) {
+    engine_set_cell(engine, cellset_key_x(cells[i]), cellset_key_y(cells[i]),
+                    false);
+    engine_set_cell(reference, cellset_key_x(cells[i]),
+                    cellset_key_y(cells[i]), false);
+  }
+  arrfree(cells);
+}
+
+static bool check_automatic(void) {
+  Engine reference = {0};
+  Engine engine = {0};
+  engine_set_automatic(&engine, true);
+
+  seed_soup(&reference, 11);
+  seed_soup(&engine, 11);
+  bool ok = auto_step(&engine, &reference, GENERATIONS) &&
+            engine.kind == engine_tiled && engine.automatic.switch_nb == 1;
+  printf("%-16s %s %s after %u generations (%.1lf cells/tile)\n",
+         "auto/soup", ok ? "OK" : "FAILED", engine_kind_name(engine.kind),
+         GENERATIONS, engine.automatic.fill);
+
+  engine_free(&reference);
+  engine_free(&engine);
+  engine_set_automatic(&engine, true);
+
+  // The gliders fly south east side by side, each in tiles of its own
+  const i32 glider[5][2] = {{1, 0}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+  for (i32 i = 0; i < AUTO_FLEET; i++) {
+    for (u32 j = 0; j < 5; j++) {
+      engine_set_cell(&reference, i * AUTO_FLEET_GAP + glider[j][0],
+                      glider[j][1], true);
+      engine_set_cell(&engine, i * AUTO_FLEET_GAP + glider[j][0],
+                      glider[j][1], true);
+    }
+  }
+  bool fleet_ok = auto_step(&engine, &reference, 2 * ENGINE_AUTO_INTERVAL) &&
+                  engine.kind == engine_list &&
+                  engine.automatic.switch_nb == 1;
+
+  // 400 cells, between half the threshold & the threshold
+  auto_drop_gliders(&engine, &reference, 80);
+  fleet_ok &= auto_step(&engine, &reference, 2 * ENGINE_AUTO_INTERVAL) &&
+              engine.kind == engine_list && engine.automatic.switch_nb == 1;
+
+  // 200 cells
+  auto_drop_gliders(&engine, &reference, 40);
+  fleet_ok &= auto_step(&engine, &reference, 2 * ENGINE_AUTO_INTERVAL) &&
+              engine.kind == engine_sparse &&
+              engine.automatic.switch_nb == 2 &&
+              engine.automatic.from == engine_list;
+
+  // Only hashlife skips generations
+  engine_set_step_exp(&engine, 3);
+  fleet_ok &= auto_step(&engine, &reference, 2 * ENGINE_AUTO_INTERVAL) &&
+              engine.kind == engine_hashlife;
+  printf("%-16s %s %s after %lu switches (%lu cells)\n", "auto/fleet",
+         fleet_ok ? "OK" : "FAILED", engine_kind_name(engine.kind),
+         engine.automatic.switch_nb, engine_population(&engine));
+
+  engine_free(&reference);
+  engine_free(&engine);
+  return ok && fleet_ok;
+}
+
+// Bounded universes against a naive reference that wraps every neighbour
+//
+
+// Cell (x, y) of the width x height reference, x & y at most 1 cell past the
+// edges
+static u8 bounded_cell(const u8 *const cells, BitGridTopology topology,
+                       i32 width, i32 height, i32 x, i32 y) {
+  if (y < 0 || y >= height) {
+    if (topology == bitgrid_plane) {
+      return 0;
+    }
+    x = topology == bitgrid_klein ? width - 1 - x : x;
+    y = (y + height) % height;
+  }
+  if (x < 0 || x >= width) {
+    if (topology == bitgrid_plane) {
+      return 0;
+    }
+    x = (x + width) % width;
+  }
+  return cells[y * width + x];
+}
+
+static bool check_bounded(BitGridTopology topology, u32 width, u32 height,
+                          const char *const rule_str, ThreadPool *const pool,
+                          u32 generations) {
+  Rule rule;
+  rule_parse(rule_str, &rule);
+  rule = rule_resolve(rule);
+
+  const i32 w = (i32)width, h = (i32)height;
+  u8 *cells = calloc(width * height, 1);
+  u8 *next = calloc(width * height, 1);
+
+  Engine engine = {.pool = pool};
+  engine_set_rule(&engine, rule);
+  // Cells out of the bounds are dropped
+  engine_set_cell(&engine, -1, 0, true);
+  engine_set_cell(&engine, w, h, true);
+  engine_set_bounds(&engine, topology, width, height);
+  engine_set_cell(&engine, 0, -1, true);
+  engine_set_cell(&engine, w, 0, true);
+
+  srand(topology + width + height);
+  for (i32 y = 0; y < h; y++) {
+    for (i32 x = 0; x < w; x++) {
+      cells[y * w + x] = rand() % 3 == 0;
+      engine_set_cell(&engine, x, y, cells[y * w + x]);
+    }
+  }
+
+  u32 generation = 0;
+  for (; generation < generations; generation++) {
+    u64 population = 0;
+    bool same = true;
+    for (i32 y = 0; y < h; y++) {
+      for (i32 x = 0; x < w; x++) {
+        same &= engine_get_cell(&engine, x, y) == cells[y * w + x];
+        population += cells[y * w + x];
+      }
+    }
+    if (!same || engine_population(&engine) != population) {
+      break;
+    }
+
+    for (i32 y = 0; y < h; y++) {
+      for (i32 x = 0; x < w; x++) {
+        u32 neighbourhood = 0;
+        for (i32 j = 0; j < 9; j++) {
+          neighbourhood |= (u32)bounded_cell(cells, topology, w, h,
+                                             x + j % 3 - 1, y + j / 3 - 1)
+                           << j;
+        }
+        next[y * w + x] = rule_next_neighbourhood(rule, neighbourhood);
+      }
+    }
+    u8 *const swap = cells;
+    cells = next;
+    next = swap;
+    engine_step(&engine);
+  }
+
+  char label[48];
+  snprintf(label, sizeof(label), "bounded/%s %ux%u %s",
+           bitgrid_topology_name(topology), width, height, rule_str);
+  bool ok = generation == generations;
+  printf("%-16s %s after %u generations (%lu cells)\n", label,
+         ok ? "OK" : "FAILED", generation, engine_population(&engine));
+
+  // Hashes updated along the steps are the ones of the same cells set from
+  // scratch
+  const u64 hash = engine_hash(&engine);
+  engine_set_kind(&engine, engine_sparse);
+  engine_set_bounds(&engine, topology, width, height);
+  if (engine_hash(&engine) != hash) {
+    printf("%-16s FAILED migration\n", label);
+    ok = false;
+  }
+
+  engine_free(&engine);
+  free(cells);
+  free(next);
+  return ok;
+}
+
+static bool check_rule_parse(void) {
+  const char *const valid[][2] = {
+      {"B3/S23", "B3/S23"},     {"s23/b36", "B36/S23"},
+      {"life", "B3/S23"},       {"daynight", "B3678/S34678"},
+      {"seeds", "B2/S"},        {"B/S012345678", "B/S012345678"},
+      {"brain", "B2/S/C3"},     {"C4/B2/S345", "B2/S345/C4"},
+      {"B3/S23/C2", "B3/S23"},  {"wireworld", "wireworld"},
+      {"bosco", "R5,C0,M1,S34..58,B34..45,NM"},
+      {"r2,b3..5,s2..4", "R2,C0,M0,S2..4,B3..5,NM"},
+      {"B2-a/S12", "B2-a/S12"},
+      {"s2-i34q/b3", "B3/S2-i34q"},
+      {"B2ak3-k/S2-i34q/C5", "B2ka3-k/S2-i34q/C5"},
+      {"B1ce2cekain3cekainyqjr4cekainyqjrtwz/S5cekainyqjr6cekain7ce8",
+       "B1234/S5678"},
+      {"B4cekainyqjrtw/S", "B4-z/S"},
+  };
+  const char *const invalid[] = {"B0/S23", "B3/S239", "B3S23", "B/S",
+                                 "B3/B23", "B3/S23/", "",       "hello",
+                                 "B2/S/C1", "B2/S/C256", "B2/C3/C3",
+                                 "R1,S2..3,B3..3,NN", "R1,S2..3,B0..3",
+                                 "R1,S2..3,B3..9", "R1,M1,S2..10,B3..3",
+                                 "R65,S2..3,B3..3", "R1,S3..2,B3..3",
+                                 "R1,S2..3", "R1,S2..3,B3..3,",
+                                 "B2x/S", "B2-/S", "B8c/S", "B1k/S2",
+                                 "B2aa/S", "B0c/S2", "B3/S2-a-i"};
+  bool ok = true;
+
+  for (u32 i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+    Rule rule;
+    char str[RULE_STR_SIZE];
+    ok &= rule_parse(valid[i][0], &rule);
+    rule_format(rule, str);
+    ok &= !strcmp(str, valid[i][1]);
+  }
+  for (u32 i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    Rule rule;
+    ok &= !rule_parse(invalid[i], &rule);
+  }
+
+  printf("%-16s %s\n", "rule/parse", ok ? "OK" : "FAILED");
+  return ok;
+}
+
+// Points of random sets found in random rects through their Morton codes are
+// the ones a scan finds, in code order
+#define MORTON_SIDE 40
+#define MORTON_POINTS 300
+
+typedef struct MortonCtx {
+  u64 last;
+  u64 count;
+  bool sorted;
+} MortonCtx;
+
+static void morton_point(void *const ctx, i32 x, i32 y) {
+  MortonCtx *const morton = (MortonCtx *)ctx;
+  const u64 code = morton_encode(x, y);
+  morton->sorted &= !morton->count || code >= morton->last;
+  morton->last = code;
+  morton->count += 1;
+}
+
+static bool check_morton(void) {
+  bool ok = true;
+  u64 codes[MORTON_POINTS], tmp[MORTON_POINTS];
+  i32 points[MORTON_POINTS][2];
+
+  srand(18);
+  for (u32 set = 0; set < 50; set++) {
+    for (u32 i = 0; i < MORTON_POINTS; i++) {
+      points[i][0] = rand() % MORTON_SIDE - MORTON_SIDE / 2;
+      points[i][1] = rand() % MORTON_SIDE - MORTON_SIDE / 2;
+      codes[i] = morton_encode(points[i][0], points[i][1]);
+      ok &= morton_x(codes[i]) == points[i][0] &&
+            morton_y(codes[i]) == points[i][1];
+    }
+    radix_sort(codes, tmp, MORTON_POINTS);
+
+    // Duplicates are walked once each
+    for (u32 r = 0; r < 20; r++) {
+      CellRect rect = {.min_x = rand() % MORTON_SIDE - MORTON_SIDE / 2,
+                       .min_y = rand() % MORTON_SIDE - MORTON_SIDE / 2};
+      rect.max_x = rect.min_x + rand() % (MORTON_SIDE / 2);
+      rect.max_y = rect.min_y + rand() % (MORTON_SIDE / 2);
+
+      u64 expected = 0;
+      for (u32 i = 0; i < MORTON_POINTS; i++) {
+        expected += cellrect_contains(rect, morton_x(codes[i]),
+                                      morton_y(codes[i]));
+      }
+      MortonCtx morton = {.sorted = true};
+      morton_foreach(codes, MORTON_POINTS, rect, &morton_point, &morton);
+      ok &= morton.count == expected && morton.sorted;
+    }
+  }
+
+  printf("%-16s %s\n", "morton", ok ? "OK" : "FAILED");
+  return ok;
+}
+
+int main(void) {
+  int failures = 0;
+
+  kernel_init();
+
+  // Bounded universes have their own checks
+  for (u32 kind = 0; kind < engine_bounded; kind++) {
+    failures += !cross_check((EngineKind)kind, NULL,
+                             engine_kind_name((EngineKind)kind), kind + 1);
+    failures += !check_rect((EngineKind)kind);
+    failures += !check_step_n((EngineKind)kind);
+    failures += !check_cycle((EngineKind)kind);
+    failures += !check_escape((EngineKind)kind);
+  }
+
+  failures += !check_rule_parse();
+  failures += !check_morton();
+  const char *const rules[] = {"highlife", "daynight", "seeds", "B34/S34",
+                               "B36/S125", "B3/S2-i34q"};
+  for (u32 kind = engine_tiled; kind < engine_bounded; kind++) {
+    for (u32 i = 0; i < sizeof(rules) / sizeof(rules[0]); i++) {
+      failures += !check_rule((EngineKind)kind, rules[i], 100);
+    }
+  }
+  for (u32 kind = 0; kind < engine_bounded; kind++) {
+    failures += !check_isotropic((EngineKind)kind, "B2ek3-k/S12ai3", false);
+    failures += !check_isotropic((EngineKind)kind, "B2ek3-k/S12ai3", true);
+  }
+
+  const char *const state_rules[] = {"brain",     "starwars",
+                                     "B3/S23/C8", "wireworld",
+                                     "B36/S23",   "B2-a3i/S23/C3",
+                                     "B3/S2-i34q"};
+  for (u32 i = 0; i < sizeof(state_rules) / sizeof(state_rules[0]); i++) {
+    char label[32];
+    snprintf(label, sizeof(label), "states/%s", state_rules[i]);
+    failures += !check_states(state_rules[i], NULL, label, 100);
+  }
+  // Larger than Life: the naive reference counts (2R + 1)^2 cells
+  const char *const range_rules[] = {"bosco", "R1,C0,M0,S2..3,B3..3,NM",
+                                     "R3,C4,M0,S8..16,B9..14,NM",
+                                     "R20,C0,M1,S500..1100,B450..700,NM"};
+  const u32 range_generations[] = {40, 40, 40, 5};
+  for (u32 i = 0; i < sizeof(range_rules) / sizeof(range_rules[0]); i++) {
+    char label[48];
+    snprintf(label, sizeof(label), "states/%s", range_rules[i]);
+    failures +=
+        !check_states(range_rules[i], NULL, label, range_generations[i]);
+  }
+  failures += !check_wireworld();
+  failures += !check_render();
+  failures += !check_list_spread();
+  failures += !check_islands(NULL, "islands/spread");
+  failures += !check_islands_migrate();
+
+  // Short last bands, single word rows & a single row
+  for (u32 topology = 0; topology < bitgrid_topology_count; topology++) {
+    failures += !check_bounded((BitGridTopology)topology, 128, 100, "life",
+                               NULL, 100);
+    failures += !check_bounded((BitGridTopology)topology, 64, 70,
+                               "B3/S2-i34q", NULL, 100);
+    failures += !check_bounded((BitGridTopology)topology, 192, 1, "B1/S12",
+                               NULL, 20);
+  }
+
+  failures += !check_arena();
+  failures += !check_settled();
+  failures += !check_tile_pool(engine_tiled);
+  failures += !check_tile_pool(engine_states);
+  failures += !check_automatic();
+  failures += !check_store();
+
+  for (u32 step_exp = 1; step_exp <= 6; step_exp++) {
+    failures += !check_step_exp(step_exp, 4);
+  }
+  failures += !check_far();
+  failures += !check_rim();
+  failures += !check_step_limit();
+  for (u32 kind = 0; kind < engine_bounded; kind++) {
+    if (kind != engine_hashlife) {
+      failures += !check_edge((EngineKind)kind);
+    }
+  }
+
+  // Every kernel this CPU supports must match the sparse engine too
+  const KernelKind best = kernel_selected();
+  for (u32 kind = 0; kind < kernel_kind_count; kind++) {
+    if (kernel_select((KernelKind)kind)) {
+      char label[32];
+      snprintf(label, sizeof(label), "tiled/%s", kernel_name((KernelKind)kind));
+      failures += !cross_check(engine_tiled, NULL, label, 42);
+      snprintf(label, sizeof(label), "states/%s",
+               kernel_name((KernelKind)kind));
+      failures += !check_states("brain", NULL, label, 100);
+      failures += !check_states("B2-a3i/S23/C3", NULL, label, 100);
+      failures += !check_rule(engine_tiled, "B3/S2-i34q", 100);
+    }
+  }
+  kernel_select(best);
+
+  // Results must not depend on the number of threads
+  const u32 thread_nbs[] = {1, 2, 3, 8, 0};
+  for (u32 i = 0; i < sizeof(thread_nbs) / sizeof(thread_nbs[0]); i++) {
+    Error err = {0};
+    ThreadPool pool;
+    pool_create(&pool, thread_nbs[i], &err);
+    if (err.status) {
+      printf("Could not create pool: %s\n", err.msg);
+      return EXIT_FAILURE;
+    }
+
+    char label[32];
+    snprintf(label, sizeof(label), "tiled/%u threads", pool_thread_nb(&pool));
+    failures += !cross_check(engine_tiled, &pool, label, 42);
+    snprintf(label, sizeof(label), "sparse/%u threads", pool_thread_nb(&pool));
+    failures += !cross_check(engine_sparse, &pool, label, 42);
+    snprintf(label, sizeof(label), "islands/%u threads",
+             pool_thread_nb(&pool));
+    failures += !check_islands(&pool, label);
+    snprintf(label, sizeof(label), "states/%u threads", pool_thread_nb(&pool));
+    failures += !check_states("brain", &pool, label, 100);
+    failures += !check_bounded(bitgrid_klein, 320, 300, "life", &pool, 100);
+
+    pool_destroy(&pool);
+  }
+
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+#define MAX_TASKS 10000
+#define JOBS 100
+
+typedef struct Job {
+  atomic_uint runs[MAX_TASKS];           // Times each task ran
+  atomic_uint workers[POOL_MAX_THREADS]; // Tasks run by each worker
+  u32 thread_nb;
+  bool bad_worker;
+} Job;
+
+static Job job;
+
+static void run_task(void *const ctx, u32 worker, u32 task) {
+  Job *const self = (Job *)ctx;
+  if (worker >= self->thread_nb) {
+    self->bad_worker = true;
+    return;
+  }
+  atomic_fetch_add(&self->runs[task], 1);
+  atomic_fetch_add(&self->workers[worker], 1);
+
+  // Uneven task lengths, so workers run out of tasks and steal
+  volatile u32 spin = 0;
+  for (u32 i = 0; i < (task % 7) * 100; i++) {
+    spin += i;
+  }
+}
+
+int main(void) {
+  int failures = 0;
+  const u32 thread_nbs[] = {1, 2, 3, 8, 0};
+
+  srand(42);
+
+  for (u32 t = 0; t < sizeof(thread_nbs) / sizeof(thread_nbs[0]); t++) {
+    Error err = {0};
+    ThreadPool pool;
+    pool_create(&pool, thread_nbs[t], &err);
+    if (err.status) {
+      printf("Could not create pool: %s\n", err.msg);
+      return EXIT_FAILURE;
+    }
+    job.thread_nb = pool_thread_nb(&pool);
+
+    // Every task of every job must run exactly once
+    u64 stolen = 0;
+    for (u32 j = 0; j < JOBS; j++) {
+      const u32 task_nb = j < 4 ? j : (u32)rand() % MAX_TASKS;
+      for (u32 i = 0; i < MAX_TASKS; i++) {
+        atomic_store(&job.runs[i], 0);
+      }
+      for (u32 i = 0; i < POOL_MAX_THREADS; i++) {
+        atomic_store(&job.workers[i], 0);
+      }
+
+      pool_run(&pool, task_nb, &run_task, &job);
+
+      for (u32 i = 0; i < MAX_TASKS; i++) {
+        const u32 expected = i < task_nb;
+        if (atomic_load(&job.runs[i]) != expected) {
+          printf("%u threads, %u tasks: task %u ran %u times\n",
+                 job.thread_nb, task_nb, i, atomic_load(&job.runs[i]));
+          failures++;
+          break;
+        }
+      }
+
+      // Tasks run by other workers than the initial split
+      for (u32 i = 0; i < job.thread_nb; i++) {
+        const u32 split = (u32)((u64)task_nb * (i + 1) / job.thread_nb -
+                                (u64)task_nb * i / job.thread_nb);
+        const u32 ran = atomic_load(&job.workers[i]);
+        stolen += ran > split ? ran - split : 0;
+      }
+    }
+
+    if (job.bad_worker) {
+      printf("%u threads: worker index out of range\n", job.thread_nb);
+      failures++;
+    }
+    printf("%u threads: %lu tasks stolen\n", job.thread_nb, stolen);
+
+    pool_destroy(&pool);
+  }
+
+  // No pool runs everything on the calling thread
+  job.thread_nb = 1;
+  for (u32 i = 0; i < MAX_TASKS; i++) {
+    atomic_store(&job.runs[i], 0);
+  }
+  pool_run(NULL, MAX_TASKS, &run_task, &job);
+  for (u32 i = 0; i < MAX_TASKS; i++) {
+    if (atomic_load(&job.runs[i]) != 1) {
+      printf("No pool: task %u ran %u times\n", i, atomic_load(&job.runs[i]));
+      failures++;
+      break;
+    }
+  }
+
+  printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}